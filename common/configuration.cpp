@@ -201,6 +201,35 @@ int Configuration::recv_retries() const { return config_.recv_retries() == 0 ? 1
 
 internal::ExecutionType Configuration::execution_type() const { return config_.execution_type(); }
 
+internal::StorageType Configuration::storage_type() const { return config_.storage_type(); }
+
+string Configuration::log_storage_dir() const {
+  return config_.log_storage_dir().empty() ? "slog_storage" : config_.log_storage_dir();
+}
+
+std::chrono::microseconds Configuration::log_storage_group_commit_window() const {
+  return std::chrono::microseconds(config_.log_storage_group_commit_us());
+}
+
+uint64_t Configuration::log_storage_compaction_bytes() const {
+  return config_.log_storage_compaction_bytes() == 0 ? (1ULL << 30) : config_.log_storage_compaction_bytes();
+}
+
+uint32_t Configuration::num_lock_manager_shards() const { return std::max(config_.num_lock_manager_shards(), 1U); }
+
+bool Configuration::snapshot_read_only_txns() const { return config_.snapshot_read_only_txns(); }
+
+uint32_t Configuration::contention_sample_rate() const { return config_.contention_sample_rate(); }
+
+milliseconds Configuration::ddr_interval() const {
+  if (config_.ddr_interval() == 0) {
+    return 10ms;
+  }
+  return milliseconds(config_.ddr_interval());
+}
+
+bool Configuration::early_lock_release() const { return config_.early_lock_release(); }
+
 const vector<uint32_t> Configuration::replication_order() const { return replication_order_; }
 
 bool Configuration::synchronized_batching() const { return config_.synchronized_batching(); }
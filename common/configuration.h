@@ -60,6 +60,15 @@ class Configuration {
   bool return_dummy_txn() const;
   int recv_retries() const;
   internal::ExecutionType execution_type() const;
+  internal::StorageType storage_type() const;
+  std::string log_storage_dir() const;
+  std::chrono::microseconds log_storage_group_commit_window() const;
+  uint64_t log_storage_compaction_bytes() const;
+  uint32_t num_lock_manager_shards() const;
+  bool snapshot_read_only_txns() const;
+  uint32_t contention_sample_rate() const;
+  std::chrono::milliseconds ddr_interval() const;
+  bool early_lock_release() const;
   const std::vector<uint32_t> replication_order() const;
   bool synchronized_batching() const;
   uint32_t sample_rate() const;
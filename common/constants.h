@@ -29,6 +29,14 @@ const uint32_t kPaxosDefaultLeaderPosition = 0;
 
 const size_t kLockTableSizeLimit = 1000000;
 
+// Number of txns that can be queued in each direction between the scheduler and a worker
+const size_t kWorkerQueueCapacity = 1 << 14;
+// A txn is dispatched to the worker that last ran txns with the same keys unless that
+// worker has this many txns queued, in which case the least loaded worker is used
+const size_t kWorkerAffinityMaxBacklog = 4;
+// Number of slots of the table mapping keys to the worker that last ran them
+const size_t kWorkerAffinitySlots = 1 << 16;
+
 /****************************
  *      Statistic Keys
  ****************************/
@@ -55,12 +63,19 @@ const char SEQ_BATCH_DURATION_MS_PCTLS[] = "seq_batch_duration_ms_pctls";
 /* Scheduler */
 const char ALL_TXNS[] = "all_txns";
 const char NUM_ALL_TXNS[] = "num_all_txns";
+const char NUM_POOLED_TXN_HOLDERS[] = "num_pooled_txn_holders";
 const char NUM_LOCKED_KEYS[] = "num_locked_keys";
 const char LOCK_MANAGER_TYPE[] = "lock_manager_type";
 const char NUM_TXNS_WAITING_FOR_LOCK[] = "num_txns_waiting_for_lock";
 const char NUM_WAITING_FOR_PER_TXN[] = "num_waiting_for_per_txn";
 const char LOCK_TABLE[] = "lock_table";
 const char WAITED_BY_GRAPH[] = "waited_by_graph";
+const char CONTENTION[] = "contention";
+const char NUM_DEADLOCKS_RESOLVED[] = "num_deadlocks_resolved";
+const char TOTAL_DEADLOCK_STALL_US[] = "total_deadlock_stall_us";
+const char MAX_DEADLOCK_STALL_US[] = "max_deadlock_stall_us";
+const char NUM_AFFINITY_HITS[] = "num_affinity_hits";
+const char NUM_STEALS[] = "num_steals";
 const char TXN_ID[] = "id";
 const char TXN_DONE[] = "done";
 const char TXN_ABORTING[] = "aborting";
@@ -0,0 +1,49 @@
+#include "common/contention_sketch.h"
+
+#include <algorithm>
+
+namespace slog {
+
+ContentionSketch::ContentionSketch(size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {
+  counters_.reserve(capacity_);
+  index_.reserve(capacity_);
+}
+
+void ContentionSketch::Record(const KeyReplica& key_replica, uint32_t queue_length, int64_t wait_ns) {
+  KeyContention* counter;
+  if (auto it = index_.find(key_replica); it != index_.end()) {
+    counter = &counters_[it->second];
+  } else if (counters_.size() < capacity_) {
+    index_.emplace(key_replica, counters_.size());
+    counter = &counters_.emplace_back();
+    counter->key_replica = key_replica;
+  } else {
+    // Evict the key with the smallest count. The sketch is only updated for sampled txns
+    // so a linear scan is cheap enough here
+    auto min_it = std::min_element(counters_.begin(), counters_.end(),
+                                   [](const auto& a, const auto& b) { return a.num_blocked < b.num_blocked; });
+    auto min_idx = min_it - counters_.begin();
+    index_.erase(min_it->key_replica);
+    index_.emplace(key_replica, min_idx);
+    auto min_count = min_it->num_blocked;
+    *min_it = KeyContention{key_replica, min_count, min_count, 0, 0};
+    counter = &*min_it;
+  }
+  counter->num_blocked++;
+  counter->total_queue_length += queue_length;
+  counter->total_wait_ns += std::max<int64_t>(wait_ns, 0);
+}
+
+std::vector<KeyContention> ContentionSketch::TopK(size_t k) const {
+  std::vector<KeyContention> top(counters_);
+  auto cmp = [](const auto& a, const auto& b) { return a.num_blocked > b.num_blocked; };
+  if (k < top.size()) {
+    std::partial_sort(top.begin(), top.begin() + k, top.end(), cmp);
+    top.resize(k);
+  } else {
+    std::sort(top.begin(), top.end(), cmp);
+  }
+  return top;
+}
+
+}  // namespace slog
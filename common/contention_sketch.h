@@ -0,0 +1,51 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "common/types.h"
+
+namespace slog {
+
+struct KeyContention {
+  KeyReplica key_replica;
+  // Number of blocked txns counted for this key. It overestimates the true count by at most error
+  uint64_t num_blocked = 0;
+  uint64_t error = 0;
+  // Sums over the last (num_blocked - error) blocked txns, which are the ones seen since the key
+  // entered the sketch
+  uint64_t total_queue_length = 0;
+  uint64_t total_wait_ns = 0;
+};
+
+/**
+ * A space-saving top-K sketch of the keys that block txns the most. It keeps a fixed number
+ * of counters. When a key that is not tracked arrives and all counters are taken, the key
+ * replaces the key with the smallest count and inherits that count as its error. Any key
+ * blocking more than 1/capacity of all recorded txns is guaranteed to be tracked.
+ */
+class ContentionSketch {
+ public:
+  explicit ContentionSketch(size_t capacity = 128);
+
+  /**
+   * Counts one txn that was blocked on a key
+   *
+   * @param key_replica  The key that the txn waited for
+   * @param queue_length Number of txns ahead of the blocked txn in the lock queue of the key
+   * @param wait_ns      Time the txn spent waiting for the key
+   */
+  void Record(const KeyReplica& key_replica, uint32_t queue_length, int64_t wait_ns);
+
+  // Returns up to k keys with the highest num_blocked, in descending order
+  std::vector<KeyContention> TopK(size_t k) const;
+
+  size_t capacity() const { return capacity_; }
+
+ private:
+  size_t capacity_;
+  std::vector<KeyContention> counters_;
+  std::unordered_map<KeyReplica, size_t, KeyReplicaHash> index_;
+};
+
+}  // namespace slog
@@ -67,6 +67,11 @@ time_point_t MetricsRepository::RecordTxnEvent(TransactionEvent event) {
   return txn_event_metrics_->RecordEvent(event);
 }
 
+void MetricsRepository::RecordKeyContention(const KeyReplica& key_replica, uint32_t queue_length, int64_t wait_ns) {
+  std::lock_guard<SpinLatch> guard(latch_);
+  contention_sketch_.Record(key_replica, queue_length, wait_ns);
+}
+
 std::unique_ptr<TransactionEventMetrics> MetricsRepository::Reset() {
   auto new_txn_event_metrics =
       std::make_unique<TransactionEventMetrics>(sample_mask_, config_->local_replica(), config_->local_partition());
@@ -75,6 +80,13 @@ std::unique_ptr<TransactionEventMetrics> MetricsRepository::Reset() {
   return new_txn_event_metrics;
 }
 
+ContentionSketch MetricsRepository::ResetContention() {
+  ContentionSketch new_contention_sketch;
+  std::lock_guard<SpinLatch> guard(latch_);
+  std::swap(contention_sketch_, new_contention_sketch);
+  return new_contention_sketch;
+}
+
 thread_local std::shared_ptr<MetricsRepository> per_thread_metrics_repo;
 
 /**
@@ -106,17 +118,29 @@ void MetricsRepositoryManager::AggregateAndFlushToDisk(const std::string& dir) {
 
     CSVWriter txn_events_csv(dir + "/events.csv", {"event", "time", "partition", "replica"});
 
+    CSVWriter contention_csv(dir + "/contention.csv", {"key", "master", "num_blocked", "error", "total_queue_length",
+                                                       "total_wait_ns", "partition", "replica"});
+
     std::list<TransactionEventMetrics::Data> txn_events_data;
+    std::vector<KeyContention> contention_data;
     std::lock_guard<std::mutex> guard(mut_);
     for (auto& kv : metrics_repos_) {
       auto metrics = kv.second->Reset();
       txn_events_data.splice(txn_events_data.end(), metrics->data());
+      auto sketch = kv.second->ResetContention();
+      auto top_keys = sketch.TopK(sketch.capacity());
+      contention_data.insert(contention_data.end(), top_keys.begin(), top_keys.end());
     }
 
     for (const auto& data : txn_events_data) {
       txn_events_csv << ENUM_NAME(data.event, TransactionEvent) << data.time << data.partition << data.replica
                      << csvendl;
     }
+    for (const auto& data : contention_data) {
+      contention_csv << data.key_replica.key << data.key_replica.replica << data.num_blocked << data.error
+                     << data.total_queue_length << data.total_wait_ns << config_->local_partition()
+                     << config_->local_replica() << csvendl;
+    }
     LOG(INFO) << "Metrics written to: \"" << dir << "/\"";
   } catch (std::runtime_error& e) {
     LOG(ERROR) << e.what();
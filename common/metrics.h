@@ -8,6 +8,7 @@
 #include <vector>
 
 #include "common/configuration.h"
+#include "common/contention_sketch.h"
 #include "common/spin_latch.h"
 #include "proto/transaction.pb.h"
 
@@ -26,7 +27,9 @@ class MetricsRepository {
   MetricsRepository(const ConfigurationPtr& config, const sample_mask_t& sample_mask);
 
   std::chrono::system_clock::time_point RecordTxnEvent(TransactionEvent event);
+  void RecordKeyContention(const KeyReplica& key_replica, uint32_t queue_length, int64_t wait_ns);
   std::unique_ptr<TransactionEventMetrics> Reset();
+  ContentionSketch ResetContention();
 
  private:
   const ConfigurationPtr config_;
@@ -34,6 +37,7 @@ class MetricsRepository {
   SpinLatch latch_;
 
   std::unique_ptr<TransactionEventMetrics> txn_event_metrics_;
+  ContentionSketch contention_sketch_;
 };
 
 extern thread_local std::shared_ptr<MetricsRepository> per_thread_metrics_repo;
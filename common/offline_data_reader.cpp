@@ -26,24 +26,28 @@ uint32_t OfflineDataReader::GetNumDatums() { return num_datums_; }
 bool OfflineDataReader::HasNextDatum() { return num_read_datums_ < num_datums_; }
 
 Datum OfflineDataReader::GetNextDatum() {
+  std::string buf;
+  GetNextRawDatum(buf);
+
+  Datum datum;
+  // Parse raw bytes into protobuf object
+  datum.ParseFromString(buf);
+
+  return datum;
+}
+
+void OfflineDataReader::GetNextRawDatum(std::string& buf) {
   int sz;
   // Read the size of the next datum
   if (!coded_input_->ReadVarintSizeAsInt(&sz)) {
     LOG(FATAL) << "Error while reading data file";
   }
-  std::string buf;
   // Read the datum given the size
   if (!coded_input_->ReadString(&buf, sz)) {
     LOG(FATAL) << "Error while reading data file";
   }
 
-  Datum datum;
-  // Parse raw bytes into protobuf object
-  datum.ParseFromString(buf);
-
   num_read_datums_++;
-
-  return datum;
 }
 
 }  // namespace slog
\ No newline at end of file
@@ -15,6 +15,8 @@ class OfflineDataReader {
   uint32_t GetNumDatums();
   bool HasNextDatum();
   Datum GetNextDatum();
+  // Reads the serialized bytes of the next datum without parsing them
+  void GetNextRawDatum(std::string& buf);
 
  private:
   google::protobuf::io::ZeroCopyInputStream* raw_input_;
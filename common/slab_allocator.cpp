@@ -0,0 +1,162 @@
+#include "common/slab_allocator.h"
+
+#include <glog/logging.h>
+
+#include <mutex>
+
+namespace slog {
+
+namespace {
+// Number of slots moved between a thread cache and the shared free list at once
+constexpr size_t kBatchSize = 32;
+}  // namespace
+
+struct SlabAllocator::ThreadCache {
+  ~ThreadCache() {
+    for (size_t cls = 0; cls < kNumClasses; cls++) {
+      if (heads[cls] == nullptr) {
+        continue;
+      }
+      auto tail = heads[cls];
+      while (tail->next != nullptr) {
+        tail = tail->next;
+      }
+      SlabAllocator::Default().Release(cls, heads[cls], tail);
+    }
+  }
+
+  FreeSlot* heads[kNumClasses] = {};
+  size_t counts[kNumClasses] = {};
+};
+
+SlabAllocator& SlabAllocator::Default() {
+  // Never destroyed so that records outliving static destruction can still be freed
+  static auto allocator = new SlabAllocator();
+  return *allocator;
+}
+
+SlabAllocator::SlabAllocator() {
+  for (size_t cls = 0; cls < kNumClasses; cls++) {
+    classes_[cls].slot_size = ClassSize(cls);
+  }
+}
+
+SlabAllocator::ThreadCache& SlabAllocator::Cache() {
+  static thread_local ThreadCache cache;
+  return cache;
+}
+
+// Sizes from 16 to 128 bytes are spaced by 16 bytes. Beyond that, there are
+// four classes between two consecutive powers of two
+size_t SlabAllocator::ClassOf(size_t size) {
+  DCHECK(size > 0 && size <= kMaxClassSize);
+  if (size <= 128) {
+    return (size + 15) / 16 - 1;
+  }
+  auto s = size - 1;
+  size_t msb = 63 - __builtin_clzll(s);
+  return 8 + (msb - 7) * 4 + ((s >> (msb - 2)) & 3);
+}
+
+size_t SlabAllocator::ClassSize(size_t cls) {
+  if (cls < 8) {
+    return (cls + 1) * 16;
+  }
+  auto k = cls - 8;
+  auto msb = 7 + k / 4;
+  return (1ULL << msb) + (k % 4 + 1) * (1ULL << (msb - 2));
+}
+
+char* SlabAllocator::Allocate(size_t size) {
+  if (size == 0) {
+    return nullptr;
+  }
+  if (size > kMaxClassSize) {
+    return new char[size];
+  }
+  auto cls = ClassOf(size);
+  auto& cache = Cache();
+  if (cache.heads[cls] == nullptr) {
+    cache.counts[cls] = Refill(cls, cache.heads[cls], kBatchSize);
+  }
+  auto slot = cache.heads[cls];
+  cache.heads[cls] = slot->next;
+  cache.counts[cls]--;
+  return reinterpret_cast<char*>(slot);
+}
+
+void SlabAllocator::Deallocate(char* ptr, size_t size) {
+  if (ptr == nullptr) {
+    return;
+  }
+  if (size > kMaxClassSize) {
+    delete[] ptr;
+    return;
+  }
+  auto cls = ClassOf(size);
+  auto& cache = Cache();
+  auto slot = reinterpret_cast<FreeSlot*>(ptr);
+  slot->next = cache.heads[cls];
+  cache.heads[cls] = slot;
+  cache.counts[cls]++;
+
+  // Give a batch of slots back to the shared list so that slots freed by
+  // one thread can be reused by the others
+  if (cache.counts[cls] >= 2 * kBatchSize) {
+    auto head = cache.heads[cls];
+    auto tail = head;
+    for (size_t i = 1; i < kBatchSize; i++) {
+      tail = tail->next;
+    }
+    cache.heads[cls] = tail->next;
+    cache.counts[cls] -= kBatchSize;
+    Release(cls, head, tail);
+  }
+}
+
+size_t SlabAllocator::Refill(size_t cls, FreeSlot*& head, size_t n) {
+  auto& size_class = classes_[cls];
+  std::lock_guard<SpinLatch> guard(size_class.latch);
+
+  size_t count = 0;
+  while (count < n && size_class.free_list != nullptr) {
+    auto slot = size_class.free_list;
+    size_class.free_list = slot->next;
+    slot->next = head;
+    head = slot;
+    count++;
+  }
+
+  while (count < n) {
+    if (size_class.bump_end - size_class.bump < static_cast<ptrdiff_t>(size_class.slot_size)) {
+      size_class.slabs.emplace_back(new char[kSlabSize]);
+      size_class.bump = size_class.slabs.back().get();
+      size_class.bump_end = size_class.bump + kSlabSize;
+    }
+    auto slot = reinterpret_cast<FreeSlot*>(size_class.bump);
+    size_class.bump += size_class.slot_size;
+    slot->next = head;
+    head = slot;
+    count++;
+  }
+
+  return count;
+}
+
+void SlabAllocator::Release(size_t cls, FreeSlot* head, FreeSlot* tail) {
+  auto& size_class = classes_[cls];
+  std::lock_guard<SpinLatch> guard(size_class.latch);
+  tail->next = size_class.free_list;
+  size_class.free_list = head;
+}
+
+size_t SlabAllocator::num_slabs() const {
+  size_t num_slabs = 0;
+  for (const auto& size_class : classes_) {
+    std::lock_guard<SpinLatch> guard(size_class.latch);
+    num_slabs += size_class.slabs.size();
+  }
+  return num_slabs;
+}
+
+}  // namespace slog
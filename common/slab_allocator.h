@@ -0,0 +1,76 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common/spin_latch.h"
+
+namespace slog {
+
+/**
+ * A size-class slab allocator for record values.
+ *
+ * Requests up to kMaxClassSize bytes are rounded up to one of kNumClasses size classes.
+ * Each class carves fixed-size slots out of large slabs and keeps freed slots in a free
+ * list so that they are recycled by later allocations of the same class. Slabs are never
+ * returned to the operating system, which keeps values of similar sizes packed together
+ * and avoids fragmenting the heap on long-running nodes. Larger requests fall back to
+ * the global heap.
+ *
+ * Each thread keeps a small cache of free slots per class, so that most allocations and
+ * deallocations do not touch the shared free lists.
+ */
+class SlabAllocator {
+ public:
+  static constexpr size_t kMaxClassSize = 4096;
+  static constexpr size_t kNumClasses = 28;
+  static constexpr size_t kSlabSize = 1 << 20;
+
+  static SlabAllocator& Default();
+
+  char* Allocate(size_t size);
+  void Deallocate(char* ptr, size_t size);
+
+  // Returns true if a slot allocated for old_size can be reused for new_size
+  static bool FitsSameSlot(size_t old_size, size_t new_size) {
+    if (old_size == 0 || new_size == 0 || old_size > kMaxClassSize || new_size > kMaxClassSize) {
+      return old_size == new_size;
+    }
+    return ClassOf(old_size) == ClassOf(new_size);
+  }
+
+  /* For debugging */
+  size_t num_slabs() const;
+
+ private:
+  struct FreeSlot {
+    FreeSlot* next;
+  };
+
+  struct SizeClass {
+    mutable SpinLatch latch;
+    size_t slot_size = 0;
+    FreeSlot* free_list = nullptr;
+    char* bump = nullptr;
+    char* bump_end = nullptr;
+    std::vector<std::unique_ptr<char[]>> slabs;
+  };
+
+  struct ThreadCache;
+
+  SlabAllocator();
+
+  static size_t ClassOf(size_t size);
+  static size_t ClassSize(size_t cls);
+
+  // Moves up to n slots of a class to the given list, carving new slots if needed
+  size_t Refill(size_t cls, FreeSlot*& head, size_t n);
+  // Returns a list of slots back to a class
+  void Release(size_t cls, FreeSlot* head, FreeSlot* tail);
+
+  static ThreadCache& Cache();
+
+  SizeClass classes_[kNumClasses];
+};
+
+}  // namespace slog
@@ -0,0 +1,158 @@
+#include "common/snapshot.h"
+
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace slog {
+
+using snapshot::DirectoryEntry;
+using snapshot::Header;
+
+namespace {
+
+// Size of each buffer accumulated before being written out
+constexpr size_t kBufferSize = 4 << 20;
+
+void PWriteAll(int fd, const std::string& buf, uint64_t pos, const std::string& path) {
+  size_t written = 0;
+  while (written < buf.size()) {
+    auto res = pwrite(fd, buf.data() + written, buf.size() - written, pos + written);
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG(FATAL) << "Error while writing to \"" << path << "\": " << strerror(errno);
+    }
+    written += res;
+  }
+}
+
+}  // namespace
+
+SnapshotWriter::SnapshotWriter(const std::string& path, uint64_t num_records)
+    : path_(path),
+      num_records_(num_records),
+      num_added_(0),
+      directory_pos_(sizeof(Header)),
+      data_pos_(sizeof(Header) + num_records * sizeof(DirectoryEntry)) {
+  fd_ = open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  if (fd_ < 0) {
+    LOG(FATAL) << "Error while opening \"" << path << "\": " << strerror(errno);
+  }
+}
+
+SnapshotWriter::~SnapshotWriter() { close(fd_); }
+
+void SnapshotWriter::Add(std::string_view key, std::string_view value, const Metadata& metadata) {
+  CHECK_LT(num_added_, num_records_) << "Too many records added to the snapshot";
+  DirectoryEntry entry;
+  entry.offset = data_pos_ + data_buffer_.size() - (sizeof(Header) + num_records_ * sizeof(DirectoryEntry));
+  entry.key_size = key.size();
+  entry.value_size = value.size();
+  entry.master = metadata.master;
+  entry.counter = metadata.counter;
+  directory_buffer_.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+  data_buffer_.append(key);
+  data_buffer_.append(value);
+  num_added_++;
+
+  if (directory_buffer_.size() >= kBufferSize || data_buffer_.size() >= kBufferSize) {
+    FlushBuffers();
+  }
+}
+
+void SnapshotWriter::Finish() {
+  CHECK_EQ(num_added_, num_records_) << "Snapshot is missing records";
+  FlushBuffers();
+
+  Header header;
+  memcpy(header.magic, snapshot::kMagic, sizeof(header.magic));
+  header.version = snapshot::kVersion;
+  header.reserved = 0;
+  header.num_records = num_records_;
+  header.directory_offset = sizeof(Header);
+  header.data_offset = sizeof(Header) + num_records_ * sizeof(DirectoryEntry);
+  header.data_size = data_pos_ - header.data_offset;
+  std::string buf(reinterpret_cast<const char*>(&header), sizeof(header));
+  PWriteAll(fd_, buf, 0, path_);
+
+  if (fsync(fd_) < 0) {
+    LOG(FATAL) << "Error while syncing \"" << path_ << "\": " << strerror(errno);
+  }
+}
+
+void SnapshotWriter::FlushBuffers() {
+  PWriteAll(fd_, directory_buffer_, directory_pos_, path_);
+  directory_pos_ += directory_buffer_.size();
+  directory_buffer_.clear();
+  PWriteAll(fd_, data_buffer_, data_pos_, path_);
+  data_pos_ += data_buffer_.size();
+  data_buffer_.clear();
+}
+
+SnapshotReader::SnapshotReader(const std::string& path) {
+  auto fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(FATAL) << "Error while opening \"" << path << "\": " << strerror(errno);
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    LOG(FATAL) << "Error while reading \"" << path << "\": " << strerror(errno);
+  }
+  size_ = st.st_size;
+  CHECK_GE(size_, sizeof(Header)) << "\"" << path << "\" is too small to be a snapshot";
+
+  addr_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (addr_ == MAP_FAILED) {
+    LOG(FATAL) << "Error while mapping \"" << path << "\": " << strerror(errno);
+  }
+  // The mapping stays valid after the file is closed
+  close(fd);
+
+  auto base = static_cast<const char*>(addr_);
+  header_ = reinterpret_cast<const Header*>(base);
+  CHECK(memcmp(header_->magic, snapshot::kMagic, sizeof(header_->magic)) == 0)
+      << "\"" << path << "\" is not a snapshot";
+  CHECK_EQ(header_->version, snapshot::kVersion) << "Unsupported snapshot version";
+  // The regions must lie within the file in the order of the layout. The subtractions avoid overflowing
+  // on corrupt offsets and sizes
+  CHECK_GE(header_->directory_offset, sizeof(Header)) << "\"" << path << "\" has a corrupt header";
+  CHECK_LE(header_->directory_offset, header_->data_offset) << "\"" << path << "\" has a corrupt header";
+  CHECK_LE(header_->data_offset, size_) << "\"" << path << "\" is truncated";
+  CHECK_EQ(header_->data_size, size_ - header_->data_offset) << "\"" << path << "\" is truncated";
+  CHECK_LE(header_->num_records, (header_->data_offset - header_->directory_offset) / sizeof(DirectoryEntry))
+      << "\"" << path << "\" is truncated";
+
+  directory_ = reinterpret_cast<const DirectoryEntry*>(base + header_->directory_offset);
+  data_ = base + header_->data_offset;
+}
+
+SnapshotReader::~SnapshotReader() { munmap(addr_, size_); }
+
+void SnapshotReader::WillNeed(uint64_t from, uint64_t to) const {
+  to = std::min(to, header_->num_records);
+  if (from >= to) {
+    return;
+  }
+  auto page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  auto advise = [page_size](const char* begin, const char* end) {
+    auto aligned_begin = reinterpret_cast<uintptr_t>(begin) & ~(page_size - 1);
+    madvise(reinterpret_cast<void*>(aligned_begin), reinterpret_cast<uintptr_t>(end) - aligned_begin, MADV_WILLNEED);
+  };
+  advise(reinterpret_cast<const char*>(directory_ + from), reinterpret_cast<const char*>(directory_ + to));
+  // The entries are only a hint here so they are clamped to the data region rather than validated
+  const auto& last = directory_[to - 1];
+  auto data_begin = std::min(directory_[from].offset, header_->data_size);
+  auto data_end = std::min(last.offset + last.key_size + last.value_size, header_->data_size);
+  if (data_begin < data_end) {
+    advise(data_ + data_begin, data_ + data_end);
+  }
+}
+
+}  // namespace slog
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <glog/logging.h>
+
+#include <string>
+#include <string_view>
+
+#include "common/types.h"
+
+namespace slog {
+
+/**
+ * A binary snapshot of the records of a partition, laid out so that it can be memory-mapped
+ * and used without any parsing:
+ *
+ *   Header | Directory | Data
+ *
+ * The directory has one fixed-size entry per record holding the master metadata of the
+ * record and the position of its key and value in the data region, where the key and the
+ * value of each record are stored back to back. Since any record can be located directly
+ * from the directory, a snapshot can be loaded by multiple threads, each taking a range of
+ * records. All integers are little-endian.
+ */
+namespace snapshot {
+
+constexpr char kMagic[8] = {'S', 'L', 'O', 'G', 'S', 'N', 'A', 'P'};
+constexpr uint32_t kVersion = 1;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t num_records;
+  uint64_t directory_offset;
+  uint64_t data_offset;
+  uint64_t data_size;
+};
+
+struct DirectoryEntry {
+  // Offset of the key relative to the start of the data region. The value follows the key
+  uint64_t offset;
+  uint32_t key_size;
+  uint32_t value_size;
+  uint32_t master;
+  uint32_t counter;
+};
+
+static_assert(sizeof(Header) == 48, "Unexpected padding in snapshot header");
+static_assert(sizeof(DirectoryEntry) == 24, "Unexpected padding in snapshot directory entry");
+
+}  // namespace snapshot
+
+/**
+ * Writes a snapshot with a number of records known in advance. The directory and the data are
+ * buffered separately and written to their own regions of the file, so memory use is constant
+ */
+class SnapshotWriter {
+ public:
+  SnapshotWriter(const std::string& path, uint64_t num_records);
+  ~SnapshotWriter();
+
+  SnapshotWriter(const SnapshotWriter&) = delete;
+  SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+  void Add(std::string_view key, std::string_view value, const Metadata& metadata);
+  // Writes out the remaining buffered data and syncs the file. Must be called after all records are added
+  void Finish();
+
+ private:
+  void FlushBuffers();
+
+  std::string path_;
+  int fd_;
+  uint64_t num_records_;
+  uint64_t num_added_;
+  uint64_t directory_pos_;
+  uint64_t data_pos_;
+  std::string directory_buffer_;
+  std::string data_buffer_;
+};
+
+/**
+ * Memory-maps a snapshot. Pages are only read from disk when the records on them are accessed
+ */
+class SnapshotReader {
+ public:
+  struct Entry {
+    std::string_view key;
+    std::string_view value;
+    Metadata metadata;
+  };
+
+  explicit SnapshotReader(const std::string& path);
+  ~SnapshotReader();
+
+  SnapshotReader(const SnapshotReader&) = delete;
+  SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+  uint64_t num_records() const { return header_->num_records; }
+
+  // Crashes if the entry points outside of the data region, as it does in a corrupt snapshot
+  Entry Get(uint64_t i) const {
+    DCHECK_LT(i, header_->num_records);
+    const auto& dir_entry = directory_[i];
+    CHECK(dir_entry.offset <= header_->data_size &&
+          uint64_t{dir_entry.key_size} + dir_entry.value_size <= header_->data_size - dir_entry.offset)
+        << "Snapshot entry " << i << " is out of bounds";
+    auto key = data_ + dir_entry.offset;
+    return Entry{std::string_view(key, dir_entry.key_size),
+                 std::string_view(key + dir_entry.key_size, dir_entry.value_size),
+                 Metadata(dir_entry.master, dir_entry.counter)};
+  }
+
+  // Hints the kernel to read the records in [from, to) ahead, as when they are about to be loaded in order
+  void WillNeed(uint64_t from, uint64_t to) const;
+
+ private:
+  void* addr_;
+  size_t size_;
+  const snapshot::Header* header_;
+  const snapshot::DirectoryEntry* directory_;
+  const char* data_;
+};
+
+}  // namespace slog
@@ -1,13 +1,16 @@
 #pragma once
 
+#include <cstring>
+#include <functional>
 #include <string>
+#include <string_view>
 
+#include "common/slab_allocator.h"
 #include "proto/transaction.pb.h"
 
 namespace slog {
 
 using Key = std::string;
-using KeyReplica = std::string;
 using Value = std::string;
 using TxnId = uint64_t;
 using BatchId = uint64_t;
@@ -28,62 +31,100 @@ struct Metadata {
   uint32_t counter = 0;
 };
 
+/**
+ * A record value with its master metadata. The value is allocated from the slab
+ * allocator so that writing and copying records rarely goes to the global heap.
+ */
 struct Record {
   Record(const std::string& v, uint32_t m = 0, uint32_t c = 0) : metadata_(m, c) { SetValue(v); }
 
-  Record(const Record& other) {
-    SetValue(other.data_.get(), other.size_);
-    SetMetadata(other.metadata_);
-  }
+  Record(const Record& other) : metadata_(other.metadata_) { SetValue(other.data_, other.size_); }
 
   Record& operator=(const Record& other) {
-    Record tmp(other);
-    data_.swap(tmp.data_);
-    std::swap(size_, tmp.size_);
-    std::swap(metadata_, tmp.metadata_);
+    if (this != &other) {
+      SetValue(other.data_, other.size_);
+      SetMetadata(other.metadata_);
+    }
     return *this;
   }
 
+  Record(Record&& other) noexcept : metadata_(other.metadata_), data_(other.data_), size_(other.size_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+
+  Record& operator=(Record&& other) noexcept {
+    std::swap(metadata_, other.metadata_);
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    return *this;
+  }
+
+  ~Record() { SlabAllocator::Default().Deallocate(data_, size_); }
+
   void SetMetadata(const Metadata& metadata) { metadata_ = metadata; }
 
   void SetValue(const std::string& v) { SetValue(v.data(), v.size()); }
 
   void SetValue(const char* data, size_t size) {
+    // Reuse the current slot if the new value falls into the same size class
+    if (!SlabAllocator::FitsSameSlot(size_, size)) {
+      auto& allocator = SlabAllocator::Default();
+      allocator.Deallocate(data_, size_);
+      data_ = allocator.Allocate(size);
+    }
     size_ = size;
-    data_.reset(new char[size_]);
-    memcpy(data_.get(), data, size_);
+    if (size_ > 0) {
+      memcpy(data_, data, size_);
+    }
   }
 
   std::string to_string() const {
     if (data_ == nullptr) {
       return "";
     }
-    return std::string(data_.get(), size_);
+    return std::string(data_, size_);
   }
 
   Record() = default;
 
   const Metadata& metadata() const { return metadata_; }
-  char* data() { return data_.get(); }
-  size_t size() { return size_; }
+  char* data() { return data_; }
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
 
  private:
   Metadata metadata_;
-  std::unique_ptr<char[]> data_;
+  char* data_ = nullptr;
   size_t size_ = 0;
 };
 
 enum class LockMode { UNLOCKED, READ, WRITE };
 enum class AcquireLocksResult { ACQUIRED, WAITING, ABORT };
 
-inline KeyReplica MakeKeyReplica(const Key& key, uint32_t master) {
-  std::string new_key;
-  auto master_str = std::to_string(master);
-  new_key.reserve(key.length() + master_str.length() + 1);
-  new_key += key;
-  new_key += ":";
-  new_key += master_str;
-  return new_key;
-}
+/**
+ * Identifies the lock on a key at a replica. Lock tables are keyed by this pair instead of a
+ * concatenated string so that looking up a lock does not need to build a new string
+ */
+struct KeyReplica {
+  KeyReplica() = default;
+  KeyReplica(const Key& k, uint32_t r) : key(k), replica(r) {}
+
+  bool operator==(const KeyReplica& other) const { return replica == other.replica && key == other.key; }
+
+  std::string to_string() const { return key + ":" + std::to_string(replica); }
+
+  Key key;
+  uint32_t replica = 0;
+};
+
+struct KeyReplicaHash {
+  size_t operator()(const KeyReplica& key_replica) const { return (*this)(key_replica.key, key_replica.replica); }
+
+  size_t operator()(std::string_view key, uint32_t replica) const {
+    auto h = std::hash<std::string_view>{}(key);
+    return h ^ (replica + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2));
+  }
+};
 
 }  // namespace slog
\ No newline at end of file
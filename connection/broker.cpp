@@ -2,6 +2,10 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <deque>
+#include <unordered_set>
+
 #include "common/constants.h"
 #include "common/proto_utils.h"
 #include "common/thread_utils.h"
@@ -21,6 +25,10 @@ namespace slog {
 using internal::Envelope;
 
 namespace {
+
+// Number of removed redirections whose tags are remembered to drop the late messages for them
+const size_t kMaxExpiredTags = 1 << 16;
+
 class BrokerThread : public Module {
  public:
   BrokerThread(const shared_ptr<zmq::context_t>& context, const string& internal_endpoint,
@@ -64,33 +72,12 @@ class BrokerThread : public Module {
 
     if (zmq::message_t msg; external_socket_.recv(msg, zmq::recv_flags::dontwait)) {
       recv_retries_ = recv_retries_start_;
+      // A redirect request sent before this message arrived must take effect before the message is handled
+      HandleRedirectRequests();
       HandleIncomingMessage(move(msg));
     }
 
-    if (auto env = RecvEnvelope(internal_socket_, true /* dont_wait */); env != nullptr) {
-      recv_retries_ = recv_retries_start_;
-
-      if (!env->has_request() || !env->request().has_broker_redirect()) {
-        return false;
-      }
-      auto tag = env->request().broker_redirect().tag();
-      if (env->request().broker_redirect().stop()) {
-        redirect_.erase(tag);
-        return false;
-      }
-      auto channel = env->request().broker_redirect().channel();
-      auto chan_it = channels_.find(channel);
-      if (chan_it == channels_.end()) {
-        LOG(ERROR) << "Invalid channel to redirect to: \"" << channel << "\".";
-        return false;
-      }
-      auto& entry = redirect_[tag];
-      entry.to = channel;
-      for (auto& msg : entry.pending_msgs) {
-        ForwardMessage(chan_it->second.socket, chan_it->second.send_raw, move(msg));
-      }
-      entry.pending_msgs.clear();
-    }
+    HandleRedirectRequests();
 
     if (recv_retries_ > 0) {
       --recv_retries_;
@@ -100,6 +87,44 @@ class BrokerThread : public Module {
   }
 
  private:
+  void HandleRedirectRequests() {
+    while (auto env = RecvEnvelope(internal_socket_, true /* dont_wait */)) {
+      recv_retries_ = recv_retries_start_;
+      HandleRedirectRequest(move(env));
+    }
+  }
+
+  void HandleRedirectRequest(EnvelopePtr&& env) {
+    if (!env->has_request() || !env->request().has_broker_redirect()) {
+      return;
+    }
+    auto tag = env->request().broker_redirect().tag();
+    if (env->request().broker_redirect().stop()) {
+      redirect_.erase(tag);
+      ExpireTag(tag);
+      return;
+    }
+    auto channel = env->request().broker_redirect().channel();
+    auto chan_it = channels_.find(channel);
+    if (chan_it == channels_.end()) {
+      LOG(ERROR) << "Invalid channel to redirect to: \"" << channel << "\".";
+      return;
+    }
+    auto entry_it = redirect_.try_emplace(tag).first;
+    auto& entry = entry_it->second;
+    entry.to = channel;
+    entry.num_remaining = env->request().broker_redirect().num_messages();
+    for (auto& msg : entry.pending_msgs) {
+      ForwardMessage(chan_it->second.socket, chan_it->second.send_raw, move(msg));
+    }
+    entry.num_remaining -= std::min<uint32_t>(entry.num_remaining, entry.pending_msgs.size());
+    entry.pending_msgs.clear();
+    if (entry.num_remaining == 0 && env->request().broker_redirect().num_messages() > 0) {
+      redirect_.erase(entry_it);
+      ExpireTag(tag);
+    }
+  }
+
   void HandleIncomingMessage(zmq::message_t&& msg) {
     Channel tag_or_chan_id;
     if (!ParseChannel(tag_or_chan_id, msg)) {
@@ -113,12 +138,26 @@ class BrokerThread : public Module {
     // This condition effectively allows sending messages to a worker only via redirection since
     // workers' channel ids are larger than kMaxChannel
     if (tag_or_chan_id >= kMaxChannel) {
-      auto& entry = redirect_[tag_or_chan_id];
+      auto entry_it = redirect_.find(tag_or_chan_id);
+      if (entry_it == redirect_.end()) {
+        // Without this check, the message would be queued for a redirection that never comes back
+        if (expired_tags_.count(tag_or_chan_id) > 0) {
+          LOG(WARNING) << "Redirection for tag " << tag_or_chan_id << " has been removed. Dropping message";
+          return;
+        }
+        entry_it = redirect_.try_emplace(tag_or_chan_id).first;
+      }
+      auto& entry = entry_it->second;
       if (!entry.to.has_value()) {
         entry.pending_msgs.push_back(move(msg));
         return;
       }
       chan_id = entry.to.value();
+      // Remove the redirection once it has forwarded all of the messages it was set up for
+      if (entry.num_remaining > 0 && --entry.num_remaining == 0) {
+        redirect_.erase(entry_it);
+        ExpireTag(tag_or_chan_id);
+      }
     }
 
     auto chan_it = channels_.find(chan_id);
@@ -129,6 +168,17 @@ class BrokerThread : public Module {
     ForwardMessage(chan_it->second.socket, chan_it->second.send_raw, move(msg));
   }
 
+  void ExpireTag(uint64_t tag) {
+    if (!expired_tags_.insert(tag).second) {
+      return;
+    }
+    expired_tags_order_.push_back(tag);
+    if (expired_tags_order_.size() > kMaxExpiredTags) {
+      expired_tags_.erase(expired_tags_order_.front());
+      expired_tags_order_.pop_front();
+    }
+  }
+
   void ForwardMessage(zmq::socket_t& socket, bool send_raw, zmq::message_t&& msg) {
     MachineId machine_id = -1;
     ParseMachineId(machine_id, msg);
@@ -167,8 +217,13 @@ class BrokerThread : public Module {
   struct RedirectEntry {
     std::optional<Channel> to;
     vector<zmq::message_t> pending_msgs;
+    // Number of messages to forward before removing the redirection. 0 means no limit
+    uint32_t num_remaining = 0;
   };
   unordered_map<uint64_t, RedirectEntry> redirect_;
+  // Tags of the most recently removed redirections, oldest first
+  std::unordered_set<uint64_t> expired_tags_;
+  std::deque<uint64_t> expired_tags_order_;
 };
 }  // namespace
 
@@ -0,0 +1,31 @@
+#include "connection/event_notifier.h"
+
+#include <glog/logging.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace slog {
+
+EventNotifier::EventNotifier() : fd_(eventfd(0, EFD_NONBLOCK)) {
+  if (fd_ < 0) {
+    LOG(FATAL) << "Cannot create eventfd: " << strerror(errno);
+  }
+}
+
+EventNotifier::~EventNotifier() { close(fd_); }
+
+void EventNotifier::Notify() {
+  uint64_t one = 1;
+  // This only fails when the counter overflows, in which case it is already readable
+  [[maybe_unused]] auto rc = write(fd_, &one, sizeof(one));
+}
+
+void EventNotifier::Clear() {
+  uint64_t count;
+  // This fails with EAGAIN when there is no notification
+  [[maybe_unused]] auto rc = read(fd_, &count, sizeof(count));
+}
+
+}  // namespace slog
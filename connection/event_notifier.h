@@ -0,0 +1,29 @@
+#pragma once
+
+namespace slog {
+
+/**
+ * Wakes up a module waiting in its Poller from another thread without going through
+ * a socket. It is backed by an eventfd that the Poller watches along with the sockets.
+ * Any number of threads can notify but only the module owning it should clear it.
+ */
+class EventNotifier {
+ public:
+  EventNotifier();
+  ~EventNotifier();
+
+  EventNotifier(const EventNotifier&) = delete;
+  EventNotifier& operator=(const EventNotifier&) = delete;
+
+  void Notify();
+
+  // Drops the pending notifications, if any, so that the Poller can go back to sleep
+  void Clear();
+
+  int fd() const { return fd_; }
+
+ private:
+  int fd_;
+};
+
+}  // namespace slog
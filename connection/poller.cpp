@@ -16,6 +16,13 @@ void Poller::PushSocket(zmq::socket_t& socket) {
   });
 }
 
+void Poller::PushFd(int fd) {
+  poll_items_.push_back({
+      nullptr, fd, /* fd */
+      ZMQ_POLLIN, 0 /* revent */
+  });
+}
+
 bool Poller::NextEvent(bool dont_wait) {
   auto may_have_msg = true;
   if (!dont_wait) {
@@ -18,6 +18,9 @@ class Poller {
 
   void PushSocket(zmq::socket_t& socket);
 
+  // Watches a file descriptor that is not a socket, such as the one of an EventNotifier
+  void PushFd(int fd);
+
   bool is_socket_ready(size_t i) const;
 
   void AddTimedCallback(std::chrono::microseconds timeout, std::function<void()>&& cb);
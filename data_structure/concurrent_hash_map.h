@@ -2,8 +2,14 @@
  * concurrent_hash_map.h
  *
  * This implementation borrows from folly::ConcurrentHashMap the idea of sharding key space
- * into different segments. However, each segment here is only coarsely guarded with a read-write
- * latch as opposed to a more granular approach in the highly-optimized folly::ConcurrentHashMap.
+ * into different segments. Writers of a segment are serialized by a coarse latch, as opposed to a
+ * more granular approach in the highly-optimized folly::ConcurrentHashMap.
+ *
+ * Readers never take the latch. Nodes are immutable once published: an update links in a new node
+ * and retires the old one, which is only freed once the epoch manager guarantees that no reader can
+ * still reach it. Since rehashing relinks the existing nodes into a new bucket array, a reader may
+ * miss a key while a rehash is in progress, so each segment also keeps a seqlock-style version that
+ * readers validate after their traversal and retry on change.
  *
  * This map should be used in conjuction with shared_ptr because its destructor is not
  * thread-safe. With shared_ptr, the last thread that releases the pointer will be the only
@@ -11,10 +17,14 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
-#include "data_structure/rwlatch.h"
+#include "data_structure/epoch_manager.h"
 
 namespace slog {
 
@@ -25,12 +35,12 @@ struct NodeT {
   NodeT() = default;
 
   NodeT(const NodeT& other) {
-    next = other.next;
+    next.store(other.next.load());
     key = other.key;
     value = other.value;
   }
 
-  NodeT* next{nullptr};
+  std::atomic<NodeT*> next{nullptr};
   KeyType key;
   ValueType value;
 };
@@ -39,176 +49,307 @@ template <typename KeyType, typename ValueType, typename HashFn = std::hash<KeyT
 class SegmentT {
   using Node = NodeT<KeyType, ValueType>;
 
-  static constexpr float kLoadFactor = 1.05;
+  // Number of retired objects accumulated before trying to free them
+  static constexpr size_t kReclaimThreshold = 64;
 
  public:
+  static constexpr float kLoadFactor = 1.05;
+
   /**
    * initial_bucket_count must be a power of 2
    */
   SegmentT(size_t initial_bucket_count = 8)
-      : load_factor_max_size_(static_cast<size_t>(kLoadFactor * initial_bucket_count)), size_(0) {
-    buckets_.reset(Buckets::CreateBuckets(initial_bucket_count));
+      : version_(0), load_factor_max_size_(static_cast<size_t>(kLoadFactor * initial_bucket_count)), size_(0) {
+    buckets_.store(Buckets::CreateBuckets(initial_bucket_count));
+  }
+
+  ~SegmentT() {
+    delete buckets_.load();
+    for (auto& [epoch, node] : retired_nodes_) {
+      delete node;
+    }
+    for (auto& [epoch, buckets] : retired_buckets_) {
+      delete buckets;
+    }
   }
 
   bool Get(ValueType& res, const KeyType& key) const {
-    auto h = HashFn{}(key);
-    bool found = false;
+    EpochGuard guard;
+    auto value = GetPinned(key);
+    if (value == nullptr) {
+      return false;
+    }
+    res = *value;
+    return true;
+  }
 
-    rw_latch_.RLock();
+  /**
+   * Returns a pointer to the value without copying it. The caller must be in an epoch
+   * (e.g. holding an EpochGuard) for as long as the pointer is used
+   */
+  const ValueType* GetPinned(const KeyType& key) const { return GetPinned(key, HashFn{}(key)); }
+
+  const ValueType* GetPinned(const KeyType& key, size_t h) const {
+    for (;;) {
+      auto version = version_.load(std::memory_order_acquire);
+      if (version & 1) {
+        // A rehash is in progress
+        std::this_thread::yield();
+        continue;
+      }
 
-    auto idx = GetIndex(buckets_->count, h);
-    auto node = buckets_->bucket_roots[idx];
-    while (node) {
-      if (key == node->key) {
-        break;
+      const ValueType* res = nullptr;
+      auto buckets = buckets_.load(std::memory_order_acquire);
+      auto idx = GetIndex(buckets->count, h);
+      auto node = buckets->bucket_roots[idx].load(std::memory_order_acquire);
+      while (node) {
+        if (key == node->key) {
+          res = &node->value;
+          break;
+        }
+        node = node->next.load(std::memory_order_acquire);
+      }
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (version_.load(std::memory_order_relaxed) == version) {
+        return res;
       }
-      node = node->next;
-    }
-    if (node) {
-      res = node->value;
-      found = true;
     }
+  }
 
-    rw_latch_.RUnlock();
+  /**
+   * Bring the bucket and then the first node of the chain of the given hash into the cache ahead
+   * of a GetPinned call. The caller must be in an epoch
+   */
+  void PrefetchBucket(size_t h) const {
+    auto buckets = buckets_.load(std::memory_order_acquire);
+    __builtin_prefetch(&buckets->bucket_roots[GetIndex(buckets->count, h)]);
+  }
 
-    return found;
+  void PrefetchNode(size_t h) const {
+    auto buckets = buckets_.load(std::memory_order_acquire);
+    auto node = buckets->bucket_roots[GetIndex(buckets->count, h)].load(std::memory_order_acquire);
+    if (node != nullptr) {
+      __builtin_prefetch(node);
+    }
   }
 
   ValueType* GetUnsafe(const KeyType& key) {
     auto h = HashFn{}(key);
-    auto idx = GetIndex(buckets_->count, h);
-    auto node = buckets_->bucket_roots[idx];
+    auto buckets = buckets_.load(std::memory_order_relaxed);
+    auto idx = GetIndex(buckets->count, h);
+    auto node = buckets->bucket_roots[idx].load(std::memory_order_relaxed);
     while (node) {
       if (key == node->key) {
         return &node->value;
       }
-      node = node->next;
+      node = node->next.load(std::memory_order_relaxed);
     }
     return nullptr;
   }
 
-  bool InsertOrUpdate(const KeyType& key, const ValueType& value) {
+  template <typename V>
+  bool InsertOrUpdate(const KeyType& key, V&& value) {
     auto h = HashFn{}(key);
 
-    rw_latch_.WLock();
+    // Build the node outside of the critical section
+    auto new_node = new Node();
+    new_node->key = key;
+    new_node->value = std::forward<V>(value);
 
-    auto idx = GetIndex(buckets_->count, h);
-    Node* prev = nullptr;
-    bool key_exists = false;
-    auto node = buckets_->bucket_roots[idx];
-    while (node) {
-      if (key == node->key) {
-        key_exists = true;
-        // If key already exists, replace the corresponding
-        // node with a new node containing the new value
-        auto new_node = new Node();
-        new_node->key = key;
-        new_node->value = value;
-        new_node->next = node->next;
-        if (prev) {
-          prev->next = new_node;
-        } else {
-          buckets_->bucket_roots[idx] = new_node;
-        }
-        delete node;
+    std::lock_guard<std::mutex> guard(write_latch_);
 
-        break;
-      }
-      prev = node;
-      node = node->next;
-    }
+    return InsertNode(new_node, h);
+  }
 
-    if (!key_exists) {
-      // If key does not exist, at new node to the bucket
-      auto new_node = new Node();
-      new_node->key = key;
-      new_node->value = value;
-      new_node->next = buckets_->bucket_roots[idx];
-      buckets_->bucket_roots[idx] = new_node;
-      size_++;
+  /**
+   * Grows the bucket array to at least the given number of buckets, which must be a power of 2,
+   * so that inserting up to that many entries does not trigger any rehash
+   */
+  void Reserve(size_t bucket_count) {
+    std::lock_guard<std::mutex> guard(write_latch_);
+    if (bucket_count > buckets_.load(std::memory_order_relaxed)->count) {
+      Rehash(bucket_count);
     }
+  }
 
-    if (size_ >= load_factor_max_size_) {
-      Rehash();
+  // Calls fn(key, value) on every entry. Writers of the segment are blocked during the call
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    std::lock_guard<std::mutex> guard(write_latch_);
+    auto buckets = buckets_.load(std::memory_order_relaxed);
+    for (size_t idx = 0; idx < buckets->count; idx++) {
+      for (auto node = buckets->bucket_roots[idx].load(std::memory_order_relaxed); node != nullptr;
+           node = node->next.load(std::memory_order_relaxed)) {
+        fn(node->key, node->value);
+      }
     }
+  }
 
-    rw_latch_.WUnlock();
-
-    return key_exists;
+  /**
+   * Inserts a range of (hash, node) pairs, taking the latch only once. The nodes are owned by the
+   * segment afterwards. If a key appears multiple times, the last node of that key wins
+   */
+  template <typename It>
+  void InsertNodes(It begin, It end) {
+    std::lock_guard<std::mutex> guard(write_latch_);
+    for (auto it = begin; it != end; it++) {
+      InsertNode(it->second, it->first);
+    }
   }
 
   bool Erase(const KeyType& key) {
     auto h = HashFn{}(key);
 
-    rw_latch_.WLock();
+    std::lock_guard<std::mutex> guard(write_latch_);
 
     bool key_exists = false;
-    auto idx = GetIndex(buckets_->count, h);
+    auto buckets = buckets_.load(std::memory_order_relaxed);
+    auto idx = GetIndex(buckets->count, h);
     Node* prev = nullptr;
-    auto node = buckets_->bucket_roots[idx];
+    auto node = buckets->bucket_roots[idx].load(std::memory_order_relaxed);
     while (node) {
       if (key == node->key) {
         key_exists = true;
+        auto next = node->next.load(std::memory_order_relaxed);
         if (prev) {
-          prev->next = node->next;
+          prev->next.store(next, std::memory_order_release);
         } else {
-          buckets_->bucket_roots[idx] = node->next;
+          buckets->bucket_roots[idx].store(next, std::memory_order_release);
         }
-        delete node;
+        size_--;
+        RetireNode(node);
         break;
       }
       prev = node;
-      node = node->next;
+      node = node->next.load(std::memory_order_relaxed);
     }
 
-    rw_latch_.WUnlock();
-
     return key_exists;
   }
 
  private:
+  struct Buckets;
+
   // Must hold lock
   static uint64_t GetIndex(size_t nbuckets, size_t hash) { return (hash >> ShardBits) & (nbuckets - 1); }
 
   // Must hold lock
-  void Rehash() {
-    auto new_bucket_count = buckets_->count << 1;
+  bool InsertNode(Node* new_node, size_t h) {
+    auto buckets = buckets_.load(std::memory_order_relaxed);
+    auto idx = GetIndex(buckets->count, h);
+    Node* prev = nullptr;
+    bool key_exists = false;
+    auto node = buckets->bucket_roots[idx].load(std::memory_order_relaxed);
+    while (node) {
+      if (new_node->key == node->key) {
+        key_exists = true;
+        // If key already exists, replace the corresponding node with the new node. The old
+        // node keeps its next pointer so that readers currently on it can move on
+        new_node->next.store(node->next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        if (prev) {
+          prev->next.store(new_node, std::memory_order_release);
+        } else {
+          buckets->bucket_roots[idx].store(new_node, std::memory_order_release);
+        }
+        RetireNode(node);
+
+        break;
+      }
+      prev = node;
+      node = node->next.load(std::memory_order_relaxed);
+    }
+
+    if (!key_exists) {
+      // If key does not exist, at new node to the bucket
+      new_node->next.store(buckets->bucket_roots[idx].load(std::memory_order_relaxed), std::memory_order_relaxed);
+      buckets->bucket_roots[idx].store(new_node, std::memory_order_release);
+      size_++;
+    }
+
+    if (size_ >= load_factor_max_size_) {
+      Rehash(buckets->count << 1);
+    }
+
+    return key_exists;
+  }
+
+  // Must hold lock
+  void Rehash(size_t new_bucket_count) {
+    auto old_buckets = buckets_.load(std::memory_order_relaxed);
     auto new_buckets = Buckets::CreateBuckets(new_bucket_count);
 
-    for (size_t idx = 0; idx < buckets_->count; idx++) {
-      auto node = buckets_->bucket_roots[idx];
+    // Readers that overlap with this section will retry
+    version_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (size_t idx = 0; idx < old_buckets->count; idx++) {
+      auto node = old_buckets->bucket_roots[idx].load(std::memory_order_relaxed);
       if (node == nullptr) {
         continue;
       }
 
       while (node) {
-        auto next_node = node->next;
+        auto next_node = node->next.load(std::memory_order_relaxed);
 
         auto idx = GetIndex(new_bucket_count, HashFn{}(node->key));
-        node->next = new_buckets->bucket_roots[idx];
-        new_buckets->bucket_roots[idx] = node;
+        node->next.store(new_buckets->bucket_roots[idx].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        new_buckets->bucket_roots[idx].store(node, std::memory_order_relaxed);
 
         node = next_node;
       }
-      buckets_->bucket_roots[idx] = nullptr;
+      old_buckets->bucket_roots[idx].store(nullptr, std::memory_order_relaxed);
     }
-    buckets_.reset(new_buckets);
-    load_factor_max_size_ = static_cast<size_t>(kLoadFactor * buckets_->count);
+    buckets_.store(new_buckets, std::memory_order_release);
+
+    version_.fetch_add(1, std::memory_order_release);
+
+    // The old bucket array is now empty so retiring it does not free any node
+    retired_buckets_.emplace_back(EpochManager::Instance().Retire(), old_buckets);
+    load_factor_max_size_ = static_cast<size_t>(kLoadFactor * new_bucket_count);
+  }
+
+  // Must hold lock
+  void RetireNode(Node* node) {
+    retired_nodes_.emplace_back(EpochManager::Instance().Retire(), node);
+    if (retired_nodes_.size() >= kReclaimThreshold) {
+      Reclaim();
+    }
+  }
+
+  // Must hold lock
+  void Reclaim() {
+    auto safe_epoch = EpochManager::Instance().SafeEpoch();
+    ReclaimList(retired_nodes_, safe_epoch);
+    ReclaimList(retired_buckets_, safe_epoch);
+  }
+
+  template <typename T>
+  static void ReclaimList(std::vector<std::pair<uint64_t, T*>>& retired, uint64_t safe_epoch) {
+    size_t kept = 0;
+    for (auto& entry : retired) {
+      if (entry.first < safe_epoch) {
+        delete entry.second;
+      } else {
+        retired[kept++] = entry;
+      }
+    }
+    retired.resize(kept);
   }
 
   struct Buckets {
     static Buckets* CreateBuckets(size_t num_buckets) {
       auto buckets = new Buckets();
       buckets->count = num_buckets;
-      buckets->bucket_roots = std::make_unique<Node*[]>(num_buckets);
+      buckets->bucket_roots = std::make_unique<std::atomic<Node*>[]>(num_buckets);
       return buckets;
     }
 
     ~Buckets() {
       for (size_t i = 0; i < count; i++) {
-        auto node = bucket_roots[i];
+        auto node = bucket_roots[i].load();
         while (node) {
-          auto next = node->next;
+          auto next = node->next.load();
           delete node;
           node = next;
         }
@@ -216,13 +357,18 @@ class SegmentT {
     }
 
     size_t count;
-    std::unique_ptr<Node*[]> bucket_roots;
+    std::unique_ptr<std::atomic<Node*>[]> bucket_roots;
   };
 
-  mutable bustub::ReaderWriterLatch rw_latch_;
-  std::unique_ptr<Buckets> buckets_;
+  mutable std::mutex write_latch_;
+  std::atomic<uint64_t> version_;
+  std::atomic<Buckets*> buckets_;
   size_t load_factor_max_size_;
   size_t size_;
+
+  // Objects unlinked from the segment, tagged with their retirement epoch
+  std::vector<std::pair<uint64_t, Node*>> retired_nodes_;
+  std::vector<std::pair<uint64_t, Buckets*>> retired_buckets_;
 };
 
 }  // namespace concurrent_hash_map
@@ -230,6 +376,7 @@ class SegmentT {
 template <typename KeyType, typename ValueType, typename HashFn = std::hash<KeyType>, uint8_t ShardBits = 8>
 class ConcurrentHashMap {
   using Segment = concurrent_hash_map::SegmentT<KeyType, ValueType, HashFn, ShardBits>;
+  using Node = concurrent_hash_map::NodeT<KeyType, ValueType>;
 
  public:
   ConcurrentHashMap() {
@@ -257,9 +404,15 @@ class ConcurrentHashMap {
     return EnsureSegment(idx)->Get(res, key);
   }
 
-  bool InsertOrUpdate(const KeyType& key, const ValueType& value) {
+  const ValueType* GetPinned(const KeyType& key) const {
+    auto idx = PickSegment(key);
+    return EnsureSegment(idx)->GetPinned(key);
+  }
+
+  template <typename V>
+  bool InsertOrUpdate(const KeyType& key, V&& value) {
     auto idx = PickSegment(key);
-    return EnsureSegment(idx)->InsertOrUpdate(key, value);
+    return EnsureSegment(idx)->InsertOrUpdate(key, std::forward<V>(value));
   }
 
   bool Erase(const KeyType& key) {
@@ -267,7 +420,94 @@ class ConcurrentHashMap {
     return EnsureSegment(idx)->Erase(key);
   }
 
+  /**
+   * Pre-sizes all segments for the expected number of entries. Meant to be called before a bulk
+   * load so that the segments do not repeatedly rehash under their latches while being filled
+   */
+  void Reserve(size_t expected_size) {
+    auto per_segment = static_cast<size_t>(expected_size / NumShards / Segment::kLoadFactor) + 1;
+    size_t bucket_count = 1;
+    while (bucket_count < per_segment) {
+      bucket_count <<= 1;
+    }
+    for (uint64_t i = 0; i < NumShards; i++) {
+      EnsureSegment(i)->Reserve(bucket_count);
+    }
+  }
+
+  /**
+   * Calls fn(key, value) on every entry, one segment at a time. Only the writers of the
+   * segment being visited are blocked, so the entries are not a consistent snapshot
+   */
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    for (uint64_t i = 0; i < NumShards; i++) {
+      if (auto segment = segments_[i].load(); segment != nullptr) {
+        segment->ForEach(fn);
+      }
+    }
+  }
+
+  /**
+   * Looks up a batch of keys, calling fn(i, value) in order with a pointer to the value of
+   * keys[i], or nullptr if it does not exist. The lookup stops early if fn returns false.
+   * The hashes of a chunk of keys are computed upfront so that the memory accesses of the
+   * lookups within the chunk overlap. The caller must be in an epoch
+   */
+  template <typename Fn>
+  void MultiGetPinned(const std::vector<const KeyType*>& keys, Fn&& fn) const {
+    size_t hashes[kMultiGetChunkSize];
+    Segment* segments[kMultiGetChunkSize];
+    for (size_t start = 0; start < keys.size(); start += kMultiGetChunkSize) {
+      auto n = std::min(kMultiGetChunkSize, keys.size() - start);
+      for (size_t i = 0; i < n; i++) {
+        hashes[i] = HashFn{}(*keys[start + i]);
+        segments[i] = EnsureSegment(hashes[i] & (NumShards - 1));
+        segments[i]->PrefetchBucket(hashes[i]);
+      }
+      for (size_t i = 0; i < n; i++) {
+        segments[i]->PrefetchNode(hashes[i]);
+      }
+      for (size_t i = 0; i < n; i++) {
+        if (!fn(start + i, segments[i]->GetPinned(*keys[start + i], hashes[i]))) {
+          return;
+        }
+      }
+    }
+  }
+
+  /**
+   * Inserts or updates a batch of keys. The values are moved from. Keys are grouped
+   * by segment so that the latch of each segment is taken only once
+   */
+  template <typename V>
+  void MultiInsertOrUpdate(const std::vector<const KeyType*>& keys, std::vector<V>& values) {
+    std::vector<std::pair<size_t, Node*>> nodes;
+    nodes.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+      auto node = new Node();
+      node->key = *keys[i];
+      node->value = std::move(values[i]);
+      nodes.emplace_back(HashFn{}(node->key), node);
+    }
+    // Stable sort so that the order of the writes to the same key is preserved
+    auto segment_of = [](const std::pair<size_t, Node*>& entry) { return entry.first & (NumShards - 1); };
+    std::stable_sort(nodes.begin(), nodes.end(),
+                     [&](const auto& a, const auto& b) { return segment_of(a) < segment_of(b); });
+    for (auto begin = nodes.begin(); begin != nodes.end();) {
+      auto idx = segment_of(*begin);
+      auto end = begin;
+      while (end != nodes.end() && segment_of(*end) == idx) {
+        end++;
+      }
+      EnsureSegment(idx)->InsertNodes(begin, end);
+      begin = end;
+    }
+  }
+
  private:
+  static constexpr size_t kMultiGetChunkSize = 16;
+
   uint64_t PickSegment(const KeyType& key) const {
     auto h = HashFn{}(key);
     return h & (NumShards - 1);
@@ -0,0 +1,129 @@
+/**
+ * epoch_manager.h
+ *
+ * A small epoch-based reclamation scheme used by lock-free readers of shared data structures.
+ *
+ * A reader brackets its accesses with an EpochGuard, which announces the global epoch observed at
+ * entry in a per-thread slot. A writer that unlinks an object from a shared structure calls Retire()
+ * to obtain the epoch to tag that object with, and may free the object only after SafeEpoch()
+ * becomes greater than the tag, i.e. when no reader that could still hold a pointer to it is active.
+ */
+#pragma once
+
+#include <glog/logging.h>
+
+#include <atomic>
+#include <limits>
+
+namespace slog {
+
+class EpochManager {
+ public:
+  static constexpr uint64_t kQuiescent = std::numeric_limits<uint64_t>::max();
+  static constexpr size_t kMaxThreads = 256;
+
+  static EpochManager& Instance() {
+    static EpochManager instance;
+    return instance;
+  }
+
+  /**
+   * Marks the calling thread as active. Calls can be nested, in which case
+   * only the outermost call announces an epoch.
+   */
+  void Enter() {
+    auto& local = Local();
+    if (local.depth++ > 0) {
+      return;
+    }
+    if (local.slot == nullptr) {
+      local.slot = AcquireSlot();
+    }
+    local.slot->epoch.store(global_epoch_.load());
+    // Make the announcement visible before any shared pointer is loaded
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+  void Exit() {
+    auto& local = Local();
+    DCHECK_GT(local.depth, 0);
+    if (--local.depth == 0) {
+      local.slot->epoch.store(kQuiescent, std::memory_order_release);
+    }
+  }
+
+  /**
+   * Must be called after an object is unlinked from a shared structure.
+   * Returns the epoch that the object should be tagged with.
+   */
+  uint64_t Retire() {
+    // Order the unlinking before reading the announcements of the readers
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return global_epoch_.fetch_add(1);
+  }
+
+  /**
+   * Objects retired with an epoch strictly smaller than the returned value
+   * can no longer be reached by any reader
+   */
+  uint64_t SafeEpoch() const {
+    auto safe_epoch = global_epoch_.load();
+    for (const auto& slot : slots_) {
+      auto epoch = slot.epoch.load();
+      if (epoch < safe_epoch) {
+        safe_epoch = epoch;
+      }
+    }
+    return safe_epoch;
+  }
+
+ private:
+  struct alignas(64) Slot {
+    std::atomic<uint64_t> epoch{kQuiescent};
+    std::atomic<bool> in_use{false};
+  };
+
+  struct LocalState {
+    ~LocalState() {
+      if (slot != nullptr) {
+        slot->epoch.store(kQuiescent);
+        slot->in_use.store(false);
+      }
+    }
+
+    Slot* slot = nullptr;
+    int depth = 0;
+  };
+
+  EpochManager() = default;
+
+  static LocalState& Local() {
+    static thread_local LocalState local;
+    return local;
+  }
+
+  Slot* AcquireSlot() {
+    for (auto& slot : slots_) {
+      bool expected = false;
+      if (!slot.in_use.load(std::memory_order_relaxed) && slot.in_use.compare_exchange_strong(expected, true)) {
+        return &slot;
+      }
+    }
+    LOG(FATAL) << "Number of threads exceeds the epoch manager capacity of " << kMaxThreads;
+    return nullptr;
+  }
+
+  std::atomic<uint64_t> global_epoch_{1};
+  Slot slots_[kMaxThreads];
+};
+
+class EpochGuard {
+ public:
+  EpochGuard() { EpochManager::Instance().Enter(); }
+  ~EpochGuard() { EpochManager::Instance().Exit(); }
+
+  EpochGuard(const EpochGuard&) = delete;
+  EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+}  // namespace slog
@@ -0,0 +1,380 @@
+/**
+ * flat_hash_map.h
+ *
+ * An open-addressing alternative to ConcurrentHashMap, following the design of Abseil's
+ * Swiss tables. Like ConcurrentHashMap, the key space is sharded into segments, each of which
+ * is guarded by a coarse reader-writer latch.
+ *
+ * Within a segment, entries live directly in a flat slot array instead of in individually
+ * allocated nodes. A parallel array of one-byte control words holds a 7-bit fingerprint of the
+ * hash of each occupied slot, so a lookup compares the fingerprint against a whole group of 16
+ * control words at once (with SSE2 when available) and only touches the slots whose fingerprint
+ * matches. Short keys are stored inside the slot, so in the common case a lookup costs one miss
+ * on the control words and one on the slot.
+ *
+ * As with ConcurrentHashMap, the destructor is not thread-safe.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace slog {
+
+namespace flat_hash_map {
+
+static constexpr int8_t kEmpty = -128;
+static constexpr int8_t kDeleted = -2;
+
+/**
+ * A string that is stored inline if it is short enough, and on the heap otherwise
+ */
+class InlineKey {
+ public:
+  static constexpr size_t kInlineKeySize = 24;
+
+  InlineKey() : size_(0) {}
+  InlineKey(const InlineKey&) = delete;
+  InlineKey& operator=(const InlineKey&) = delete;
+  ~InlineKey() { Clear(); }
+
+  void Set(std::string_view key) {
+    Clear();
+    size_ = key.size();
+    if (is_inline()) {
+      memcpy(buf_.inline_data, key.data(), size_);
+    } else {
+      buf_.heap_data = new char[size_];
+      memcpy(buf_.heap_data, key.data(), size_);
+    }
+  }
+
+  void MoveFrom(InlineKey& other) {
+    Clear();
+    size_ = other.size_;
+    buf_ = other.buf_;
+    other.size_ = 0;
+  }
+
+  void Clear() {
+    if (!is_inline()) {
+      delete[] buf_.heap_data;
+    }
+    size_ = 0;
+  }
+
+  std::string_view view() const { return std::string_view(is_inline() ? buf_.inline_data : buf_.heap_data, size_); }
+
+ private:
+  bool is_inline() const { return size_ <= kInlineKeySize; }
+
+  union {
+    char inline_data[kInlineKeySize];
+    char* heap_data;
+  } buf_;
+  uint32_t size_;
+};
+
+/**
+ * A group of control words that are probed together
+ */
+class Group {
+ public:
+  static constexpr size_t kWidth = 16;
+
+  explicit Group(const int8_t* ctrl) : ctrl_(ctrl) {}
+
+  // Bit i of the returned mask is set if the i-th control word equals to h2
+  uint32_t Match(int8_t h2) const {
+#ifdef __SSE2__
+    auto ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl_));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kWidth; i++) {
+      mask |= static_cast<uint32_t>(ctrl_[i] == h2) << i;
+    }
+    return mask;
+#endif
+  }
+
+  uint32_t MatchEmpty() const { return Match(kEmpty); }
+
+  // Empty and deleted control words are the only negative ones
+  uint32_t MatchEmptyOrDeleted() const {
+#ifdef __SSE2__
+    auto ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl_));
+    return _mm_movemask_epi8(ctrl);
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kWidth; i++) {
+      mask |= static_cast<uint32_t>(ctrl_[i] < 0) << i;
+    }
+    return mask;
+#endif
+  }
+
+ private:
+  const int8_t* ctrl_;
+};
+
+template <typename ValueType, typename HashFn = std::hash<std::string_view>, uint8_t ShardBits = 8>
+class FlatSegmentT {
+  struct Slot {
+    InlineKey key;
+    ValueType value;
+  };
+
+  // Maximum load factor is 7/8
+  static size_t MaxLoad(size_t capacity) { return capacity - capacity / 8; }
+
+ public:
+  /**
+   * initial_capacity must be a power of 2 and at least Group::kWidth
+   */
+  FlatSegmentT(size_t initial_capacity = Group::kWidth) { Allocate(initial_capacity); }
+
+  bool Get(ValueType& res, std::string_view key) const {
+    auto h = HashFn{}(key);
+
+    std::shared_lock<std::shared_mutex> guard(latch_);
+
+    auto slot = Find(key, h);
+    if (slot == nullptr) {
+      return false;
+    }
+    res = slot->value;
+    return true;
+  }
+
+  ValueType* GetUnsafe(std::string_view key) {
+    auto slot = const_cast<Slot*>(Find(key, HashFn{}(key)));
+    return slot == nullptr ? nullptr : &slot->value;
+  }
+
+  template <typename V>
+  bool InsertOrUpdate(std::string_view key, V&& value) {
+    auto h = HashFn{}(key);
+
+    std::unique_lock<std::shared_mutex> guard(latch_);
+
+    if (auto slot = const_cast<Slot*>(Find(key, h)); slot != nullptr) {
+      slot->value = std::forward<V>(value);
+      return true;
+    }
+
+    if (num_used_ + 1 > MaxLoad(capacity_)) {
+      // Grow only if the table is full of live entries. Otherwise, rehashing
+      // in place is enough to clear out the tombstones
+      Resize(size_ + 1 > capacity_ / 2 ? capacity_ * 2 : capacity_);
+    }
+
+    auto idx = FindInsertPosition(h);
+    if (ctrl_[idx] == kEmpty) {
+      num_used_++;
+    }
+    ctrl_[idx] = H2(h);
+    slots_[idx].key.Set(key);
+    slots_[idx].value = std::forward<V>(value);
+    size_++;
+
+    return false;
+  }
+
+  bool Erase(std::string_view key) {
+    auto h = HashFn{}(key);
+
+    std::unique_lock<std::shared_mutex> guard(latch_);
+
+    auto slot = const_cast<Slot*>(Find(key, h));
+    if (slot == nullptr) {
+      return false;
+    }
+    auto idx = slot - slots_.get();
+    // Leave a tombstone so that probe sequences going through this slot are not broken
+    ctrl_[idx] = kDeleted;
+    slot->key.Clear();
+    slot->value = ValueType();
+    size_--;
+
+    return true;
+  }
+
+  // Grows the table so that it can hold the given number of entries without resizing
+  void Reserve(size_t num_entries) {
+    std::unique_lock<std::shared_mutex> guard(latch_);
+    auto capacity = capacity_;
+    while (MaxLoad(capacity) < num_entries) {
+      capacity *= 2;
+    }
+    if (capacity > capacity_) {
+      Resize(capacity);
+    }
+  }
+
+  size_t size() const { return size_; }
+
+ private:
+  static int8_t H2(size_t hash) { return (hash >> ShardBits) & 0x7F; }
+  static size_t H1(size_t hash) { return hash >> ShardBits >> 7; }
+
+  // Must hold lock
+  const Slot* Find(std::string_view key, size_t hash) const {
+    auto h2 = H2(hash);
+    auto num_groups_mask = capacity_ / Group::kWidth - 1;
+    auto group_idx = H1(hash) & num_groups_mask;
+    // Triangular probing over groups visits every group once since the number of groups is a power of 2
+    for (size_t step = 1;; step++) {
+      auto base = group_idx * Group::kWidth;
+      Group group(ctrl_.get() + base);
+      for (auto mask = group.Match(h2); mask != 0; mask &= mask - 1) {
+        auto idx = base + __builtin_ctz(mask);
+        if (slots_[idx].key.view() == key) {
+          return &slots_[idx];
+        }
+      }
+      if (group.MatchEmpty() != 0 || step > num_groups_mask) {
+        return nullptr;
+      }
+      group_idx = (group_idx + step) & num_groups_mask;
+    }
+  }
+
+  // Must hold lock. There must be at least one empty or deleted slot
+  size_t FindInsertPosition(size_t hash) const {
+    auto num_groups_mask = capacity_ / Group::kWidth - 1;
+    auto group_idx = H1(hash) & num_groups_mask;
+    for (size_t step = 1;; step++) {
+      auto base = group_idx * Group::kWidth;
+      if (auto mask = Group(ctrl_.get() + base).MatchEmptyOrDeleted(); mask != 0) {
+        return base + __builtin_ctz(mask);
+      }
+      group_idx = (group_idx + step) & num_groups_mask;
+    }
+  }
+
+  void Allocate(size_t capacity) {
+    capacity_ = capacity;
+    ctrl_ = std::make_unique<int8_t[]>(capacity);
+    memset(ctrl_.get(), kEmpty, capacity);
+    slots_ = std::make_unique<Slot[]>(capacity);
+    size_ = 0;
+    num_used_ = 0;
+  }
+
+  // Must hold lock
+  void Resize(size_t new_capacity) {
+    auto old_capacity = capacity_;
+    auto old_ctrl = std::move(ctrl_);
+    auto old_slots = std::move(slots_);
+
+    Allocate(new_capacity);
+
+    for (size_t i = 0; i < old_capacity; i++) {
+      if (old_ctrl[i] < 0) {
+        continue;
+      }
+      auto& old_slot = old_slots[i];
+      auto h = HashFn{}(old_slot.key.view());
+      auto idx = FindInsertPosition(h);
+      ctrl_[idx] = H2(h);
+      slots_[idx].key.MoveFrom(old_slot.key);
+      slots_[idx].value = std::move(old_slot.value);
+      size_++;
+      num_used_++;
+    }
+  }
+
+  mutable std::shared_mutex latch_;
+  std::unique_ptr<int8_t[]> ctrl_;
+  std::unique_ptr<Slot[]> slots_;
+  size_t capacity_;
+  // Number of live entries
+  size_t size_;
+  // Number of live entries plus tombstones
+  size_t num_used_;
+};
+
+}  // namespace flat_hash_map
+
+template <typename ValueType, typename HashFn = std::hash<std::string_view>, uint8_t ShardBits = 8>
+class ConcurrentFlatHashMap {
+  using Segment = flat_hash_map::FlatSegmentT<ValueType, HashFn, ShardBits>;
+
+ public:
+  ConcurrentFlatHashMap() {
+    for (uint64_t i = 0; i < NumShards; i++) {
+      segments_[i].store(nullptr);
+    }
+  }
+
+  ~ConcurrentFlatHashMap() {
+    for (uint64_t i = 0; i < NumShards; i++) {
+      auto segment = segments_[i].load();
+      if (segment) {
+        delete segment;
+      }
+    }
+  }
+
+  ValueType* GetUnsafe(std::string_view key) {
+    auto idx = PickSegment(key);
+    return EnsureSegment(idx)->GetUnsafe(key);
+  }
+
+  bool Get(ValueType& res, std::string_view key) const {
+    auto idx = PickSegment(key);
+    return EnsureSegment(idx)->Get(res, key);
+  }
+
+  template <typename V>
+  bool InsertOrUpdate(std::string_view key, V&& value) {
+    auto idx = PickSegment(key);
+    return EnsureSegment(idx)->InsertOrUpdate(key, std::forward<V>(value));
+  }
+
+  bool Erase(std::string_view key) {
+    auto idx = PickSegment(key);
+    return EnsureSegment(idx)->Erase(key);
+  }
+
+  // Pre-sizes all segments for the expected number of entries
+  void Reserve(size_t expected_size) {
+    for (uint64_t i = 0; i < NumShards; i++) {
+      EnsureSegment(i)->Reserve(expected_size / NumShards + 1);
+    }
+  }
+
+ private:
+  uint64_t PickSegment(std::string_view key) const {
+    auto h = HashFn{}(key);
+    return h & (NumShards - 1);
+  }
+
+  Segment* EnsureSegment(uint64_t idx) const {
+    auto segment = segments_[idx].load();
+    if (segment == nullptr) {
+      auto new_segment = new Segment();
+      if (!segments_[idx].compare_exchange_strong(segment, new_segment)) {
+        delete new_segment;
+      } else {
+        segment = new_segment;
+      }
+    }
+    return segment;
+  }
+
+  static constexpr uint64_t NumShards = (1LL << ShardBits);
+
+  mutable std::atomic<Segment*> segments_[NumShards];
+};
+
+}  // namespace slog
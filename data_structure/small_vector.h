@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+namespace slog {
+
+/**
+ * A vector of trivially copyable elements that keeps up to N elements inline and only
+ * allocates from the heap when it grows beyond that. Meant for short lists that live
+ * inside larger structures, where a separate allocation per list would dominate.
+ */
+template <typename T, size_t N>
+class SmallVector {
+  static_assert(std::is_trivially_copyable_v<T>, "SmallVector only holds trivially copyable elements");
+
+ public:
+  SmallVector() = default;
+
+  SmallVector(const SmallVector& other) { Append(other.begin(), other.size_); }
+
+  SmallVector& operator=(const SmallVector& other) {
+    if (this != &other) {
+      size_ = 0;
+      Append(other.begin(), other.size_);
+    }
+    return *this;
+  }
+
+  SmallVector(SmallVector&& other) noexcept { MoveFrom(other); }
+
+  SmallVector& operator=(SmallVector&& other) noexcept {
+    if (this != &other) {
+      FreeHeap();
+      MoveFrom(other);
+    }
+    return *this;
+  }
+
+  ~SmallVector() { FreeHeap(); }
+
+  void push_back(const T& value) {
+    if (size_ == capacity_) {
+      Grow(capacity_ * 2);
+    }
+    data_[size_++] = value;
+  }
+
+  // Removes the elements in [first, last), keeping the order of the remaining elements
+  T* erase(T* first, T* last) {
+    memmove(first, last, (end() - last) * sizeof(T));
+    size_ -= last - first;
+    return first;
+  }
+
+  T* erase(T* pos) { return erase(pos, pos + 1); }
+
+  void clear() { size_ = 0; }
+
+  T& operator[](size_t i) { return data_[i]; }
+  const T& operator[](size_t i) const { return data_[i]; }
+
+  T* begin() { return data_; }
+  T* end() { return data_ + size_; }
+  const T* begin() const { return data_; }
+  const T* end() const { return data_ + size_; }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  bool is_inline() const { return data_ == inline_; }
+
+ private:
+  void Append(const T* src, uint32_t n) {
+    if (size_ + n > capacity_) {
+      auto new_capacity = capacity_;
+      while (new_capacity < size_ + n) {
+        new_capacity *= 2;
+      }
+      Grow(new_capacity);
+    }
+    if (n > 0) {
+      memcpy(data_ + size_, src, n * sizeof(T));
+    }
+    size_ += n;
+  }
+
+  void Grow(uint32_t new_capacity) {
+    auto new_data = static_cast<T*>(malloc(new_capacity * sizeof(T)));
+    if (new_data == nullptr) {
+      throw std::bad_alloc();
+    }
+    memcpy(new_data, data_, size_ * sizeof(T));
+    FreeHeap();
+    data_ = new_data;
+    capacity_ = new_capacity;
+  }
+
+  void FreeHeap() {
+    if (data_ != inline_) {
+      free(data_);
+      data_ = inline_;
+      capacity_ = N;
+    }
+  }
+
+  // Must only be called when this vector does not own any heap memory
+  void MoveFrom(SmallVector& other) {
+    if (other.data_ == other.inline_) {
+      memcpy(inline_, other.inline_, other.size_ * sizeof(T));
+      size_ = other.size_;
+    } else {
+      data_ = other.data_;
+      size_ = other.size_;
+      capacity_ = other.capacity_;
+      other.data_ = other.inline_;
+      other.capacity_ = N;
+    }
+    other.size_ = 0;
+  }
+
+  T* data_ = inline_;
+  uint32_t size_ = 0;
+  uint32_t capacity_ = N;
+  T inline_[N];
+};
+
+}  // namespace slog
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+namespace slog {
+
+/**
+ * A bounded lock-free queue with a single producer thread and any number of consumer threads.
+ * The items are kept in a ring whose capacity is rounded up to a power of two. Consumers race
+ * for the head of the queue with a CAS, so an item might be read by more than one consumer but
+ * it is only taken by the one that wins the CAS. For this reason, the items must be trivially
+ * copyable.
+ *
+ * Like SpscQueue, Push tells whether the consumers may have found the queue empty so that the
+ * producer only wakes up a consumer when needed.
+ */
+template <typename T>
+class SpmcQueue {
+  static_assert(std::is_trivially_copyable_v<T>, "Items of SpmcQueue must be trivially copyable");
+
+ public:
+  explicit SpmcQueue(size_t capacity) {
+    size_t rounded_capacity = 1;
+    while (rounded_capacity < capacity) {
+      rounded_capacity <<= 1;
+    }
+    items_.reset(new std::atomic<T>[rounded_capacity]);
+    mask_ = rounded_capacity - 1;
+  }
+
+  SpmcQueue(const SpmcQueue&) = delete;
+  SpmcQueue& operator=(const SpmcQueue&) = delete;
+
+  /**
+   * Called by the producer. Returns false if the queue is full. Otherwise, was_empty is set
+   * to whether the queue contains only the new item right after it is published.
+   */
+  bool Push(const T& item, bool& was_empty) {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ > mask_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ > mask_) {
+        return false;
+      }
+    }
+    items_[tail & mask_].store(item, std::memory_order_relaxed);
+    // See SpscQueue::Push for why these are sequentially consistent
+    tail_.store(tail + 1, std::memory_order_seq_cst);
+    cached_head_ = head_.load(std::memory_order_seq_cst);
+    was_empty = cached_head_ == tail;
+    return true;
+  }
+
+  // Called by any consumer. Returns false if the queue is empty
+  bool Pop(T& item) {
+    auto head = head_.load(std::memory_order_seq_cst);
+    for (;;) {
+      if (head == tail_.load(std::memory_order_seq_cst)) {
+        return false;
+      }
+      // The slot may be overwritten by the producer if other consumers have taken this item
+      // in the meantime. In that case, the CAS below fails and the read item is discarded
+      item = items_[head & mask_].load(std::memory_order_relaxed);
+      if (head_.compare_exchange_weak(head, head + 1, std::memory_order_seq_cst)) {
+        return true;
+      }
+    }
+  }
+
+  // Number of items in the queue. It can be stale by the time it is returned
+  size_t size() const {
+    auto head = head_.load(std::memory_order_relaxed);
+    auto tail = tail_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+
+  size_t capacity() const { return mask_ + 1; }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+
+  std::unique_ptr<std::atomic<T>[]> items_;
+  size_t mask_;
+
+  // Shared by the consumers
+  alignas(kCacheLineSize) std::atomic<size_t> head_ = 0;
+
+  // Owned by the producer
+  alignas(kCacheLineSize) std::atomic<size_t> tail_ = 0;
+  size_t cached_head_ = 0;
+};
+
+}  // namespace slog
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+namespace slog {
+
+/**
+ * A bounded lock-free queue with a single producer thread and a single consumer thread.
+ * The items are kept in a ring whose capacity is rounded up to a power of two. Each side
+ * owns one index and keeps a cached copy of the other side's index so that it only touches
+ * the cache line of the other side when the cached index says the queue is full or empty.
+ *
+ * Push tells whether the consumer may have found the queue empty, so the producer only needs
+ * to wake up the consumer in that case. Otherwise, the consumer has not popped the item before
+ * the new one yet and is bound to see the new item when it does.
+ */
+template <typename T>
+class SpscQueue {
+ public:
+  explicit SpscQueue(size_t capacity) {
+    size_t rounded_capacity = 1;
+    while (rounded_capacity < capacity) {
+      rounded_capacity <<= 1;
+    }
+    items_.reset(new T[rounded_capacity]);
+    mask_ = rounded_capacity - 1;
+  }
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  /**
+   * Called by the producer. Returns false if the queue is full. Otherwise, was_empty is set
+   * to whether the queue contains only the new item right after it is published.
+   */
+  bool Push(const T& item, bool& was_empty) {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ > mask_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ > mask_) {
+        return false;
+      }
+    }
+    items_[tail & mask_] = item;
+    // Both the publishing of the item and the check of the head must be sequentially consistent with
+    // their counterparts in Pop. Otherwise, the producer and the consumer could both miss each other
+    tail_.store(tail + 1, std::memory_order_seq_cst);
+    cached_head_ = head_.load(std::memory_order_seq_cst);
+    was_empty = cached_head_ == tail;
+    return true;
+  }
+
+  // Called by the consumer. Returns false if the queue is empty
+  bool Pop(T& item) {
+    auto head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_seq_cst);
+      if (head == cached_tail_) {
+        return false;
+      }
+    }
+    item = items_[head & mask_];
+    head_.store(head + 1, std::memory_order_seq_cst);
+    return true;
+  }
+
+  size_t capacity() const { return mask_ + 1; }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+
+  std::unique_ptr<T[]> items_;
+  size_t mask_;
+
+  // Owned by the consumer
+  alignas(kCacheLineSize) std::atomic<size_t> head_ = 0;
+  size_t cached_tail_ = 0;
+
+  // Owned by the producer
+  alignas(kCacheLineSize) std::atomic<size_t> tail_ = 0;
+  size_t cached_head_ = 0;
+};
+
+}  // namespace slog
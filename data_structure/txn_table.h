@@ -0,0 +1,171 @@
+#pragma once
+
+#include <glog/logging.h>
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "common/types.h"
+
+namespace slog {
+
+/**
+ * A map from txn ids to per-txn objects for the single thread that owns them. Lookups probe
+ * a flat array of slots, each holding a txn id and the id of its entry in a pool of objects.
+ * An erased object is returned to a free list instead of being destroyed, so the next txn
+ * takes it over together with the buffers that it has grown, and admitting or retiring a txn
+ * does not allocate or free once the pool is warmed up. The objects never move, so pointers
+ * to them stay valid until they are erased.
+ *
+ * T must be constructible from the arguments given to TryEmplace and provide:
+ *   void Reset(Args...)  re-initializes a recycled object with the same arguments
+ *   void Clear()         drops what the object holds for its txn but keeps its buffers
+ */
+template <typename T>
+class TxnTable {
+ public:
+  explicit TxnTable(size_t initial_slots = 1 << 12)
+      : slots_(initial_slots, Slot{0, kEmptySlot}), mask_(initial_slots - 1) {
+    DCHECK_EQ(initial_slots & mask_, 0) << "Number of slots must be a power of 2";
+  }
+
+  TxnTable(const TxnTable&) = delete;
+  TxnTable& operator=(const TxnTable&) = delete;
+
+  /**
+   * Returns the object of a txn and whether it was created by this call. A new object is
+   * taken from the free list and reset with args if possible, otherwise it is constructed
+   * with args
+   */
+  template <typename... Args>
+  std::pair<T*, bool> TryEmplace(TxnId txn_id, Args&&... args) {
+    auto i = Hash(txn_id) & mask_;
+    for (; slots_[i].entry != kEmptySlot; i = (i + 1) & mask_) {
+      if (slots_[i].txn_id == txn_id) {
+        return {&entries_[slots_[i].entry], false};
+      }
+    }
+
+    EntryId id;
+    if (free_entries_.empty()) {
+      id = entries_.size();
+      entries_.emplace_back(std::forward<Args>(args)...);
+    } else {
+      id = free_entries_.back();
+      free_entries_.pop_back();
+      entries_[id].Reset(std::forward<Args>(args)...);
+    }
+    slots_[i] = Slot{txn_id, id};
+
+    size_++;
+    if (size_ * 2 > slots_.size()) {
+      Grow();
+    }
+    return {&entries_[id], true};
+  }
+
+  // Returns nullptr if the txn is not in the table
+  T* Find(TxnId txn_id) {
+    for (auto i = Hash(txn_id) & mask_; slots_[i].entry != kEmptySlot; i = (i + 1) & mask_) {
+      if (slots_[i].txn_id == txn_id) {
+        return &entries_[slots_[i].entry];
+      }
+    }
+    return nullptr;
+  }
+
+  // Clears the object of a txn and returns it to the free list. Returns false if the txn is not in the table
+  bool Erase(TxnId txn_id) {
+    auto i = Hash(txn_id) & mask_;
+    for (;; i = (i + 1) & mask_) {
+      if (slots_[i].entry == kEmptySlot) {
+        return false;
+      }
+      if (slots_[i].txn_id == txn_id) {
+        break;
+      }
+    }
+    auto id = slots_[i].entry;
+
+    // Shift back the following slots of the probe sequence to fill in the hole
+    auto j = i;
+    for (;;) {
+      j = (j + 1) & mask_;
+      if (slots_[j].entry == kEmptySlot) {
+        break;
+      }
+      auto home = Hash(slots_[j].txn_id) & mask_;
+      // Move the slot at j to i unless its home position lies cyclically in (i, j]
+      bool home_in_between = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+      if (!home_in_between) {
+        slots_[i] = slots_[j];
+        i = j;
+      }
+    }
+    slots_[i].entry = kEmptySlot;
+    size_--;
+
+    entries_[id].Clear();
+    free_entries_.push_back(id);
+    return true;
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // Number of objects in the pool, including those in the free list
+  size_t num_pooled() const { return entries_.size(); }
+
+  // Calls fn(txn_id, object) for every txn in the table
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    for (const auto& slot : slots_) {
+      if (slot.entry != kEmptySlot) {
+        fn(slot.txn_id, entries_[slot.entry]);
+      }
+    }
+  }
+
+ private:
+  using EntryId = uint32_t;
+
+  static constexpr EntryId kEmptySlot = ~EntryId{0};
+
+  struct Slot {
+    TxnId txn_id;
+    EntryId entry;
+  };
+
+  // Txn ids of a machine share their low bits so they are mixed before being used as positions
+  static size_t Hash(TxnId txn_id) {
+    auto h = txn_id * 0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 32);
+  }
+
+  void Grow() {
+    std::vector<Slot> new_slots(slots_.size() * 2, Slot{0, kEmptySlot});
+    auto new_mask = new_slots.size() - 1;
+    for (const auto& slot : slots_) {
+      if (slot.entry == kEmptySlot) {
+        continue;
+      }
+      auto i = Hash(slot.txn_id) & new_mask;
+      while (new_slots[i].entry != kEmptySlot) {
+        i = (i + 1) & new_mask;
+      }
+      new_slots[i] = slot;
+    }
+    slots_.swap(new_slots);
+    mask_ = new_mask;
+  }
+
+  std::vector<Slot> slots_;
+  size_t mask_;
+  size_t size_ = 0;
+  // A deque keeps the objects in place when it grows
+  std::deque<T> entries_;
+  std::vector<EntryId> free_entries_;
+};
+
+}  // namespace slog
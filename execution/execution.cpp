@@ -4,20 +4,27 @@ namespace slog {
 
 void Execution::ApplyWrites(const Transaction& txn, const SharderPtr& sharder,
                             const std::shared_ptr<Storage>& storage) {
+  std::vector<const Key*> keys;
+  std::vector<Record> records;
+  keys.reserve(txn.keys_size());
+  records.reserve(txn.keys_size());
   for (const auto& kv : txn.keys()) {
     const auto& key = kv.key();
     const auto& value = kv.value_entry();
     if (!sharder->is_local_key(key) || value.type() == KeyType::READ) {
       continue;
     }
-    Record new_record;
+    auto& new_record = records.emplace_back();
     new_record.SetMetadata(value.metadata());
     new_record.SetValue(value.new_value());
-    storage->Write(key, new_record);
+    keys.push_back(&key);
   }
+  std::vector<const Key*> deleted_keys;
+  deleted_keys.reserve(txn.deleted_keys_size());
   for (const auto& key : txn.deleted_keys()) {
-    storage->Delete(key);
+    deleted_keys.push_back(&key);
   }
+  storage->WriteBatch(keys, records, deleted_keys);
 }
 
 }  // namespace slog
\ No newline at end of file
@@ -9,18 +9,52 @@
 
 namespace slog {
 
+/**
+ * Where a procedure resumes after it has been suspended. Procedures run as stackless coroutines:
+ * everything that they need across a suspension is kept here or in the txn, so a suspended txn
+ * holds no stack and a worker can have many of them in flight.
+ */
+struct Continuation {
+  // Index of the next operation of the procedure
+  int pc = 0;
+  // Whether the values of some remote keys are still on their way. The keys that have arrived are
+  // in the txn. A procedure suspends on a missing remote key only while this is set, otherwise
+  // the key is not part of the txn
+  bool remote_values_pending = false;
+  // Set when an operation has failed. The txn aborts once the procedure reaches its end
+  bool failed = false;
+  // Set when the procedure has reached its end
+  bool done = false;
+};
+
 class Execution {
  public:
   virtual ~Execution() = default;
-  virtual void Execute(Transaction& txn) = 0;
+
+  /**
+   * Runs the procedure of a txn from where it was last suspended until it reaches its end or needs
+   * the value of a remote key that has not arrived yet. The procedure is resumed once more values
+   * arrive, as many times as it needs to. Returns true when the procedure has reached its end.
+   * A failed procedure sets the txn to ABORTED. The new values are only staged in the txn until
+   * Commit, since another partition can still abort the txn after the procedure has ended here
+   */
+  virtual bool Resume(Transaction& txn, Continuation& cont) = 0;
+
+  // Applies the staged writes of a txn that has committed
+  virtual void Commit(Transaction& txn) = 0;
 
   static void ApplyWrites(const Transaction& txn, const SharderPtr& sharder, const std::shared_ptr<Storage>& storage);
 };
 
+/**
+ * Only the operations on a remote key wait for it, so a procedure can run its operations on local
+ * keys while the remote keys are still being read by the other partitions
+ */
 class KeyValueExecution : public Execution {
  public:
   KeyValueExecution(const SharderPtr& sharder, const std::shared_ptr<Storage>& storage);
-  void Execute(Transaction& txn) final;
+  bool Resume(Transaction& txn, Continuation& cont) final;
+  void Commit(Transaction& txn) final;
 
  private:
   SharderPtr sharder_;
@@ -29,15 +63,23 @@ class KeyValueExecution : public Execution {
 
 class NoopExecution : public Execution {
  public:
-  void Execute(Transaction& txn) final { txn.set_status(TransactionStatus::COMMITTED); }
+  bool Resume(Transaction&, Continuation&) final { return true; }
+  void Commit(Transaction&) final {}
 };
 
+/**
+ * The TPC-C procedures read all of their keys up front so they wait for all remote keys before they start
+ */
 class TPCCExecution : public Execution {
  public:
   TPCCExecution(const SharderPtr& sharder, const std::shared_ptr<Storage>& storage);
-  void Execute(Transaction& txn) final;
+  bool Resume(Transaction& txn, Continuation& cont) final;
+  void Commit(Transaction& txn) final;
 
  private:
+  // Runs the whole procedure. Sets the txn to ABORTED if it fails
+  void Run(Transaction& txn);
+
   SharderPtr sharder_;
   std::shared_ptr<Storage> storage_;
 };
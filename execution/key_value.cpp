@@ -8,20 +8,31 @@ namespace slog {
 KeyValueExecution::KeyValueExecution(const SharderPtr& sharder, const std::shared_ptr<Storage>& storage)
     : sharder_(sharder), storage_(storage) {}
 
-void KeyValueExecution::Execute(Transaction& txn) {
-  bool aborted = false;
-  std::ostringstream abort_reason;
+bool KeyValueExecution::Resume(Transaction& txn, Continuation& cont) {
+  if (txn.status() == TransactionStatus::ABORTED) {
+    return true;
+  }
+
   std::unordered_map<std::string, int> key_index;
   for (int i = 0; i < txn.keys_size(); i++) {
     key_index.emplace(txn.keys(i).key(), i);
   }
+  // A remote key that has not arrived yet suspends the procedure. Otherwise, a missing key is
+  // not part of the txn and the operation is skipped
+  auto must_wait = [&](const std::string& key) {
+    return cont.remote_values_pending && key_index.find(key) == key_index.end() && !sharder_->is_local_key(key);
+  };
 
-  for (auto& p : txn.code().procedures()) {
-    const auto& args = p.args();
+  const auto& procedures = txn.code().procedures();
+  for (; cont.pc < procedures.size(); cont.pc++) {
+    const auto& args = procedures[cont.pc].args();
     if (args.empty()) {
       continue;
     }
     if (args[0] == "SET") {
+      if (must_wait(args[1])) {
+        return false;
+      }
       auto it = key_index.find(args[1]);
       if (it == key_index.end()) {
         continue;
@@ -32,12 +43,18 @@ void KeyValueExecution::Execute(Transaction& txn) {
       }
       value->set_new_value(args[2]);
     } else if (args[0] == "DEL") {
+      if (must_wait(args[1])) {
+        return false;
+      }
       auto it = key_index.find(args[1]);
       if (it != key_index.end() || txn.keys(it->second).value_entry().type() != KeyType::WRITE) {
         continue;
       }
       txn.mutable_deleted_keys()->Add(std::string(args[1]));
     } else if (args[0] == "COPY") {
+      if (must_wait(args[1]) || must_wait(args[2])) {
+        return false;
+      }
       auto src_it = key_index.find(args[1]);
       auto dst_it = key_index.find(args[2]);
       if (src_it == key_index.end() || dst_it == key_index.end()) {
@@ -50,27 +67,31 @@ void KeyValueExecution::Execute(Transaction& txn) {
       }
       dst_value->set_new_value(src_value.value());
     } else if (args[0] == "EQ") {
+      if (must_wait(args[1])) {
+        return false;
+      }
       auto it = key_index.find(args[1]);
       if (it == key_index.end()) {
         continue;
       }
       const auto& value = txn.keys(it->second).value_entry().value();
       if (value != args[2]) {
-        aborted = true;
+        cont.failed = true;
+        std::ostringstream abort_reason;
         abort_reason << "Key = " << args[1] << ". Expected value = " << args[2] << ". Actual value = " << value;
+        txn.mutable_abort_reason()->append(abort_reason.str());
       }
     } else if (args[0] == "SLEEP") {
       std::this_thread::sleep_for(std::chrono::milliseconds(std::stoi(args[1])));
     }
   }
 
-  if (aborted) {
+  if (cont.failed) {
     txn.set_status(TransactionStatus::ABORTED);
-    txn.set_abort_reason(abort_reason.str());
-  } else {
-    txn.set_status(TransactionStatus::COMMITTED);
-    ApplyWrites(txn, sharder_, storage_);
   }
+  return true;
 }
 
+void KeyValueExecution::Commit(Transaction& txn) { ApplyWrites(txn, sharder_, storage_); }
+
 }  // namespace slog
\ No newline at end of file
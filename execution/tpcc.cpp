@@ -12,7 +12,19 @@ using std::stoll;
 TPCCExecution::TPCCExecution(const SharderPtr& sharder, const std::shared_ptr<Storage>& storage)
     : sharder_(sharder), storage_(storage) {}
 
-void TPCCExecution::Execute(Transaction& txn) {
+bool TPCCExecution::Resume(Transaction& txn, Continuation& cont) {
+  if (cont.remote_values_pending) {
+    return false;
+  }
+  if (txn.status() != TransactionStatus::ABORTED) {
+    Run(txn);
+  }
+  return true;
+}
+
+void TPCCExecution::Commit(Transaction& txn) { ApplyWrites(txn, sharder_, storage_); }
+
+void TPCCExecution::Run(Transaction& txn) {
   auto txn_adapter = std::make_shared<tpcc::TxnStorageAdapter>(txn);
 
   if (txn.code().procedures().empty() || txn.code().procedures(0).args().empty()) {
@@ -147,8 +159,6 @@ void TPCCExecution::Execute(Transaction& txn) {
     txn.set_abort_reason("Unknown procedure name");
     return;
   }
-  txn.set_status(TransactionStatus::COMMITTED);
-  ApplyWrites(txn, sharder_, storage_);
 }
 
 }  // namespace slog
\ No newline at end of file
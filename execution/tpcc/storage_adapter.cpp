@@ -10,12 +10,11 @@ KVStorageAdapter::KVStorageAdapter(const std::shared_ptr<Storage>& storage,
     : storage_(storage), metadata_initializer_(metadata_initializer) {}
 
 const std::string* KVStorageAdapter::Read(const std::string& key) {
-  Record r;
-  auto ok = storage_->Read(key, r);
-  if (!ok) {
+  RecordView r;
+  if (!storage_->ReadView(key, r)) {
     return nullptr;
   }
-  buffer_.push_back(r.to_string());
+  buffer_.emplace_back(r.data(), r.size());
   return &buffer_.back();
 };
 
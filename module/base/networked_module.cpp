@@ -59,6 +59,8 @@ void NetworkedModule::AddCustomSocket(zmq::socket_t&& new_socket) {
 
 zmq::socket_t& NetworkedModule::GetCustomSocket(size_t i) { return custom_sockets_.at(i); }
 
+void NetworkedModule::AddCustomNotifier(const EventNotifier& notifier) { poller_.PushFd(notifier.fd()); }
+
 void NetworkedModule::SetUp() {
   VLOG(1) << "Thread info (" << name() << "): " << debug_info_;
 
@@ -7,6 +7,7 @@
 #include "common/metrics.h"
 #include "common/types.h"
 #include "connection/broker.h"
+#include "connection/event_notifier.h"
 #include "connection/poller.h"
 #include "connection/sender.h"
 #include "connection/zmq_utils.h"
@@ -51,6 +52,9 @@ class NetworkedModule : public Module {
   void AddCustomSocket(zmq::socket_t&& new_socket);
   zmq::socket_t& GetCustomSocket(size_t i);
 
+  // Wakes up the module whenever the notifier is notified. The work behind it is picked up in OnCustomSocket
+  void AddCustomNotifier(const EventNotifier& notifier);
+
   inline static EnvelopePtr NewEnvelope() { return std::make_unique<internal::Envelope>(); }
   void Send(const internal::Envelope& env, MachineId to_machine_id, Channel to_channel);
   void Send(EnvelopePtr&& env, MachineId to_machine_id, Channel to_channel);
@@ -73,22 +73,16 @@ void Forwarder::ProcessForwardTxn(EnvelopePtr&& env) {
   }
 
   bool need_remote_lookup = false;
-  for (auto& kv : *txn->mutable_keys()) {
-    const auto& key = kv.key();
-    auto value = kv.mutable_value_entry();
+  local_keys_.clear();
+  local_key_indices_.clear();
+  for (int i = 0; i < txn->keys_size(); i++) {
+    const auto& key = txn->keys(i).key();
     auto partition = sharder_->compute_partition(key);
 
-    // If this is a local partition, lookup the master info from the local storage
+    // If this is a local partition, lookup the master info from the local storage below
     if (partition == config()->local_partition()) {
-      Metadata metadata;
-      if (lookup_master_index_->GetMasterMetadata(key, metadata)) {
-        value->mutable_metadata()->set_master(metadata.master);
-        value->mutable_metadata()->set_counter(metadata.counter);
-      } else {
-        auto metadata = metadata_initializer_->Compute(key);
-        value->mutable_metadata()->set_master(metadata.master);
-        value->mutable_metadata()->set_counter(metadata.counter);
-      }
+      local_keys_.push_back(&key);
+      local_key_indices_.push_back(i);
     } else {
       // Otherwise, add the key to the appropriate remote lookup master request
       partitioned_lookup_request_[partition].mutable_request()->mutable_lookup_master()->add_keys(key);
@@ -96,6 +90,17 @@ void Forwarder::ProcessForwardTxn(EnvelopePtr&& env) {
     }
   }
 
+  if (!local_keys_.empty()) {
+    lookup_master_index_->GetMasterMetadata(local_keys_, local_metadata_);
+    for (size_t i = 0; i < local_keys_.size(); i++) {
+      auto metadata =
+          local_metadata_[i].has_value() ? *local_metadata_[i] : metadata_initializer_->Compute(*local_keys_[i]);
+      auto value = txn->mutable_keys(local_key_indices_[i])->mutable_value_entry();
+      value->mutable_metadata()->set_master(metadata.master);
+      value->mutable_metadata()->set_counter(metadata.counter);
+    }
+  }
+
   // If there is no need to look master info from remote partitions,
   // forward the txn immediately
   if (!need_remote_lookup) {
@@ -149,24 +154,25 @@ void Forwarder::ProcessLookUpMasterRequest(EnvelopePtr&& env) {
   auto results = lookup_response->mutable_lookup_results();
 
   lookup_response->mutable_txn_ids()->CopyFrom(lookup_master.txn_ids());
-  for (int i = 0; i < lookup_master.keys_size(); i++) {
-    const auto& key = lookup_master.keys(i);
-
+  local_keys_.clear();
+  for (const auto& key : lookup_master.keys()) {
     if (sharder_->is_local_key(key)) {
-      if (Metadata metadata; lookup_master_index_->GetMasterMetadata(key, metadata)) {
-        // If key exists, add the metadata of current key to the response
-        auto key_metadata = results->Add();
-        key_metadata->set_key(key);
-        key_metadata->mutable_metadata()->set_master(metadata.master);
-        key_metadata->mutable_metadata()->set_counter(metadata.counter);
-      } else {
-        // Otherwise, assign it to the default region for new key
-        auto key_metadata = results->Add();
-        key_metadata->set_key(key);
-        auto new_metadata = metadata_initializer_->Compute(key);
-        key_metadata->mutable_metadata()->set_master(new_metadata.master);
-        key_metadata->mutable_metadata()->set_counter(new_metadata.counter);
-      }
+      local_keys_.push_back(&key);
+    }
+  }
+  lookup_master_index_->GetMasterMetadata(local_keys_, local_metadata_);
+  for (size_t i = 0; i < local_keys_.size(); i++) {
+    auto key_metadata = results->Add();
+    key_metadata->set_key(*local_keys_[i]);
+    if (local_metadata_[i].has_value()) {
+      // If key exists, add the metadata of current key to the response
+      key_metadata->mutable_metadata()->set_master(local_metadata_[i]->master);
+      key_metadata->mutable_metadata()->set_counter(local_metadata_[i]->counter);
+    } else {
+      // Otherwise, assign it to the default region for new key
+      auto new_metadata = metadata_initializer_->Compute(*local_keys_[i]);
+      key_metadata->mutable_metadata()->set_master(new_metadata.master);
+      key_metadata->mutable_metadata()->set_counter(new_metadata.counter);
     }
   }
   Send(lookup_env, env->from(), kForwarderChannel);
@@ -220,6 +226,24 @@ void Forwarder::Forward(EnvelopePtr&& env) {
 
   PopulateInvolvedReplicas(*txn);
 
+  // A multi-home snapshot txn would take locks in several regions' orders at the current end of the
+  // local log, where it can deadlock with the lock-only txns of the log, so it falls back to the log
+  if (txn_internal->snapshot() && txn_internal->involved_replicas_size() != 1) {
+    VLOG(3) << "Txn " << txn_id << " is a multi-home read. Sending it through the log instead of the snapshot.";
+    txn_internal->set_snapshot(false);
+  }
+
+  if (txn_internal->snapshot()) {
+    // All keys are in the current partition and have the same home so the scheduler of the same
+    // machine can serve the txn
+    VLOG(3) << "Txn " << txn_id << " is a snapshot read. Sending to the scheduler.";
+
+    RECORD(txn_internal, TransactionEvent::EXIT_FORWARDER_TO_SCHEDULER);
+
+    Send(move(env), kSchedulerChannel);
+    return;
+  }
+
   if (txn_type == TransactionType::SINGLE_HOME) {
     // If this current replica is its home, forward to the sequencer of the same machine
     // Otherwise, forward to the sequencer of a random machine in its home region
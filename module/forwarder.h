@@ -61,6 +61,11 @@ class Forwarder : public NetworkedModule {
   const SharderPtr sharder_;
   std::shared_ptr<LookupMasterIndex> lookup_master_index_;
   std::shared_ptr<MetadataInitializer> metadata_initializer_;
+  // Reused across calls to look up the masters of local keys in one batch. The keys point into the
+  // message being processed and the indices are the positions of the keys in the txn
+  std::vector<const Key*> local_keys_;
+  std::vector<int> local_key_indices_;
+  std::vector<std::optional<Metadata>> local_metadata_;
   std::unordered_map<TxnId, EnvelopePtr> pending_transactions_;
   std::vector<internal::Envelope> partitioned_lookup_request_;
   int batch_size_;
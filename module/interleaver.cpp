@@ -255,26 +255,49 @@ void Interleaver::AdvanceLogs() {
     single_home_logs_[local_replica].AddSlot(slot_id, batch_id, config()->replication_factor() - 1);
   }
 
-  // Advance single-home logs
+  // Advance single-home logs. All batches that become ready here are handed to the scheduler in a
+  // single message where their txns follow the order of the batches
+  EnvelopePtr env;
   for (auto& pair : single_home_logs_) {
     auto& log = pair.second;
     while (log.HasNextBatch()) {
-      EmitBatch(log.NextBatch().second);
+      if (env == nullptr) {
+        env = NewEnvelope();
+      }
+      EmitBatch(log.NextBatch().second, *env->mutable_request()->mutable_forward_txn_batch());
     }
   }
+  if (env != nullptr && !env->request().forward_txn_batch().txns().empty()) {
+    Send(move(env), kSchedulerChannel);
+  }
 }
 
-void Interleaver::EmitBatch(BatchPtr&& batch) {
+void Interleaver::EmitBatch(BatchPtr&& batch, internal::ForwardTransactionBatch& txn_batch) {
   VLOG(1) << "Processing batch " << batch->id() << " from global log";
 
-  auto transactions = Unbatch(batch.get());
-  for (auto txn : transactions) {
-    RECORD(txn->mutable_internal(), TransactionEvent::EXIT_INTERLEAVER);
+  auto transactions = batch->mutable_transactions();
+  if (transactions->empty()) {
+    return;
+  }
+
+  for (auto& txn : *transactions) {
+    auto txn_internal = txn.mutable_internal();
+    // Transfer recorded events from batch to each txn in the batch
+    txn_internal->mutable_events()->MergeFrom(batch->events());
+    RECORD(txn_internal, TransactionEvent::EXIT_INTERLEAVER);
+  }
 
-    auto env = NewEnvelope();
-    auto forward_txn = env->mutable_request()->mutable_forward_txn();
-    forward_txn->set_allocated_txn(txn);
-    Send(move(env), kSchedulerChannel);
+  // The txns are moved without being copied so that the scheduler can acquire their locks in one pass
+  auto txns = txn_batch.mutable_txns();
+  if (txns->empty()) {
+    txns->Swap(transactions);
+    return;
+  }
+  auto num_txns = transactions->size();
+  released_txns_.resize(num_txns);
+  transactions->ExtractSubrange(0, num_txns, released_txns_.data());
+  for (auto txn : released_txns_) {
+    txns->AddAllocated(txn);
   }
 }
 
@@ -2,6 +2,7 @@
 
 #include <queue>
 #include <unordered_map>
+#include <vector>
 
 #include "common/configuration.h"
 #include "common/metrics.h"
@@ -65,12 +66,16 @@ class Interleaver : public NetworkedModule {
   void ProcessForwardBatchOrder(EnvelopePtr&& env);
   void AdvanceLogs();
 
-  void EmitBatch(BatchPtr&& batch);
+  // Moves the txns of a batch to the end of the txns that are going to the scheduler
+  void EmitBatch(BatchPtr&& batch, internal::ForwardTransactionBatch& txn_batch);
 
   std::unordered_map<uint32_t, BatchLog> single_home_logs_;
   LocalLog local_log_;
   std::vector<MachineId> other_partitions_;
   std::vector<bool> need_ack_from_replica_;
+
+  // Reused across batches
+  std::vector<Transaction*> released_txns_;
 };
 
 }  // namespace slog
\ No newline at end of file
@@ -19,15 +19,25 @@ using internal::Response;
 Scheduler::Scheduler(const shared_ptr<Broker>& broker, const shared_ptr<Storage>& storage,
                      const MetricsRepositoryManagerPtr& metrics_manager, std::chrono::milliseconds poll_timeout)
     : NetworkedModule(broker, {kSchedulerChannel, false /* recv_raw */}, metrics_manager, poll_timeout),
+      key_affinity_(kWorkerAffinitySlots, 0),
+      affinity_votes_(config()->num_workers(), 0),
       global_log_counter_(0) {
+  // All queues must exist before the workers are created since a worker may steal from any of them
   for (size_t i = 0; i < config()->num_workers(); i++) {
-    workers_.push_back(MakeRunnerFor<Worker>(i, broker, storage, metrics_manager, poll_timeout));
+    worker_queues_.push_back(std::make_unique<WorkerQueues>(kWorkerQueueCapacity, worker_signal_notifier_));
+  }
+  for (size_t i = 0; i < config()->num_workers(); i++) {
+    workers_.push_back(MakeRunnerFor<Worker>(i, broker, storage, metrics_manager, worker_queues_, poll_timeout));
   }
 
 #if defined(REMASTER_PROTOCOL_SIMPLE) || defined(REMASTER_PROTOCOL_PER_KEY)
   remaster_manager_.SetStorage(storage);
 #endif /* defined(REMASTER_PROTOCOL_SIMPLE) || \
           defined(REMASTER_PROTOCOL_PER_KEY) */
+
+#if defined(LOCK_MANAGER_RMA) || defined(LOCK_MANAGER_DDR)
+  lock_manager_.SetContentionSampleRate(config()->contention_sample_rate());
+#endif
 }
 
 void Scheduler::Initialize() {
@@ -41,12 +51,14 @@ void Scheduler::Initialize() {
     worker->StartInNewThread(cpu);
   }
 
-  zmq::socket_t worker_socket(*context(), ZMQ_DEALER);
-  worker_socket.set(zmq::sockopt::rcvhwm, 0);
-  worker_socket.set(zmq::sockopt::sndhwm, 0);
-  worker_socket.bind(MakeInProcChannelAddress(kWorkerChannel));
+  AddCustomNotifier(worker_signal_notifier_);
 
-  AddCustomSocket(move(worker_socket));
+#if defined(LOCK_MANAGER_SHARDED)
+  AddCustomSocket(lock_manager_.Start(config()->num_lock_manager_shards(),
+                                      config()->cpu_pinnings(ModuleId::LOCK_MANAGER_SHARD), context()));
+#elif defined(LOCK_MANAGER_DDR)
+  NewTimedCallback(config()->ddr_interval(), [this]() { ResolveDeadlocks(); });
+#endif
 }
 
 void Scheduler::OnInternalRequestReceived(EnvelopePtr&& env) {
@@ -54,6 +66,9 @@ void Scheduler::OnInternalRequestReceived(EnvelopePtr&& env) {
     case Request::kForwardTxn:
       ProcessTransaction(move(env));
       break;
+    case Request::kForwardTxnBatch:
+      ProcessTransactionBatch(move(env));
+      break;
     case Request::kStats:
       ProcessStatsRequest(env->request().stats());
       break;
@@ -63,55 +78,222 @@ void Scheduler::OnInternalRequestReceived(EnvelopePtr&& env) {
   }
 }
 
-// Handle responses from the workers
+// Handle signals from the workers
 bool Scheduler::OnCustomSocket() {
-  auto& worker_socket = GetCustomSocket(0);
-  bool has_msg = false;
+  bool has_msg = ProcessWorkerSignals();
+  if (!has_msg) {
+    // The scheduler may go to sleep after this so clear the notifications then check
+    // once more to not miss a signal pushed in between
+    worker_signal_notifier_.Clear();
+    has_msg = ProcessWorkerSignals();
+  }
+
+  // Retry the txns that did not fit into the worker queues. Keep the scheduler awake
+  // until all of them are dispatched since the workers do not notify when there is room
+  while (!pending_dispatches_.empty() && PushToWorker(pending_dispatches_.front())) {
+    pending_dispatches_.pop_front();
+  }
+  has_msg |= !pending_dispatches_.empty();
+
+#if defined(LOCK_MANAGER_SHARDED)
+  // Each message only signals that the shards of the lock manager granted new locks
+  auto& grant_socket = GetCustomSocket(0);
   zmq::message_t msg;
-  while (worker_socket.recv(msg, zmq::recv_flags::dontwait)) {
+  while (grant_socket.recv(msg, zmq::recv_flags::dontwait)) {
     has_msg = true;
-    auto txn_id = *msg.data<TxnId>();
-    // Release locks held by this txn then dispatch the txns that become ready thanks to this release.
-    auto unblocked_txns = lock_manager_.ReleaseLocks(txn_id);
-    for (auto unblocked_txn : unblocked_txns) {
+  }
+  lock_manager_.TakeReadyTxns(ready_txns_);
+  for (auto [txn_id, is_fast] : ready_txns_) {
+    Dispatch(txn_id, is_fast);
+  }
+  ready_txns_.clear();
+#endif
+
+  return has_msg;
+}
+
+bool Scheduler::ProcessWorkerSignals() {
+  bool has_msg = false;
+  WorkerSignal signal;
+  for (auto& queues : worker_queues_) {
+    while (queues->signals.Pop(signal)) {
+      has_msg = true;
+      ProcessWorkerSignal(signal);
+    }
+  }
+  return has_msg;
+}
+
+void Scheduler::ProcessWorkerSignal(const WorkerSignal& signal) {
+  auto [txn_id, generation, type] = signal;
+#if defined(LOCK_MANAGER_RMA)
+  if (type == WorkerSignal::Type::READS_DONE) {
+    // The txn still needs its write locks and holder until it finishes
+    for (auto unblocked_txn : lock_manager_.ReleaseReadLocks(txn_id)) {
       Dispatch(unblocked_txn, false);
     }
+    VLOG(2) << "Released read locks of txn " << txn_id;
+    return;
+  }
+#endif
+  DCHECK(type == WorkerSignal::Type::FINISHED);
+  ReleaseLocks(txn_id);
 
-    VLOG(2) << "Released locks of txn " << txn_id;
+  VLOG(2) << "Released locks of txn " << txn_id;
 
-    auto it = active_txns_.find(txn_id);
-    CHECK(it != active_txns_.end());
-    auto& txn_holder = it->second;
+  auto txn_holder_ptr = active_txns_.Find(txn_id);
+  CHECK(txn_holder_ptr != nullptr);
+  auto& txn_holder = *txn_holder_ptr;
+  DCHECK_EQ(txn_holder.generation(), generation) << "Txn " << txn_id << " finished on a stale holder";
 
 #if defined(REMASTER_PROTOCOL_SIMPLE) || defined(REMASTER_PROTOCOL_PER_KEY)
-    auto remaster_result = txn_holder.remaster_result();
-    // If a remaster transaction, trigger any unblocked txns
-    if (remaster_result.has_value()) {
-      ProcessRemasterResult(remaster_manager_.RemasterOccured(remaster_result->first, remaster_result->second));
-    }
+  auto remaster_result = txn_holder.remaster_result();
+  // If a remaster transaction, trigger any unblocked txns
+  if (remaster_result.has_value()) {
+    ProcessRemasterResult(remaster_manager_.RemasterOccured(remaster_result->first, remaster_result->second));
+  }
 #endif /* defined(REMASTER_PROTOCOL_SIMPLE) || \
           defined(REMASTER_PROTOCOL_PER_KEY) */
 
-    txn_holder.SetDone();
+  txn_holder.SetDone();
 
-    if (txn_holder.is_ready_for_gc()) {
-      active_txns_.erase(it);
-    }
+  if (txn_holder.is_ready_for_gc()) {
+    active_txns_.Erase(txn_id);
   }
+}
 
-  return has_msg;
+// Release locks held by a txn then dispatch the txns that become ready thanks to this release.
+void Scheduler::ReleaseLocks(TxnId txn_id) {
+#if defined(LOCK_MANAGER_SHARDED)
+  // The txns that become ready are collected in OnCustomSocket
+  lock_manager_.ReleaseLocks(txn_id);
+#else
+  auto unblocked_txns = lock_manager_.ReleaseLocks(txn_id);
+  for (auto unblocked_txn : unblocked_txns) {
+    Dispatch(unblocked_txn, false);
+  }
+#endif
 }
 
 void Scheduler::ProcessTransaction(EnvelopePtr&& env) {
   auto txn = env->mutable_request()->mutable_forward_txn()->release_txn();
+  if (txn->internal().snapshot()) {
+    ProcessSnapshotTransaction(txn);
+    return;
+  }
+  if (!AcceptTransaction(txn)) {
+    return;
+  }
+
+#if defined(REMASTER_PROTOCOL_SIMPLE) || defined(REMASTER_PROTOCOL_PER_KEY)
+  SendToRemasterManager(*txn);
+#else
+  SendToLockManager(*txn);
+#endif
+}
+
+/**
+ * A snapshot txn does not come from the global log so it does not advance the log position.
+ * Because it only reads, it is enough to order it after every txn that has entered the
+ * scheduler so far: it goes through the lock manager right away, so it only waits for earlier
+ * txns writing the same keys and later txns never wait for it unless they write those keys.
+ * The Forwarder only sends single-home txns here so the txn has no lock-only txns.
+ */
+void Scheduler::ProcessSnapshotTransaction(Transaction* txn) {
+  auto txn_internal = txn->mutable_internal();
+  auto txn_id = txn_internal->id();
+  DCHECK_EQ(txn_internal->involved_replicas_size(), 1) << "Snapshot txn " << txn_id << " is multi-home";
+  txn_internal->set_home(txn_internal->involved_replicas(0));
+
+  auto [holder_ptr, inserted] = active_txns_.TryEmplace(txn_id, config(), txn);
+  if (!inserted) {
+    LOG(ERROR) << "Already received txn: " << txn_id;
+    delete txn;
+    return;
+  }
+  auto& holder = *holder_ptr;
+
+  RECORD(holder.txn().mutable_internal(), TransactionEvent::ENTER_SCHEDULER);
+  holder.txn().mutable_internal()->add_global_log_positions(txn_internal->home());
+  holder.txn().mutable_internal()->add_global_log_positions(global_log_counter_);
+
+  VLOG(2) << "Accepted snapshot transaction " << txn_id;
+
+#if defined(REMASTER_PROTOCOL_SIMPLE) || defined(REMASTER_PROTOCOL_PER_KEY)
+  SendToRemasterManager(*txn);
+#else
+  SendToLockManager(*txn);
+#endif
+}
+
+void Scheduler::ProcessTransactionBatch(EnvelopePtr&& env) {
+  auto txns = env->mutable_request()->mutable_forward_txn_batch()->mutable_txns();
+
+  batch_txns_.resize(txns->size());
+  for (int i = txns->size() - 1; i >= 0; i--) {
+    batch_txns_[i] = txns->ReleaseLast();
+  }
+
+#if defined(LOCK_MANAGER_RMA) || defined(LOCK_MANAGER_DAG)
+  // Acquire the locks of the whole batch in one pass. A batch merged from several logs can hold more
+  // than one lock-only txn of the same multi-home txn but a txn can appear at most once in a pass, so
+  // the pass is cut before the second one. The txns still acquire their locks in log order
+  size_t pass_begin = 0;
+  size_t num_accepted = 0;
+  batch_txn_ids_.clear();
+  for (auto txn : batch_txns_) {
+    if (!AcceptTransaction(txn)) {
+      continue;
+    }
+    RECORD(txn->mutable_internal(), TransactionEvent::ENTER_LOCK_MANAGER);
+    if (!batch_txn_ids_.insert(txn->internal().id()).second) {
+      AcquireBatchLocks(pass_begin, num_accepted);
+      pass_begin = num_accepted;
+      batch_txn_ids_.clear();
+      batch_txn_ids_.insert(txn->internal().id());
+    }
+    batch_txns_[num_accepted++] = txn;
+  }
+  AcquireBatchLocks(pass_begin, num_accepted);
+#else
+  for (auto txn : batch_txns_) {
+    if (!AcceptTransaction(txn)) {
+      continue;
+    }
+#if defined(REMASTER_PROTOCOL_SIMPLE) || defined(REMASTER_PROTOCOL_PER_KEY)
+    SendToRemasterManager(*txn);
+#else
+    SendToLockManager(*txn);
+#endif
+  }
+#endif /* defined(LOCK_MANAGER_RMA) || defined(LOCK_MANAGER_DAG) */
+}
+
+#if defined(LOCK_MANAGER_RMA) || defined(LOCK_MANAGER_DAG)
+void Scheduler::AcquireBatchLocks(size_t begin, size_t end) {
+  if (begin == end) {
+    return;
+  }
+
+  VLOG(2) << "Trying to acquire locks of a batch of " << end - begin << " txns";
+
+  batch_pass_txns_.assign(batch_txns_.begin() + begin, batch_txns_.begin() + end);
+  batch_ready_txns_.clear();
+  lock_manager_.AcquireLocks(batch_pass_txns_, batch_ready_txns_);
+  for (auto txn_id : batch_ready_txns_) {
+    Dispatch(txn_id, true);
+  }
+}
+#endif
+
+bool Scheduler::AcceptTransaction(Transaction* txn) {
   auto txn_id = txn->internal().id();
-  auto ins = active_txns_.try_emplace(txn_id, config(), txn);
-  auto holder_it = ins.first;
-  auto& holder = holder_it->second;
+  auto [holder_ptr, inserted] = active_txns_.TryEmplace(txn_id, config(), txn);
+  auto& holder = *holder_ptr;
 
   global_log_counter_++;
 
-  if (ins.second) {
+  if (inserted) {
     RECORD(holder.txn().mutable_internal(), TransactionEvent::ENTER_SCHEDULER);
 
     VLOG(2) << "Accepted " << ENUM_NAME(txn->internal().type(), TransactionType) << " transaction (" << txn_id << ", "
@@ -119,7 +301,7 @@ void Scheduler::ProcessTransaction(EnvelopePtr&& env) {
   } else {
     if (!holder.AddLockOnlyTxn(txn)) {
       LOG(ERROR) << "Already received txn: (" << txn_id << ", " << txn->internal().home() << ")";
-      return;
+      return false;
     }
 
     RECORD(holder.txn().mutable_internal(), TransactionEvent::ENTER_SCHEDULER_LO);
@@ -133,16 +315,12 @@ void Scheduler::ProcessTransaction(EnvelopePtr&& env) {
 
   if (holder.is_aborting()) {
     if (holder.is_ready_for_gc()) {
-      active_txns_.erase(holder_it);
+      active_txns_.Erase(txn_id);
     }
-    return;
+    return false;
   }
 
-#if defined(REMASTER_PROTOCOL_SIMPLE) || defined(REMASTER_PROTOCOL_PER_KEY)
-  SendToRemasterManager(*txn);
-#else
-  SendToLockManager(*txn);
-#endif
+  return true;
 }
 
 #if defined(REMASTER_PROTOCOL_SIMPLE) || defined(REMASTER_PROTOCOL_PER_KEY)
@@ -209,8 +387,7 @@ void Scheduler::SendToLockManager(Transaction& txn) {
 }
 
 void Scheduler::Dispatch(TxnId txn_id, bool is_fast) {
-  auto it = active_txns_.find(txn_id);
-  auto& txn_holder = it->second;
+  auto& txn_holder = *active_txns_.Find(txn_id);
 
   if (is_fast) {
     RECORD(txn_holder.txn().mutable_internal(), TransactionEvent::DISPATCHED_FAST);
@@ -220,22 +397,98 @@ void Scheduler::Dispatch(TxnId txn_id, bool is_fast) {
 
   txn_holder.IncNumDispatches();
 
-  zmq::message_t msg(sizeof(TxnHolder*));
-  *msg.data<TxnHolder*>() = &txn_holder;
-  GetCustomSocket(0).send(msg, zmq::send_flags::none);
+#if defined(LOCK_MANAGER_MVCC)
+  lock_manager_.TakeVersions(txn_id, txn_holder.versions());
+#endif
+
+  if (!pending_dispatches_.empty() || !PushToWorker(&txn_holder)) {
+    pending_dispatches_.push_back(&txn_holder);
+  }
 
   VLOG(2) << "Dispatched txn " << txn_id;
 }
 
-// Disable pre-dispatch abort when DDR is used. Removing this method is sufficient to disable the
-// whole mechanism
-#ifdef LOCK_MANAGER_DDR
+bool Scheduler::PushToWorker(TxnHolder* txn_holder) {
+  const auto& txn = txn_holder->txn();
+  auto num_workers = worker_queues_.size();
+  auto chosen = ChooseWorker(txn);
+  for (size_t i = 0; i < num_workers; i++) {
+    auto w = (chosen + i) % num_workers;
+    auto& queues = *worker_queues_[w];
+    // The txn must not be touched after it is pushed because the worker may finish and release it
+    // right away. If the queue is full, the next worker overwrites the affinity
+    for (const auto& kv : txn.keys()) {
+      key_affinity_[std::hash<Key>{}(kv.key()) & (kWorkerAffinitySlots - 1)] = w + 1;
+    }
+    bool was_empty;
+    if (!queues.txns.Push(txn_holder, was_empty)) {
+      continue;
+    }
+    if (was_empty) {
+      queues.worker_notifier.Notify();
+    } else {
+      WakeUpIdleWorker();
+    }
+    return true;
+  }
+  return false;
+}
+
+size_t Scheduler::ChooseWorker(const Transaction& txn) {
+  auto num_workers = worker_queues_.size();
+  std::fill(affinity_votes_.begin(), affinity_votes_.end(), 0);
+  for (const auto& kv : txn.keys()) {
+    if (auto w = key_affinity_[std::hash<Key>{}(kv.key()) & (kWorkerAffinitySlots - 1)]; w > 0) {
+      affinity_votes_[w - 1]++;
+    }
+  }
+  auto preferred = std::max_element(affinity_votes_.begin(), affinity_votes_.end()) - affinity_votes_.begin();
+  if (affinity_votes_[preferred] > 0 && worker_queues_[preferred]->txns.size() < kWorkerAffinityMaxBacklog) {
+    num_affinity_hits_++;
+    return preferred;
+  }
+
+  // Start from a different worker every time to spread the txns among equally loaded workers
+  auto least_loaded = next_worker_;
+  auto min_size = worker_queues_[least_loaded]->txns.size();
+  for (size_t i = 1; i < num_workers && min_size > 0; i++) {
+    auto w = (next_worker_ + i) % num_workers;
+    if (auto size = worker_queues_[w]->txns.size(); size < min_size) {
+      least_loaded = w;
+      min_size = size;
+    }
+  }
+  next_worker_ = (next_worker_ + 1) % num_workers;
+  return least_loaded;
+}
+
+void Scheduler::WakeUpIdleWorker() {
+  for (auto& queues : worker_queues_) {
+    if (queues->idle.load(std::memory_order_relaxed) && queues->idle.exchange(false)) {
+      queues->worker_notifier.Notify();
+      return;
+    }
+  }
+}
+
+#if defined(LOCK_MANAGER_DDR)
+void Scheduler::ResolveDeadlocks() {
+  for (auto txn_id : lock_manager_.ResolveDeadlocks()) {
+    Dispatch(txn_id, false);
+  }
+  NewTimedCallback(config()->ddr_interval(), [this]() { ResolveDeadlocks(); });
+}
+#endif
+
+// Disable pre-dispatch abort when DDR, the dependency graph or the multi-version manager is used since
+// they cannot release txns that are not ready. Removing this method is sufficient to disable the whole mechanism
+#if defined(LOCK_MANAGER_DDR) || defined(LOCK_MANAGER_DAG) || defined(LOCK_MANAGER_MVCC)
 void Scheduler::TriggerPreDispatchAbort(TxnId) {}
 #else
 void Scheduler::TriggerPreDispatchAbort(TxnId txn_id) {
-  auto active_txn_it = active_txns_.find(txn_id);
-  CHECK(active_txn_it != active_txns_.end());
-  auto& txn_holder = active_txn_it->second;
+  auto txn_holder_ptr = active_txns_.Find(txn_id);
+  CHECK(txn_holder_ptr != nullptr);
+  auto& txn_holder = *txn_holder_ptr;
 
   CHECK(!txn_holder.is_aborting()) << "Abort was triggered twice: " << txn_id;
 
@@ -258,20 +511,18 @@ void Scheduler::TriggerPreDispatchAbort(TxnId txn_id) {
 
   // Release locks held by this txn. Enqueue the txns that
   // become ready thanks to this release.
-  auto unblocked_txns = lock_manager_.ReleaseLocks(txn_id);
-  for (auto unblocked_txn : unblocked_txns) {
-    Dispatch(unblocked_txn, false);
-  }
+  ReleaseLocks(txn_id);
 
   // Let a worker handle notifying other partitions and send back to the server.
   txn.set_status(TransactionStatus::ABORTED);
   Dispatch(txn_id, false);
 }
-#endif /* LOCK_MANAGER_DDR */
+#endif /* defined(LOCK_MANAGER_DDR) || defined(LOCK_MANAGER_DAG) || defined(LOCK_MANAGER_MVCC) */
 
 /**
  * {
  *    num_all_txns: <number of active txns>,
+ *    num_pooled_txn_holders: <number of txn holders allocated, including the free ones>,
  *    all_txns (lvl == 0): [<txn id>, ...],
  *    all_txns (lvl >= 1): [
  *      {
@@ -297,16 +548,16 @@ void Scheduler::ProcessStatsRequest(const internal::StatsRequest& stats_request)
 
   // Add stats for current transactions in the system
   stats.AddMember(StringRef(NUM_ALL_TXNS), active_txns_.size(), alloc);
+  stats.AddMember(StringRef(NUM_POOLED_TXN_HOLDERS), active_txns_.num_pooled(), alloc);
   if (level == 0) {
-    stats.AddMember(StringRef(ALL_TXNS),
-                    ToJsonArray(
-                        active_txns_, [](const auto& p) { return p.first; }, alloc),
-                    alloc);
+    rapidjson::Value txn_ids(rapidjson::kArrayType);
+    active_txns_.ForEach([&](TxnId txn_id, const TxnHolder&) { txn_ids.PushBack(txn_id, alloc); });
+    stats.AddMember(StringRef(ALL_TXNS), txn_ids, alloc);
   }
 
   if (level >= 1) {
     rapidjson::Value txns(rapidjson::kArrayType);
-    for (const auto& [txn_id, txn_holder] : active_txns_) {
+    active_txns_.ForEach([&](TxnId txn_id, const TxnHolder& txn_holder) {
       rapidjson::Value txn_obj(rapidjson::kObjectType);
       txn_obj.AddMember(StringRef(TXN_ID), txn_id, alloc)
           .AddMember(StringRef(TXN_DONE), txn_holder.is_done(), alloc)
@@ -318,10 +569,18 @@ void Scheduler::ProcessStatsRequest(const internal::StatsRequest& stats_request)
                      txn_holder.txn().internal().type() == TransactionType::MULTI_HOME_OR_LOCK_ONLY, alloc)
           .AddMember(StringRef(TXN_MULTI_PARTITION), txn_holder.txn().internal().involved_partitions_size() > 1, alloc);
       txns.PushBack(txn_obj, alloc);
-    }
+    });
     stats.AddMember(StringRef(ALL_TXNS), txns, alloc);
   }
 
+  // Add stats of the worker pool
+  uint64_t num_steals = 0;
+  for (const auto& queues : worker_queues_) {
+    num_steals += queues->num_steals.load(std::memory_order_relaxed);
+  }
+  stats.AddMember(StringRef(NUM_AFFINITY_HITS), num_affinity_hits_, alloc);
+  stats.AddMember(StringRef(NUM_STEALS), num_steals, alloc);
+
   // Add stats from the lock manager
   lock_manager_.GetStats(stats, level);
 
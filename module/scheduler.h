@@ -2,7 +2,7 @@
 
 #include <glog/logging.h>
 
-#include <unordered_map>
+#include <deque>
 #include <unordered_set>
 #include <vector>
 
@@ -10,8 +10,10 @@
 #include "common/metrics.h"
 #include "common/types.h"
 #include "connection/broker.h"
+#include "connection/event_notifier.h"
 #include "connection/sender.h"
 #include "data_structure/batch_log.h"
+#include "data_structure/txn_table.h"
 #include "module/scheduler_components/txn_holder.h"
 #include "module/scheduler_components/worker.h"
 #include "storage/storage.h"
@@ -34,6 +36,12 @@
 #include "module/scheduler_components/old_lock_manager.h"
 #elif defined(LOCK_MANAGER_DDR)
 #include "module/scheduler_components/ddr_lock_manager.h"
+#elif defined(LOCK_MANAGER_SHARDED)
+#include "module/scheduler_components/sharded_lock_manager.h"
+#elif defined(LOCK_MANAGER_DAG)
+#include "module/scheduler_components/dependency_graph_manager.h"
+#elif defined(LOCK_MANAGER_MVCC)
+#include "module/scheduler_components/multi_version_manager.h"
 #else
 #include "module/scheduler_components/rma_lock_manager.h"
 #endif
@@ -53,11 +61,25 @@ class Scheduler : public NetworkedModule {
 
   void OnInternalRequestReceived(EnvelopePtr&& env) final;
 
-  // Handle responses from the workers
+  // Handle signals from the workers and, with the sharded lock manager, the transactions
+  // that obtained their locks
   bool OnCustomSocket() final;
 
  private:
   void ProcessTransaction(EnvelopePtr&& env);
+  void ProcessTransactionBatch(EnvelopePtr&& env);
+  // Places a snapshot read-only txn at the current position of the local log
+  void ProcessSnapshotTransaction(Transaction* txn);
+  // Adds a txn to the active txns. Returns false if the txn must not be sent for locks
+  bool AcceptTransaction(Transaction* txn);
+#if defined(LOCK_MANAGER_RMA) || defined(LOCK_MANAGER_DAG)
+  // Acquires the locks of the accepted txns of the current batch in [begin, end) in one pass
+  void AcquireBatchLocks(size_t begin, size_t end);
+#endif
+  // Returns true if any signal was received
+  bool ProcessWorkerSignals();
+  void ProcessWorkerSignal(const WorkerSignal& signal);
+  void ReleaseLocks(TxnId txn_id);
   void ProcessStatsRequest(const internal::StatsRequest& stats_request);
 
 #if defined(REMASTER_PROTOCOL_SIMPLE) || defined(REMASTER_PROTOCOL_PER_KEY)
@@ -72,6 +94,19 @@ class Scheduler : public NetworkedModule {
 
   // Send txn to worker
   void Dispatch(TxnId txn_id, bool is_fast);
+  // Pushes a txn to the queue of the worker chosen by ChooseWorker or, if that queue is full, the next worker
+  // that is not full. Returns false if all queues are full
+  bool PushToWorker(TxnHolder* txn_holder);
+  // Prefers the worker that last ran txns with the same keys as the txn, whose cache is likely the warmest
+  // for them, unless it is backed up. Otherwise, chooses the least loaded worker
+  size_t ChooseWorker(const Transaction& txn);
+  // Wakes up an idle worker so that it can steal the txns that are queued up
+  void WakeUpIdleWorker();
+
+#if defined(LOCK_MANAGER_DDR)
+  // Periodically resolves deadlocks in the lock manager and dispatches the txns freed by this
+  void ResolveDeadlocks();
+#endif
 
   /**
    * Aborts
@@ -98,11 +133,36 @@ class Scheduler : public NetworkedModule {
   OldLockManager lock_manager_;
 #elif defined(LOCK_MANAGER_DDR)
   DDRLockManager lock_manager_;
+#elif defined(LOCK_MANAGER_SHARDED)
+  ShardedLockManager lock_manager_;
+  std::vector<std::pair<TxnId, bool>> ready_txns_;
+#elif defined(LOCK_MANAGER_DAG)
+  DependencyGraphManager lock_manager_;
+#elif defined(LOCK_MANAGER_MVCC)
+  MultiVersionManager lock_manager_;
 #else
   RMALockManager lock_manager_;
 #endif
 
-  std::unordered_map<TxnId, TxnHolder> active_txns_;
+  TxnTable<TxnHolder> active_txns_;
+
+  // Reused across batches
+  std::vector<Transaction*> batch_txns_;
+  std::vector<TxnId> batch_ready_txns_;
+  std::vector<Transaction*> batch_pass_txns_;
+  std::unordered_set<TxnId> batch_txn_ids_;
+
+  // Wakes up the scheduler when a worker sends back a signal
+  EventNotifier worker_signal_notifier_;
+  WorkerQueuesList worker_queues_;
+  size_t next_worker_ = 0;
+  // The worker that was last dispatched a txn accessing a key, indexed by the hash of the key.
+  // A value of 0 means none, otherwise it is the worker index plus one
+  std::vector<uint16_t> key_affinity_;
+  std::vector<uint32_t> affinity_votes_;
+  uint64_t num_affinity_hits_ = 0;
+  // Dispatched txns that are waiting for room in the worker queues
+  std::deque<TxnHolder*> pending_dispatches_;
 
   // This must be defined at the end so that the workers exit before any resources
   // in the scheduler is destroyed
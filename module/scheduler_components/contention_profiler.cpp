@@ -0,0 +1,71 @@
+#include "module/scheduler_components/contention_profiler.h"
+
+#include <algorithm>
+
+#include "common/constants.h"
+#include "common/metrics.h"
+
+namespace slog {
+
+void ContentionProfiler::StartWait(TxnId txn_id, const KeyReplica& key_replica, uint32_t queue_length) {
+  waits_[txn_id].push_back({key_replica, queue_length, std::chrono::steady_clock::now()});
+}
+
+void ContentionProfiler::EndWait(TxnId txn_id, const KeyReplica& key_replica) {
+  auto it = waits_.find(txn_id);
+  if (it == waits_.end()) {
+    return;
+  }
+  auto& waits = it->second;
+  auto wait_it =
+      std::find_if(waits.begin(), waits.end(), [&](const Wait& wait) { return wait.key_replica == key_replica; });
+  if (wait_it == waits.end()) {
+    return;
+  }
+  Record(*wait_it, std::chrono::steady_clock::now());
+  *wait_it = std::move(waits.back());
+  waits.pop_back();
+  if (waits.empty()) {
+    waits_.erase(it);
+  }
+}
+
+void ContentionProfiler::EndWaits(TxnId txn_id) {
+  auto it = waits_.find(txn_id);
+  if (it == waits_.end()) {
+    return;
+  }
+  auto now = std::chrono::steady_clock::now();
+  for (const auto& wait : it->second) {
+    Record(wait, now);
+  }
+  waits_.erase(it);
+}
+
+void ContentionProfiler::Record(const Wait& wait, std::chrono::steady_clock::time_point end_time) {
+  auto wait_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - wait.start_time).count();
+  sketch_.Record(wait.key_replica, wait.queue_length, wait_ns);
+  if (per_thread_metrics_repo != nullptr) {
+    per_thread_metrics_repo->RecordKeyContention(wait.key_replica, wait.queue_length, wait_ns);
+  }
+}
+
+void ContentionProfiler::GetStats(rapidjson::Document& stats, uint32_t level) const {
+  using rapidjson::StringRef;
+
+  auto& alloc = stats.GetAllocator();
+  rapidjson::Value contention(rapidjson::kArrayType);
+  for (const auto& key : sketch_.TopK(level >= 1 ? sketch_.capacity() : 10)) {
+    rapidjson::Value entry(rapidjson::kArrayType);
+    rapidjson::Value key_json(key.key_replica.to_string().c_str(), alloc);
+    entry.PushBack(key_json, alloc)
+        .PushBack(key.num_blocked, alloc)
+        .PushBack(key.error, alloc)
+        .PushBack(key.total_queue_length, alloc)
+        .PushBack(key.total_wait_ns, alloc);
+    contention.PushBack(std::move(entry), alloc);
+  }
+  stats.AddMember(StringRef(CONTENTION), std::move(contention), alloc);
+}
+
+}  // namespace slog
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+
+#include "common/contention_sketch.h"
+#include "common/json_utils.h"
+#include "common/types.h"
+
+namespace slog {
+
+/**
+ * Profiles which keys block txns in a lock manager. Only a sample of the txns are profiled,
+ * chosen by hashing their ids so that all lock-only txns of a multi-home txn are treated the same.
+ * For each sampled txn that is blocked on a key, the lock manager starts a wait and ends it when
+ * the txn gets the lock. The wait is then counted towards the key in a top-K sketch, which is
+ * reported in the stats of the lock manager, and in the sketch of the metrics repository of the
+ * current thread, which is written to the metrics CSV files.
+ *
+ * The counts only cover the sampled txns. Multiply by 100 / sample rate to estimate the counts
+ * over all txns.
+ */
+class ContentionProfiler {
+ public:
+  // Percentage of txns that are sampled. 0 disables profiling
+  void set_sample_rate(uint32_t sample_rate) { sample_rate_ = std::min(sample_rate, 100U); }
+
+  bool is_sampled(TxnId txn_id) const {
+    return sample_rate_ > 0 && (txn_id * 0x9e3779b97f4a7c15ULL) % 100 < sample_rate_;
+  }
+
+  // Starts the wait of a sampled txn on a key that has queue_length txns ahead of it
+  void StartWait(TxnId txn_id, const KeyReplica& key_replica, uint32_t queue_length);
+
+  // Ends the wait of a sampled txn on a key
+  void EndWait(TxnId txn_id, const KeyReplica& key_replica);
+
+  // Ends all waits of a sampled txn. Used when the txn becomes ready or leaves the lock manager
+  void EndWaits(TxnId txn_id);
+
+  /**
+   * Adds the most contended keys to the stats of a lock manager
+   * {
+   *    contention: [
+   *      [<key>, <num blocked>, <error>, <total queue length>, <total wait ns>],
+   *      ...
+   *    ],
+   * }
+   * Only the top 10 keys are reported at level 0
+   */
+  void GetStats(rapidjson::Document& stats, uint32_t level) const;
+
+  const ContentionSketch& sketch() const { return sketch_; }
+
+ private:
+  struct Wait {
+    KeyReplica key_replica;
+    uint32_t queue_length;
+    std::chrono::steady_clock::time_point start_time;
+  };
+
+  void Record(const Wait& wait, std::chrono::steady_clock::time_point end_time);
+
+  uint32_t sample_rate_ = 0;
+  std::unordered_map<TxnId, std::vector<Wait>> waits_;
+  ContentionSketch sketch_;
+};
+
+}  // namespace slog
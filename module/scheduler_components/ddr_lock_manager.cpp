@@ -2,8 +2,11 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+
 using std::make_pair;
 using std::move;
+using std::chrono::steady_clock;
 
 namespace slog {
 
@@ -26,6 +29,19 @@ vector<TxnId> LockQueueTail::AcquireWriteLock(TxnId txn_id) {
   return deps;
 }
 
+void LockQueueTail::Reorder(const LockQueueTail& reordered, const std::function<bool(TxnId)>& in_group) {
+  // A writer outside of the group comes after the whole group so the tail stays the same
+  if (write_lock_requester_.has_value() && !in_group(write_lock_requester_.value())) {
+    return;
+  }
+  write_lock_requester_ = reordered.write_lock_requester_;
+  // The readers outside of the group come after the whole group
+  read_lock_requesters_.erase(std::remove_if(read_lock_requesters_.begin(), read_lock_requesters_.end(), in_group),
+                              read_lock_requesters_.end());
+  read_lock_requesters_.insert(read_lock_requesters_.end(), reordered.read_lock_requesters_.begin(),
+                               reordered.read_lock_requesters_.end());
+}
+
 DDRLockManager::DDRLockManager() {
   lock_table_.reserve(25000000);
   txn_info_.reserve(1000000);
@@ -41,6 +57,7 @@ AcquireLocksResult DDRLockManager::AcquireLocks(const Transaction& txn) {
   auto num_required_locks = is_remaster ? 2 : txn.keys_size();
   auto ins = txn_info_.try_emplace(txn_id, num_required_locks);
 
+  auto is_sampled = contention_profiler_.is_sampled(txn_id);
   int num_relevant_locks = 0;
   vector<TxnId> blocking_txns;
   for (const auto& kv : txn.keys()) {
@@ -49,8 +66,11 @@ AcquireLocksResult DDRLockManager::AcquireLocks(const Transaction& txn) {
     }
     ++num_relevant_locks;
 
-    auto key_replica = MakeKeyReplica(kv.key(), home);
-    auto& lock_queue_tail = lock_table_[key_replica];
+    key_replica_.key.assign(kv.key());
+    key_replica_.replica = home;
+    // The key replica is only copied into the table the first time the lock is requested
+    auto& lock_queue_tail = lock_table_[key_replica_];
+    auto num_blocking_txns = blocking_txns.size();
 
     switch (kv.value_entry().type()) {
       case KeyType::READ: {
@@ -68,6 +88,15 @@ AcquireLocksResult DDRLockManager::AcquireLocks(const Transaction& txn) {
       default:
         LOG(FATAL) << "Invalid lock mode";
     }
+
+    if (is_sampled) {
+      // Only the blocking txns that are still in the lock manager make the current txn wait
+      uint32_t num_ahead = std::count_if(blocking_txns.begin() + num_blocking_txns, blocking_txns.end(),
+                                         [&](TxnId b_txn) { return b_txn != txn_id && txn_info_.count(b_txn); });
+      if (num_ahead > 0) {
+        contention_profiler_.StartWait(txn_id, key_replica_, num_ahead);
+      }
+    }
   }
 
   // Deduplicate the blocking txns list. We throw away this list eventually
@@ -77,6 +106,7 @@ AcquireLocksResult DDRLockManager::AcquireLocks(const Transaction& txn) {
 
   auto& txn_info = ins.first->second;
   txn_info.unarrived_lock_requests -= num_relevant_locks;
+  txn_info.lock_only_txns.push_back(&txn);
 
   // Add current txn to the waited_by list of each blocking txn
   for (auto b_txn = blocking_txns.begin(); b_txn != last; b_txn++) {
@@ -99,8 +129,16 @@ AcquireLocksResult DDRLockManager::AcquireLocks(const Transaction& txn) {
   }
 
   if (txn_info.is_ready()) {
+    if (is_sampled) {
+      contention_profiler_.EndWaits(txn_id);
+    }
     return AcquireLocksResult::ACQUIRED;
   }
+  if (txn_info.is_stalled()) {
+    // The dependencies of the txn are final from now on so it can be checked for deadlocks
+    txn_info.stall_start_time = steady_clock::now();
+    deadlock_candidates_.push_back(txn_id);
+  }
   return AcquireLocksResult::WAITING;
 }
 
@@ -127,16 +165,229 @@ vector<TxnId> DDRLockManager::ReleaseLocks(TxnId txn_id) {
       // txn only becomes ready when its last entry in the waited_by list
       // is accounted for.
       result.push_back(blocked_txn_id);
+      if (contention_profiler_.is_sampled(blocked_txn_id)) {
+        contention_profiler_.EndWaits(blocked_txn_id);
+      }
     }
   }
   txn_info_.erase(txn_id);
   return result;
 }
 
+/**
+ * Deadlocks are found with Tarjan's algorithm on the waited-by graph restricted to the
+ * stalled txns, starting from the candidates only. An edge U -> T means T waits for U.
+ */
+vector<TxnId> DDRLockManager::ResolveDeadlocks() {
+  vector<TxnId> ready_txns;
+  if (deadlock_candidates_.empty()) {
+    return ready_txns;
+  }
+  vector<TxnId> roots;
+  roots.swap(deadlock_candidates_);
+
+  struct Node {
+    uint32_t index;
+    uint32_t low_link;
+    bool on_stack;
+  };
+  unordered_map<TxnId, Node> nodes;
+  vector<TxnId> stack;
+  // The iterative equivalent of the recursion stack, with the position in the waited-by list of each txn
+  vector<pair<TxnId, size_t>> call_stack;
+  vector<TxnId> component;
+  uint32_t next_index = 0;
+
+  auto stalled_info = [this](TxnId txn_id) -> TxnInfo* {
+    auto it = txn_info_.find(txn_id);
+    if (it == txn_info_.end() || !it->second.is_stalled()) {
+      return nullptr;
+    }
+    return &it->second;
+  };
+  auto visit = [&](TxnId txn_id) {
+    nodes[txn_id] = {next_index, next_index, true};
+    next_index++;
+    stack.push_back(txn_id);
+    call_stack.emplace_back(txn_id, 0);
+  };
+
+  for (auto root : roots) {
+    if (nodes.count(root) > 0 || stalled_info(root) == nullptr) {
+      continue;
+    }
+    visit(root);
+    while (!call_stack.empty()) {
+      auto [txn_id, next_edge] = call_stack.back();
+      const auto& waited_by = txn_info_.at(txn_id).waited_by;
+      if (next_edge < waited_by.size()) {
+        call_stack.back().second++;
+        auto next_txn_id = waited_by[next_edge];
+        if (stalled_info(next_txn_id) == nullptr) {
+          continue;
+        }
+        if (auto it = nodes.find(next_txn_id); it == nodes.end()) {
+          visit(next_txn_id);
+        } else if (it->second.on_stack) {
+          auto& node = nodes[txn_id];
+          node.low_link = std::min(node.low_link, it->second.index);
+        }
+        continue;
+      }
+
+      call_stack.pop_back();
+      auto node = nodes[txn_id];
+      if (!call_stack.empty()) {
+        auto& parent = nodes[call_stack.back().first];
+        parent.low_link = std::min(parent.low_link, node.low_link);
+      }
+      if (node.low_link != node.index) {
+        continue;
+      }
+
+      component.clear();
+      TxnId member;
+      do {
+        member = stack.back();
+        stack.pop_back();
+        nodes[member].on_stack = false;
+        component.push_back(member);
+      } while (member != txn_id);
+
+      if (component.size() == 1) {
+        continue;
+      }
+
+      // The component is a deadlock only if its txns do not wait for any txn outside of it
+      std::sort(component.begin(), component.end());
+      auto in_component = [&](TxnId id) { return std::binary_search(component.begin(), component.end(), id); };
+      unordered_map<TxnId, int> num_waiting_inside;
+      for (auto id : component) {
+        for (auto waiter : txn_info_.at(id).waited_by) {
+          if (in_component(waiter)) {
+            num_waiting_inside[waiter]++;
+          }
+        }
+      }
+      bool is_deadlock = std::all_of(component.begin(), component.end(), [&](TxnId id) {
+        return num_waiting_inside[id] == txn_info_.at(id).waiting_for_cnt;
+      });
+
+      if (is_deadlock) {
+        ResolveDeadlock(component, ready_txns);
+      } else {
+        // The txns outside of the component that it waits for may never finish, in which
+        // case the component becomes a deadlock later
+        deadlock_candidates_.insert(deadlock_candidates_.end(), component.begin(), component.end());
+      }
+    }
+  }
+
+  return ready_txns;
+}
+
+void DDRLockManager::ResolveDeadlock(const vector<TxnId>& deadlock, vector<TxnId>& ready_txns) {
+  auto in_deadlock = [&](TxnId id) { return std::binary_search(deadlock.begin(), deadlock.end(), id); };
+
+  VLOG(2) << "Resolving a deadlock of " << deadlock.size() << " txns";
+
+  // Detach the txns from each other. All of their dependencies are among themselves so they
+  // do not wait for anything after this. The txns waiting for them from outside are collected
+  auto now = steady_clock::now();
+  auto stall_time = steady_clock::duration::max();
+  vector<TxnId> waiters;
+  for (auto id : deadlock) {
+    auto& info = txn_info_.at(id);
+    stall_time = std::min(stall_time, now - info.stall_start_time);
+    info.waiting_for_cnt = 0;
+    for (auto waiter : info.waited_by) {
+      if (!in_deadlock(waiter)) {
+        txn_info_.at(waiter).waiting_for_cnt--;
+        waiters.push_back(waiter);
+      }
+    }
+    info.waited_by.clear();
+  }
+
+  // The outside txns requested their locks after the txns of the deadlock so they now wait
+  // for all of them regardless of the new order
+  std::sort(waiters.begin(), waiters.end());
+  waiters.erase(std::unique(waiters.begin(), waiters.end()), waiters.end());
+  for (auto waiter : waiters) {
+    txn_info_.at(waiter).waiting_for_cnt += deadlock.size();
+    for (auto id : deadlock) {
+      txn_info_.at(id).waited_by.push_back(waiter);
+    }
+  }
+
+  // Rebuild the dependencies as if the lock requests on each key arrived in the order of txn ids
+  using LockTableIterator = decltype(lock_table_)::iterator;
+  struct LockRequest {
+    LockTableIterator lock;
+    TxnId txn_id;
+    KeyType type;
+  };
+  vector<LockRequest> requests;
+  for (auto id : deadlock) {
+    for (auto txn : txn_info_.at(id).lock_only_txns) {
+      auto home = txn->internal().home();
+      auto is_remaster = txn->program_case() == Transaction::kRemaster;
+      for (const auto& kv : txn->keys()) {
+        if (!is_remaster && static_cast<int>(kv.value_entry().metadata().master()) != home) {
+          continue;
+        }
+        key_replica_.key.assign(kv.key());
+        key_replica_.replica = home;
+        requests.push_back({lock_table_.find(key_replica_), id, kv.value_entry().type()});
+      }
+    }
+  }
+  // Group the requests by key while keeping the order of txn ids within each group
+  std::stable_sort(requests.begin(), requests.end(),
+                   [](const auto& a, const auto& b) { return &*a.lock < &*b.lock; });
+
+  auto add_dependency = [this](TxnId waiter, TxnId blocker) {
+    if (waiter == blocker) {
+      return;
+    }
+    txn_info_.at(waiter).waiting_for_cnt++;
+    txn_info_.at(blocker).waited_by.push_back(waiter);
+  };
+  for (size_t begin = 0, end; begin < requests.size(); begin = end) {
+    LockQueueTail reordered;
+    for (end = begin; end < requests.size() && requests[end].lock == requests[begin].lock; end++) {
+      const auto& request = requests[end];
+      if (request.type == KeyType::READ) {
+        if (auto blocker = reordered.AcquireReadLock(request.txn_id); blocker.has_value()) {
+          add_dependency(request.txn_id, blocker.value());
+        }
+      } else {
+        for (auto blocker : reordered.AcquireWriteLock(request.txn_id)) {
+          add_dependency(request.txn_id, blocker);
+        }
+      }
+    }
+    requests[begin].lock->second.Reorder(reordered, in_deadlock);
+  }
+
+  for (auto id : deadlock) {
+    if (txn_info_.at(id).is_ready()) {
+      ready_txns.push_back(id);
+    }
+  }
+
+  num_deadlocks_resolved_++;
+  total_deadlock_stall_time_ += stall_time;
+  max_deadlock_stall_time_ = std::max(max_deadlock_stall_time_, stall_time);
+}
+
 /**
  * {
  *    lock_manager_type: 1,
  *    num_txns_waiting_for_lock: <int>,
+ *    num_deadlocks_resolved: <int>,
+ *    total_deadlock_stall_us: <time between the last lock request and the resolution, summed over deadlocks>,
+ *    max_deadlock_stall_us: <int>,
  *    waited_by_graph (lvl >= 1): [
  *      [<txn id>, [<waited by txn id>, ...]],
  *      ...
@@ -149,6 +400,7 @@ vector<TxnId> DDRLockManager::ReleaseLocks(TxnId txn_id) {
  *      ],
  *      ...
  *    ],
+ *    contention: <see ContentionProfiler>
  * }
  */
 void DDRLockManager::GetStats(rapidjson::Document& stats, uint32_t level) const {
@@ -159,6 +411,11 @@ void DDRLockManager::GetStats(rapidjson::Document& stats, uint32_t level) const
   stats.AddMember(StringRef(LOCK_MANAGER_TYPE), 1, alloc);
 
   stats.AddMember(StringRef(NUM_TXNS_WAITING_FOR_LOCK), txn_info_.size(), alloc);
+  stats.AddMember(StringRef(NUM_DEADLOCKS_RESOLVED), num_deadlocks_resolved_, alloc);
+  stats.AddMember(StringRef(TOTAL_DEADLOCK_STALL_US),
+                  std::chrono::duration_cast<std::chrono::microseconds>(total_deadlock_stall_time_).count(), alloc);
+  stats.AddMember(StringRef(MAX_DEADLOCK_STALL_US),
+                  std::chrono::duration_cast<std::chrono::microseconds>(max_deadlock_stall_time_).count(), alloc);
   if (level >= 1) {
     rapidjson::Value waited_by_graph(rapidjson::kArrayType);
     for (const auto& [txn_id, info] : txn_info_) {
@@ -172,9 +429,9 @@ void DDRLockManager::GetStats(rapidjson::Document& stats, uint32_t level) const
   if (level >= 2) {
     // Collect data from lock tables
     rapidjson::Value lock_table(rapidjson::kArrayType);
-    for (const auto& [key, lock_state] : lock_table_) {
+    for (const auto& [key_replica, lock_state] : lock_table_) {
       rapidjson::Value entry(rapidjson::kArrayType);
-      rapidjson::Value key_json(key.c_str(), alloc);
+      rapidjson::Value key_json(key_replica.to_string().c_str(), alloc);
       entry.PushBack(key_json, alloc)
           .PushBack(lock_state.write_lock_requester().value_or(0), alloc)
           .PushBack(ToJsonArray(lock_state.read_lock_requesters(), alloc), alloc);
@@ -182,6 +439,8 @@ void DDRLockManager::GetStats(rapidjson::Document& stats, uint32_t level) const
     }
     stats.AddMember(StringRef(LOCK_TABLE), move(lock_table), alloc);
   }
+
+  contention_profiler_.GetStats(stats, level);
 }
 
 }  // namespace slog
\ No newline at end of file
@@ -6,6 +6,8 @@
 #endif
 #define LOCK_MANAGER
 
+#include <chrono>
+#include <functional>
 #include <list>
 #include <optional>
 #include <unordered_map>
@@ -16,6 +18,8 @@
 #include "common/constants.h"
 #include "common/json_utils.h"
 #include "common/types.h"
+#include "data_structure/small_vector.h"
+#include "module/scheduler_components/contention_profiler.h"
 #include "module/scheduler_components/txn_holder.h"
 
 using std::list;
@@ -39,6 +43,13 @@ class LockQueueTail {
   optional<TxnId> AcquireReadLock(TxnId txn_id);
   vector<TxnId> AcquireWriteLock(TxnId txn_id);
 
+  /**
+   * Replaces the requests of a group of txns with the tail of a queue where these txns
+   * requested the lock in a different order. The group must precede every other txn
+   * that is still in the queue.
+   */
+  void Reorder(const LockQueueTail& reordered, const std::function<bool(TxnId)>& in_group);
+
   /* For debugging */
   optional<TxnId> write_lock_requester() const { return write_lock_requester_; }
 
@@ -61,6 +72,16 @@ class LockQueueTail {
  * between the txns are tracked in a graph, which can be used to deterministically
  * detect and resolve deadlocks.
  *
+ * Deadlocks:
+ * Lock-only txns of multi-home txns come from the logs of different regions, so
+ * two txns can be queued in opposite orders on keys mastered in different regions
+ * and wait for each other forever. A deadlock is a strongly connected component of
+ * the waited-by graph whose txns have all of their lock requests in and do not wait
+ * for any txn outside of it. Such a component depends only on the logs, so every
+ * replica finds the same one. It is resolved by rebuilding the dependencies among
+ * its txns as if their lock requests had arrived in the order of txn ids, and by
+ * making the txns queued behind it wait for the whole component. No txn is aborted.
+ *
  * Remastering:
  * Locks are taken on the tuple <key, replica>, using the transaction's
  * master metadata. The masters are checked in the worker, so if two
@@ -93,6 +114,16 @@ class DDRLockManager {
    */
   vector<TxnId> ReleaseLocks(TxnId txn_id);
 
+  /**
+   * Finds the deadlocks formed since the last call and resolves them. Only the txns
+   * that finished their lock requests without becoming ready since the last call, and
+   * the txns of cycles that were not yet deadlocks, are searched from, so this has to
+   * be called periodically.
+   *
+   * @return IDs of the transactions that become ready after resolving the deadlocks.
+   */
+  vector<TxnId> ResolveDeadlocks();
+
   /**
    * Gets current statistics of the lock manager
    *
@@ -100,17 +131,41 @@ class DDRLockManager {
    */
   void GetStats(rapidjson::Document& stats, uint32_t level) const;
 
+  /**
+   * Sets the percentage of txns whose lock waits are profiled. A sampled txn waits on a key
+   * from the time it is queued behind an unfinished txn until it becomes ready
+   */
+  void SetContentionSampleRate(uint32_t sample_rate) { contention_profiler_.set_sample_rate(sample_rate); }
+
  private:
   struct TxnInfo {
     TxnInfo(int unarrived) : unarrived_lock_requests(unarrived), waiting_for_cnt(0) {}
     vector<TxnId> waited_by;
     int unarrived_lock_requests;
     int waiting_for_cnt;
+    // Lock-only txns that have arrived. They are needed to rebuild the dependencies of a deadlock
+    SmallVector<const Transaction*, 1> lock_only_txns;
+    // Time when the last lock request arrived if the txn was not ready then
+    std::chrono::steady_clock::time_point stall_start_time;
 
     bool is_ready() const { return waiting_for_cnt == 0 && unarrived_lock_requests == 0; }
+    bool is_stalled() const { return unarrived_lock_requests == 0 && waiting_for_cnt > 0; }
   };
+
+  // Resolves a deadlock given the ids of its txns in ascending order
+  void ResolveDeadlock(const vector<TxnId>& deadlock, vector<TxnId>& ready_txns);
+
   unordered_map<TxnId, TxnInfo> txn_info_;
-  unordered_map<KeyReplica, LockQueueTail> lock_table_;
+  unordered_map<KeyReplica, LockQueueTail, KeyReplicaHash> lock_table_;
+  // Reused for lookups so that the key buffer is only allocated once
+  KeyReplica key_replica_;
+  ContentionProfiler contention_profiler_;
+
+  // Stalled txns to search for deadlocks from in the next call to ResolveDeadlocks
+  vector<TxnId> deadlock_candidates_;
+  uint64_t num_deadlocks_resolved_ = 0;
+  std::chrono::steady_clock::duration total_deadlock_stall_time_{0};
+  std::chrono::steady_clock::duration max_deadlock_stall_time_{0};
 };
 
 }  // namespace slog
\ No newline at end of file
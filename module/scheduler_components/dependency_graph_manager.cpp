@@ -0,0 +1,245 @@
+#include "module/scheduler_components/dependency_graph_manager.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+using std::move;
+using std::vector;
+
+namespace slog {
+
+DependencyGraphManager::DependencyGraphManager() { txn_info_.reserve(1000000); }
+
+AcquireLocksResult DependencyGraphManager::AcquireLocks(const Transaction& txn) {
+  batch_accesses_.clear();
+  batch_txns_.clear();
+  CollectAccesses(txn);
+  ResolveBatch();
+  if (batch_txns_[0].second->is_ready()) {
+    return AcquireLocksResult::ACQUIRED;
+  }
+  return AcquireLocksResult::WAITING;
+}
+
+void DependencyGraphManager::AcquireLocks(const vector<Transaction*>& txns, vector<TxnId>& ready_txns) {
+  batch_accesses_.clear();
+  batch_txns_.clear();
+  for (auto txn : txns) {
+    DCHECK(std::none_of(batch_txns_.begin(), batch_txns_.end(),
+                        [id = txn->internal().id()](const auto& entry) { return entry.first == id; }))
+        << "Txn appears twice in a batch: " << txn->internal().id();
+    CollectAccesses(*txn);
+  }
+  ResolveBatch();
+  for (auto [txn_id, txn_info] : batch_txns_) {
+    if (txn_info->is_ready()) {
+      ready_txns.push_back(txn_id);
+    }
+  }
+}
+
+void DependencyGraphManager::CollectAccesses(const Transaction& txn) {
+  auto txn_id = txn.internal().id();
+  auto home = txn.internal().home();
+  auto is_remaster = txn.program_case() == Transaction::kRemaster;
+
+  // A remaster txn only has one key K but it accesses both (K, RO) and (K, RN)
+  // where RO and RN are the old and new region respectively.
+  auto num_required_accesses = is_remaster ? 2 : txn.keys_size();
+  auto& txn_info = txn_info_.try_emplace(txn_id, num_required_accesses).first->second;
+
+  uint32_t txn_index = batch_txns_.size();
+  batch_txns_.emplace_back(txn_id, &txn_info);
+
+  uint32_t replica = home;
+  for (const auto& kv : txn.keys()) {
+    // Skip keys that does not belong to the assigned home. Remaster txn is an exception where
+    // it is allowed that the metadata on the txn does not match its assigned home
+    if (!is_remaster && static_cast<int>(kv.value_entry().metadata().master()) != home) {
+      continue;
+    }
+    batch_accesses_.push_back({KeyReplicaHash{}(kv.key(), replica), &kv.key(), replica, txn_index,
+                               kv.value_entry().type()});
+    txn_info.unarrived_accesses--;
+  }
+}
+
+void DependencyGraphManager::ResolveBatch() {
+  // Group the accesses to the same <key, replica> together. Within a group, the accesses are
+  // in the order of the batch
+  std::sort(batch_accesses_.begin(), batch_accesses_.end(), [](const auto& a, const auto& b) {
+    if (a.hash != b.hash) {
+      return a.hash < b.hash;
+    }
+    if (a.replica != b.replica) {
+      return a.replica < b.replica;
+    }
+    if (auto cmp = a.key->compare(*b.key); cmp != 0) {
+      return cmp < 0;
+    }
+    return a.txn_index < b.txn_index;
+  });
+
+  batch_dependencies_.clear();
+  for (size_t begin = 0, end; begin < batch_accesses_.size(); begin = end) {
+    const auto& first = batch_accesses_[begin];
+    key_replica_.key.assign(*first.key);
+    key_replica_.replica = first.replica;
+    // The key replica is only copied into the table the first time it is accessed
+    auto& entry = *access_table_.try_emplace(key_replica_).first;
+    auto& access = entry.second;
+
+    for (end = begin; end < batch_accesses_.size(); end++) {
+      const auto& request = batch_accesses_[end];
+      if (request.hash != first.hash || request.replica != first.replica || *request.key != *first.key) {
+        break;
+      }
+      auto [txn_id, txn_info] = batch_txns_[request.txn_index];
+      txn_info->accesses.push_back(&entry);
+      access.num_accessors++;
+
+      switch (request.type) {
+        case KeyType::READ:
+          if (access.has_writer) {
+            batch_dependencies_.emplace_back(request.txn_index, access.writer);
+          }
+          access.readers.push_back(txn_id);
+          break;
+        case KeyType::WRITE:
+          // A writer only needs to depend on the readers after the last writer, which
+          // already depend on that writer
+          if (!access.readers.empty()) {
+            for (auto reader : access.readers) {
+              batch_dependencies_.emplace_back(request.txn_index, reader);
+            }
+            access.readers.clear();
+          } else if (access.has_writer) {
+            batch_dependencies_.emplace_back(request.txn_index, access.writer);
+          }
+          access.has_writer = true;
+          access.writer = txn_id;
+          break;
+        default:
+          LOG(FATAL) << "Invalid access type";
+      }
+    }
+  }
+
+  // Each pair of txns is connected by at most one edge
+  std::sort(batch_dependencies_.begin(), batch_dependencies_.end());
+  auto last = std::unique(batch_dependencies_.begin(), batch_dependencies_.end());
+  for (auto dep = batch_dependencies_.begin(); dep != last; dep++) {
+    auto [txn_id, txn_info] = batch_txns_[dep->first];
+    if (dep->second == txn_id) {
+      VLOG(1) << "Txn " << txn_id << " accesses the same key twice";
+      continue;
+    }
+    // Finished txns are pruned from the access table so the dependency always exists
+    auto dep_it = txn_info_.find(dep->second);
+    DCHECK(dep_it != txn_info_.end()) << "Txn " << dep->second << " is in the access table after it finished";
+    if (dep_it == txn_info_.end()) {
+      continue;
+    }
+    txn_info->num_dependencies++;
+    dep_it->second.dependents.push_back(txn_id);
+  }
+}
+
+vector<TxnId> DependencyGraphManager::ReleaseLocks(TxnId txn_id) {
+  vector<TxnId> result;
+  auto txn_info_it = txn_info_.find(txn_id);
+  if (txn_info_it == txn_info_.end()) {
+    return result;
+  }
+  auto& txn_info = txn_info_it->second;
+  if (!txn_info.is_ready()) {
+    LOG(FATAL) << "Releasing unready txn is forbidden";
+  }
+
+  // All txns that this txn depends on have finished so its accesses are no longer
+  // needed to order the txns that come after it
+  for (auto entry : txn_info.accesses) {
+    auto& access = entry->second;
+    if (access.has_writer && access.writer == txn_id) {
+      access.has_writer = false;
+    } else {
+      auto reader = std::find(access.readers.begin(), access.readers.end(), txn_id);
+      if (reader != access.readers.end()) {
+        *reader = access.readers.back();
+        access.readers.pop_back();
+      }
+    }
+    if (--access.num_accessors == 0) {
+      access_table_.erase(entry->first);
+    }
+  }
+
+  for (auto dependent : txn_info.dependents) {
+    auto it = txn_info_.find(dependent);
+    if (it == txn_info_.end()) {
+      LOG(ERROR) << "Dependent txn " << dependent << " does not exist";
+      continue;
+    }
+    auto& dependent_info = it->second;
+    dependent_info.num_dependencies--;
+    if (dependent_info.is_ready()) {
+      result.push_back(dependent);
+    }
+  }
+
+  txn_info_.erase(txn_info_it);
+  return result;
+}
+
+/**
+ * {
+ *    lock_manager_type: 2,
+ *    num_txns_waiting_for_lock: <int>,
+ *    waited_by_graph (lvl >= 1): [
+ *      [<txn id>, [<dependent txn id>, ...]],
+ *      ...
+ *    ],
+ *    lock_table (lvl >= 2): [
+ *      [
+ *        <key>,
+ *        <last writer>,
+ *        [<reader after last writer>, ...],
+ *      ],
+ *      ...
+ *    ],
+ * }
+ */
+void DependencyGraphManager::GetStats(rapidjson::Document& stats, uint32_t level) const {
+  using rapidjson::StringRef;
+
+  auto& alloc = stats.GetAllocator();
+
+  stats.AddMember(StringRef(LOCK_MANAGER_TYPE), 2, alloc);
+
+  stats.AddMember(StringRef(NUM_TXNS_WAITING_FOR_LOCK), txn_info_.size(), alloc);
+  if (level >= 1) {
+    rapidjson::Value waited_by_graph(rapidjson::kArrayType);
+    for (const auto& [txn_id, info] : txn_info_) {
+      rapidjson::Value entry(rapidjson::kArrayType);
+      entry.PushBack(txn_id, alloc).PushBack(ToJsonArray(info.dependents, alloc), alloc);
+      waited_by_graph.PushBack(entry, alloc);
+    }
+    stats.AddMember(StringRef(WAITED_BY_GRAPH), move(waited_by_graph), alloc);
+  }
+
+  if (level >= 2) {
+    rapidjson::Value lock_table(rapidjson::kArrayType);
+    for (const auto& [key_replica, access] : access_table_) {
+      rapidjson::Value entry(rapidjson::kArrayType);
+      rapidjson::Value key_json(key_replica.to_string().c_str(), alloc);
+      entry.PushBack(key_json, alloc)
+          .PushBack(access.has_writer ? access.writer : 0, alloc)
+          .PushBack(ToJsonArray(access.readers, alloc), alloc);
+      lock_table.PushBack(move(entry), alloc);
+    }
+    stats.AddMember(StringRef(LOCK_TABLE), move(lock_table), alloc);
+  }
+}
+
+}  // namespace slog
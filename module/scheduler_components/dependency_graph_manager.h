@@ -0,0 +1,129 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "common/configuration.h"
+#include "common/constants.h"
+#include "common/json_utils.h"
+#include "common/types.h"
+#include "module/scheduler_components/txn_holder.h"
+
+using std::pair;
+using std::shared_ptr;
+using std::unordered_map;
+using std::vector;
+
+namespace slog {
+
+/**
+ * A deterministic concurrency control scheme without lock queues. Since the order
+ * of the log is fixed, the conflicts between transactions are known as soon as they
+ * are appended to the log. This class turns each batch into a dependency graph built
+ * from the declared keys of its transactions and hands out the transactions in
+ * a topological order of that graph: a transaction becomes ready once every earlier
+ * transaction that it conflicts with has finished.
+ *
+ * Within a batch, the accesses are grouped by key in a single sweep. Across batches,
+ * the edges come from an access table that keeps, for each key, the last writer and
+ * the readers after it. Finished transactions are pruned from the access table, so it
+ * only holds the keys accessed by unfinished transactions.
+ *
+ * Like the DDR lock manager, a transaction can only be removed after it is ready. A
+ * transaction removed earlier would let its dependents overtake the transactions
+ * that it depends on.
+ *
+ * Remastering:
+ * Accesses are tracked on the tuple <key, replica> the same as in the RMA lock manager.
+ */
+class DependencyGraphManager {
+ public:
+  DependencyGraphManager();
+
+  /**
+   * Adds a transaction to the dependency graph.
+   *
+   * @param txn The transaction to add.
+   * @return    ACQUIRED if it does not depend on any unfinished transaction,
+   *            WAITING otherwise.
+   */
+  AcquireLocksResult AcquireLocks(const Transaction& txn);
+
+  /**
+   * Adds a batch of transactions to the dependency graph. The outcome is the same as
+   * adding them one by one in order.
+   *
+   * @param txns       The transactions in log order. A transaction must appear at most
+   *                   once in a batch.
+   * @param ready_txns Appended with the IDs of the transactions that do not depend on
+   *                   any unfinished transaction, in the order of the batch.
+   */
+  void AcquireLocks(const std::vector<Transaction*>& txns, std::vector<TxnId>& ready_txns);
+
+  /**
+   * Marks a transaction as finished and removes it from the graph. The transaction
+   * must be ready.
+   *
+   * @param txn_id Id of the finished transaction.
+   * @return       IDs of the transactions that become ready thanks to this.
+   */
+  std::vector<TxnId> ReleaseLocks(TxnId txn_id);
+
+  /**
+   * Gets current statistics of the dependency graph
+   *
+   * @param stats A JSON object where the statistics are stored into
+   */
+  void GetStats(rapidjson::Document& stats, uint32_t level) const;
+
+ private:
+  struct KeyAccess {
+    bool has_writer = false;
+    TxnId writer = 0;
+    // Readers after the last writer
+    std::vector<TxnId> readers;
+    // Number of unfinished txns that accessed this key
+    uint32_t num_accessors = 0;
+  };
+  using AccessTable = std::unordered_map<KeyReplica, KeyAccess, KeyReplicaHash>;
+
+  struct TxnInfo {
+    TxnInfo(int unarrived) : unarrived_accesses(unarrived), num_dependencies(0) {}
+
+    bool is_ready() const { return unarrived_accesses == 0 && num_dependencies == 0; }
+
+    // Keys that are not yet added. Lock-only txns of a multi-home txn add keys separately
+    int unarrived_accesses;
+    // Number of unfinished txns that this txn depends on
+    int num_dependencies;
+    std::vector<TxnId> dependents;
+    // Rehashing the access table invalidates its iterators but not the pointers to its elements
+    std::vector<AccessTable::value_type*> accesses;
+  };
+
+  struct Access {
+    size_t hash;
+    const Key* key;
+    uint32_t replica;
+    // Position of the txn in the batch
+    uint32_t txn_index;
+    KeyType type;
+  };
+
+  // Adds the accesses of a txn to the current batch
+  void CollectAccesses(const Transaction& txn);
+  // Adds the accesses of the current batch to the access table and the edges to the graph
+  void ResolveBatch();
+
+  std::unordered_map<TxnId, TxnInfo> txn_info_;
+  AccessTable access_table_;
+
+  // Reused across batches
+  std::vector<Access> batch_accesses_;
+  std::vector<std::pair<TxnId, TxnInfo*>> batch_txns_;
+  // Pairs of <position of txn in the batch, txn that it depends on>
+  std::vector<std::pair<uint32_t, TxnId>> batch_dependencies_;
+  KeyReplica key_replica_;
+};
+
+}  // namespace slog
@@ -0,0 +1,217 @@
+#include "module/scheduler_components/lock_table.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+using std::pair;
+using std::vector;
+
+namespace slog {
+
+bool LockState::AcquireReadLock(TxnId txn_id) {
+  switch (mode) {
+    case LockMode::UNLOCKED:
+      holders_.push_back(txn_id);
+      mode = LockMode::READ;
+      return true;
+    case LockMode::READ:
+      if (num_waiters() == 0) {
+        holders_.push_back(txn_id);
+        return true;
+      } else {
+        waiters_.push_back({txn_id, LockMode::READ});
+        return false;
+      }
+    case LockMode::WRITE:
+      waiters_.push_back({txn_id, LockMode::READ});
+      return false;
+    default:
+      return false;
+  }
+}
+
+bool LockState::AcquireWriteLock(TxnId txn_id) {
+  switch (mode) {
+    case LockMode::UNLOCKED:
+      holders_.push_back(txn_id);
+      mode = LockMode::WRITE;
+      return true;
+    case LockMode::READ:
+    case LockMode::WRITE:
+      waiters_.push_back({txn_id, LockMode::WRITE});
+      return false;
+    default:
+      return false;
+  }
+}
+
+bool LockState::Contains(TxnId txn_id) const {
+  return std::find(holders_.begin(), holders_.end(), txn_id) != holders_.end() ||
+         std::find_if(waiters_.begin() + waiters_head_, waiters_.end(),
+                      [txn_id](auto& waiter) { return waiter.txn_id == txn_id; }) != waiters_.end();
+}
+
+vector<pair<TxnId, LockMode>> LockState::GetWaiters() const {
+  vector<pair<TxnId, LockMode>> waiters;
+  for (auto it = waiters_.begin() + waiters_head_; it != waiters_.end(); it++) {
+    waiters.emplace_back(it->txn_id, it->mode);
+  }
+  return waiters;
+}
+
+void LockState::PopWaiter() {
+  waiters_head_++;
+  if (waiters_head_ == waiters_.size()) {
+    waiters_.clear();
+    waiters_head_ = 0;
+  } else if (waiters_head_ * 2 >= waiters_.size()) {
+    waiters_.erase(waiters_.begin(), waiters_.begin() + waiters_head_);
+    waiters_head_ = 0;
+  }
+}
+
+void LockState::Release(TxnId txn_id, vector<TxnId>& new_grantees) {
+  // If the transaction is not among the lock holders, find and remove it in
+  // the queue of waiters
+  auto it = std::find(holders_.begin(), holders_.end(), txn_id);
+  if (it == holders_.end()) {
+    auto waiter = std::find_if(waiters_.begin() + waiters_head_, waiters_.end(),
+                               [txn_id](auto& waiter) { return waiter.txn_id == txn_id; });
+    if (waiter != waiters_.end()) {
+      waiters_.erase(waiter);
+      if (num_waiters() == 0) {
+        waiters_.clear();
+        waiters_head_ = 0;
+      }
+    }
+    // No new transaction get the lock
+    return;
+  }
+
+  holders_.erase(it);
+
+  // If there are still holders for this lock, do nothing
+  if (!holders_.empty()) {
+    // No new transaction gets the lock
+    return;
+  }
+
+  // If all holders release the lock but there is no waiter, the current state is
+  // changed to unlocked
+  if (num_waiters() == 0) {
+    mode = LockMode::UNLOCKED;
+    // No new transaction get the lock
+    return;
+  }
+
+  auto front = waiters_[waiters_head_];
+  if (front.mode == LockMode::READ) {
+    // Gives the READ lock to all read transactions at the head of the queue
+    do {
+      holders_.push_back(waiters_[waiters_head_].txn_id);
+      PopWaiter();
+    } while (num_waiters() > 0 && waiters_[waiters_head_].mode == LockMode::READ);
+
+    mode = LockMode::READ;
+
+  } else if (front.mode == LockMode::WRITE) {
+    // Give the WRITE lock to a single transaction at the head of the queue
+    holders_.push_back(front.txn_id);
+    PopWaiter();
+    mode = LockMode::WRITE;
+  }
+  new_grantees.insert(new_grantees.end(), holders_.begin(), holders_.end());
+}
+
+LockTable::LockTable(size_t initial_slots) : slots_(initial_slots, Slot{0, kEmptySlot}), mask_(initial_slots - 1) {
+  DCHECK_EQ(initial_slots & mask_, 0) << "Number of slots must be a power of 2";
+}
+
+LockTable::EntryId LockTable::FindOrInsert(const Key& key, uint32_t replica, size_t hash) {
+  auto i = hash & mask_;
+  for (;; i = (i + 1) & mask_) {
+    const auto& slot = slots_[i];
+    if (slot.entry == kEmptySlot) {
+      break;
+    }
+    if (slot.hash == hash) {
+      const auto& key_replica = entries_[slot.entry].key_replica;
+      if (key_replica.replica == replica && key_replica.key == key) {
+        return slot.entry;
+      }
+    }
+  }
+
+  EntryId id;
+  if (free_entries_.empty()) {
+    id = entries_.size();
+    entries_.emplace_back();
+  } else {
+    id = free_entries_.back();
+    free_entries_.pop_back();
+  }
+  auto& entry = entries_[id];
+  // Reuses the buffer of the key if the entry is recycled
+  entry.key_replica.key.assign(key);
+  entry.key_replica.replica = replica;
+  entry.hash = hash;
+  slots_[i] = Slot{hash, id};
+
+  size_++;
+  if (size_ * 2 > slots_.size()) {
+    Grow();
+  }
+  return id;
+}
+
+size_t LockTable::FindSlot(size_t hash, EntryId id) const {
+  auto i = hash & mask_;
+  while (slots_[i].entry != id) {
+    DCHECK(slots_[i].entry != kEmptySlot) << "Entry is not in the lock table";
+    i = (i + 1) & mask_;
+  }
+  return i;
+}
+
+void LockTable::Erase(EntryId id) {
+  DCHECK(entries_[id].lock_state.is_free()) << "Erasing a lock that is in use";
+  auto i = FindSlot(entries_[id].hash, id);
+  // Shift back the following slots of the probe sequence to fill in the hole
+  auto j = i;
+  for (;;) {
+    j = (j + 1) & mask_;
+    if (slots_[j].entry == kEmptySlot) {
+      break;
+    }
+    auto home = slots_[j].hash & mask_;
+    // Move the slot at j to i unless its home position lies cyclically in (i, j]
+    bool home_in_between = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+    if (!home_in_between) {
+      slots_[i] = slots_[j];
+      i = j;
+    }
+  }
+  slots_[i].entry = kEmptySlot;
+  size_--;
+  free_entries_.push_back(id);
+}
+
+void LockTable::Grow() {
+  vector<Slot> new_slots(slots_.size() * 2, Slot{0, kEmptySlot});
+  auto new_mask = new_slots.size() - 1;
+  for (const auto& slot : slots_) {
+    if (slot.entry == kEmptySlot) {
+      continue;
+    }
+    auto i = slot.hash & new_mask;
+    while (new_slots[i].entry != kEmptySlot) {
+      i = (i + 1) & new_mask;
+    }
+    new_slots[i] = slot;
+  }
+  slots_.swap(new_slots);
+  mask_ = new_mask;
+}
+
+}  // namespace slog
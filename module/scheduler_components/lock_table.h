@@ -0,0 +1,122 @@
+#pragma once
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "common/types.h"
+#include "data_structure/small_vector.h"
+
+namespace slog {
+
+/**
+ * An object of this class represents the locking state of a key.
+ * It contains the IDs of transactions that are holding and waiting
+ * the lock and the mode of the lock. The holders and the waiters are
+ * kept inline for the common case of a lightly contended key.
+ */
+class LockState {
+ public:
+  bool AcquireReadLock(TxnId txn_id);
+  bool AcquireWriteLock(TxnId txn_id);
+
+  /**
+   * Releases the lock held or waited for by a txn. The txns that are granted
+   * the lock thanks to this release are appended to new_grantees.
+   */
+  void Release(TxnId txn_id, std::vector<TxnId>& new_grantees);
+  bool Contains(TxnId txn_id) const;
+
+  // No txn is holding or waiting for the lock
+  bool is_free() const { return mode == LockMode::UNLOCKED && num_waiters() == 0; }
+
+  // Number of txns holding or waiting for the lock
+  size_t queue_length() const { return holders_.size() + num_waiters(); }
+
+  LockMode mode = LockMode::UNLOCKED;
+
+  /* For debugging */
+  const SmallVector<TxnId, 2>& GetHolders() const { return holders_; }
+
+  /* For debugging */
+  std::vector<std::pair<TxnId, LockMode>> GetWaiters() const;
+
+ private:
+  struct Waiter {
+    TxnId txn_id;
+    LockMode mode;
+  };
+
+  size_t num_waiters() const { return waiters_.size() - waiters_head_; }
+  void PopWaiter();
+
+  SmallVector<TxnId, 2> holders_;
+  // Waiters before waiters_head_ have already been granted the lock. They are
+  // dropped once they make up half of the queue so that popping stays cheap
+  SmallVector<Waiter, 2> waiters_;
+  uint32_t waiters_head_ = 0;
+};
+
+/**
+ * A lock table keyed by <key, replica>. Lookups probe a flat array of slots, each holding the
+ * hash of a key replica and the id of its entry in a pool of entries. An entry is returned to
+ * a free list as soon as its lock is free, so the table only holds the keys that are in use at
+ * the same time and the key buffers of recycled entries are reused without allocating.
+ */
+class LockTable {
+ public:
+  using EntryId = uint32_t;
+
+  explicit LockTable(size_t initial_slots = 1 << 16);
+
+  // Finds the entry of <key, replica>, creating one if it does not exist
+  EntryId FindOrInsert(const Key& key, uint32_t replica) {
+    return FindOrInsert(key, replica, KeyReplicaHash{}(key, replica));
+  }
+
+  // Same as above but with the hash of <key, replica> already computed by KeyReplicaHash
+  EntryId FindOrInsert(const Key& key, uint32_t replica, size_t hash);
+
+  // Removes an entry from the table. Its lock must be free
+  void Erase(EntryId id);
+
+  LockState& lock_state(EntryId id) { return entries_[id].lock_state; }
+  const KeyReplica& key_replica(EntryId id) const { return entries_[id].key_replica; }
+  size_t size() const { return size_; }
+
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    for (const auto& slot : slots_) {
+      if (slot.entry != kEmptySlot) {
+        const auto& entry = entries_[slot.entry];
+        fn(entry.key_replica, entry.lock_state);
+      }
+    }
+  }
+
+ private:
+  static constexpr EntryId kEmptySlot = ~EntryId{0};
+
+  struct Slot {
+    size_t hash;
+    EntryId entry;
+  };
+
+  struct Entry {
+    KeyReplica key_replica;
+    size_t hash;
+    LockState lock_state;
+  };
+
+  size_t FindSlot(size_t hash, EntryId id) const;
+  void Grow();
+
+  std::vector<Slot> slots_;
+  size_t mask_;
+  size_t size_ = 0;
+  // A deque keeps the entries in place when it grows
+  std::deque<Entry> entries_;
+  std::vector<EntryId> free_entries_;
+};
+
+}  // namespace slog
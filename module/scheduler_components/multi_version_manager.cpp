@@ -0,0 +1,186 @@
+#include "module/scheduler_components/multi_version_manager.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+using std::make_shared;
+using std::move;
+using std::vector;
+
+namespace slog {
+
+MultiVersionManager::MultiVersionManager() { txn_info_.reserve(1000000); }
+
+AcquireLocksResult MultiVersionManager::AcquireLocks(const Transaction& txn) {
+  auto txn_id = txn.internal().id();
+  auto home = txn.internal().home();
+  auto is_remaster = txn.program_case() == Transaction::kRemaster;
+
+  // A remaster txn only has one key K but it accesses both (K, RO) and (K, RN)
+  // where RO and RN are the old and new region respectively.
+  auto num_required_accesses = is_remaster ? 2 : txn.keys_size();
+  auto& txn_info = txn_info_.try_emplace(txn_id, num_required_accesses).first->second;
+
+  dependencies_.clear();
+  key_replica_.replica = home;
+  for (const auto& kv : txn.keys()) {
+    // Skip keys that does not belong to the assigned home. Remaster txn is an exception where
+    // it is allowed that the metadata on the txn does not match its assigned home
+    if (!is_remaster && static_cast<int>(kv.value_entry().metadata().master()) != home) {
+      continue;
+    }
+    key_replica_.key.assign(kv.key());
+    auto& entry = *version_table_.try_emplace(key_replica_).first;
+    auto& key_versions = entry.second;
+    txn_info.accesses.push_back(&entry);
+    txn_info.unarrived_accesses--;
+    key_versions.num_accessors++;
+
+    // Both readers and writers read the newest version so they wait for its writer
+    if (key_versions.has_writer) {
+      dependencies_.push_back(key_versions.writer);
+    }
+
+    switch (kv.value_entry().type()) {
+      case KeyType::READ:
+        if (key_versions.version == nullptr) {
+          key_versions.version = make_shared<Version>();
+        }
+        txn_info.versions.reads.emplace_back(kv.key(), key_versions.version);
+        break;
+      case KeyType::WRITE:
+        // The version needs to be captured only if some reader still holds it
+        if (key_versions.version != nullptr && key_versions.version.use_count() > 1) {
+          txn_info.versions.captures.emplace_back(kv.key(), move(key_versions.version));
+        }
+        key_versions.version = nullptr;
+        key_versions.has_writer = true;
+        key_versions.writer = txn_id;
+        break;
+      default:
+        LOG(FATAL) << "Invalid access type";
+    }
+  }
+
+  // Each pair of txns is connected by at most one edge
+  std::sort(dependencies_.begin(), dependencies_.end());
+  auto last = std::unique(dependencies_.begin(), dependencies_.end());
+  for (auto dep = dependencies_.begin(); dep != last; dep++) {
+    if (*dep == txn_id) {
+      continue;
+    }
+    // Finished txns are removed from the writer slots so the dependency always exists
+    auto dep_it = txn_info_.find(*dep);
+    DCHECK(dep_it != txn_info_.end()) << "Txn " << *dep << " is a writer after it finished";
+    if (dep_it == txn_info_.end()) {
+      continue;
+    }
+    txn_info.num_dependencies++;
+    dep_it->second.dependents.push_back(txn_id);
+  }
+
+  if (txn_info.is_ready()) {
+    return AcquireLocksResult::ACQUIRED;
+  }
+  return AcquireLocksResult::WAITING;
+}
+
+void MultiVersionManager::TakeVersions(TxnId txn_id, VersionSet& versions) {
+  auto it = txn_info_.find(txn_id);
+  if (it == txn_info_.end()) {
+    return;
+  }
+  versions = move(it->second.versions);
+}
+
+vector<TxnId> MultiVersionManager::ReleaseLocks(TxnId txn_id) {
+  vector<TxnId> result;
+  auto txn_info_it = txn_info_.find(txn_id);
+  if (txn_info_it == txn_info_.end()) {
+    return result;
+  }
+  auto& txn_info = txn_info_it->second;
+  if (!txn_info.is_ready()) {
+    LOG(FATAL) << "Releasing unready txn is forbidden";
+  }
+
+  for (auto entry : txn_info.accesses) {
+    auto& key_versions = entry->second;
+    if (key_versions.has_writer && key_versions.writer == txn_id) {
+      key_versions.has_writer = false;
+    }
+    if (--key_versions.num_accessors == 0) {
+      version_table_.erase(entry->first);
+    }
+  }
+
+  for (auto dependent : txn_info.dependents) {
+    auto it = txn_info_.find(dependent);
+    if (it == txn_info_.end()) {
+      LOG(ERROR) << "Dependent txn " << dependent << " does not exist";
+      continue;
+    }
+    auto& dependent_info = it->second;
+    dependent_info.num_dependencies--;
+    if (dependent_info.is_ready()) {
+      result.push_back(dependent);
+    }
+  }
+
+  txn_info_.erase(txn_info_it);
+  return result;
+}
+
+/**
+ * {
+ *    lock_manager_type: 2,
+ *    num_txns_waiting_for_lock: <int>,
+ *    waited_by_graph (lvl >= 1): [
+ *      [<txn id>, [<dependent txn id>, ...]],
+ *      ...
+ *    ],
+ *    lock_table (lvl >= 2): [
+ *      [
+ *        <key>,
+ *        <writer of the newest version>,
+ *        [],
+ *      ],
+ *      ...
+ *    ],
+ * }
+ */
+void MultiVersionManager::GetStats(rapidjson::Document& stats, uint32_t level) const {
+  using rapidjson::StringRef;
+
+  auto& alloc = stats.GetAllocator();
+
+  stats.AddMember(StringRef(LOCK_MANAGER_TYPE), 2, alloc);
+
+  stats.AddMember(StringRef(NUM_TXNS_WAITING_FOR_LOCK), txn_info_.size(), alloc);
+  if (level >= 1) {
+    rapidjson::Value waited_by_graph(rapidjson::kArrayType);
+    for (const auto& [txn_id, info] : txn_info_) {
+      rapidjson::Value entry(rapidjson::kArrayType);
+      entry.PushBack(txn_id, alloc).PushBack(ToJsonArray(info.dependents, alloc), alloc);
+      waited_by_graph.PushBack(entry, alloc);
+    }
+    stats.AddMember(StringRef(WAITED_BY_GRAPH), move(waited_by_graph), alloc);
+  }
+
+  if (level >= 2) {
+    rapidjson::Value lock_table(rapidjson::kArrayType);
+    for (const auto& [key_replica, key_versions] : version_table_) {
+      rapidjson::Value entry(rapidjson::kArrayType);
+      rapidjson::Value key_json(key_replica.to_string().c_str(), alloc);
+      // Readers are not tracked here since writers never wait for them
+      entry.PushBack(key_json, alloc)
+          .PushBack(key_versions.has_writer ? key_versions.writer : 0, alloc)
+          .PushBack(rapidjson::Value(rapidjson::kArrayType), alloc);
+      lock_table.PushBack(move(entry), alloc);
+    }
+    stats.AddMember(StringRef(LOCK_TABLE), move(lock_table), alloc);
+  }
+}
+
+}  // namespace slog
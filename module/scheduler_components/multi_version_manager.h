@@ -0,0 +1,108 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "common/configuration.h"
+#include "common/constants.h"
+#include "common/json_utils.h"
+#include "common/types.h"
+#include "module/scheduler_components/txn_holder.h"
+#include "module/scheduler_components/version.h"
+
+using std::pair;
+using std::shared_ptr;
+using std::unordered_map;
+using std::vector;
+
+namespace slog {
+
+/**
+ * A multi-version deterministic concurrency control scheme in the style of Bohm. Each
+ * write creates a placeholder for a new version of the key in log order, and each read
+ * is bound to the version created by the last write before it. As a result:
+ *  - a reader waits for the writer of the version that it reads but never for the
+ *    writers after it,
+ *  - a writer waits for the writer of the previous version, from which it reads the
+ *    current value, but never for the readers of that version.
+ *
+ * Only the newest version of a key lives in the storage. A writer that overwrites a key
+ * whose current version still has readers captures that version before writing (see
+ * Version). Versions are reference counted, so an old version is garbage collected once
+ * the readers that can need it and its capturing writer are gone.
+ *
+ * Like the DDR lock manager, a transaction can only be removed after it is ready.
+ *
+ * Remastering:
+ * Versions are tracked on the tuple <key, replica> the same as in the RMA lock manager.
+ */
+class MultiVersionManager {
+ public:
+  MultiVersionManager();
+
+  /**
+   * Binds the keys of a transaction to their versions.
+   *
+   * @param txn The transaction to add.
+   * @return    ACQUIRED if all versions that it reads are already written,
+   *            WAITING otherwise.
+   */
+  AcquireLocksResult AcquireLocks(const Transaction& txn);
+
+  /**
+   * Moves out the versions that a ready transaction reads and captures. They must be
+   * handed to the worker executing the transaction.
+   */
+  void TakeVersions(TxnId txn_id, VersionSet& versions);
+
+  /**
+   * Marks a transaction as finished. The transaction must be ready.
+   *
+   * @param txn_id Id of the finished transaction.
+   * @return       IDs of the transactions that become ready thanks to this.
+   */
+  std::vector<TxnId> ReleaseLocks(TxnId txn_id);
+
+  /**
+   * Gets current statistics of the version manager
+   *
+   * @param stats A JSON object where the statistics are stored into
+   */
+  void GetStats(rapidjson::Document& stats, uint32_t level) const;
+
+ private:
+  struct KeyVersions {
+    // Writer of the newest version if it has not finished
+    bool has_writer = false;
+    TxnId writer = 0;
+    // Newest version if any reader has been bound to it
+    VersionPtr version;
+    // Number of unfinished txns that accessed this key
+    uint32_t num_accessors = 0;
+  };
+  using VersionTable = std::unordered_map<KeyReplica, KeyVersions, KeyReplicaHash>;
+
+  struct TxnInfo {
+    TxnInfo(int unarrived) : unarrived_accesses(unarrived), num_dependencies(0) {}
+
+    bool is_ready() const { return unarrived_accesses == 0 && num_dependencies == 0; }
+
+    // Keys that are not yet added. Lock-only txns of a multi-home txn add keys separately
+    int unarrived_accesses;
+    // Number of unfinished txns that this txn depends on
+    int num_dependencies;
+    std::vector<TxnId> dependents;
+    // Rehashing the version table invalidates its iterators but not the pointers to its elements
+    std::vector<VersionTable::value_type*> accesses;
+    VersionSet versions;
+  };
+
+  std::unordered_map<TxnId, TxnInfo> txn_info_;
+  VersionTable version_table_;
+
+  // Reused across calls
+  std::vector<TxnId> dependencies_;
+  KeyReplica key_replica_;
+};
+
+}  // namespace slog
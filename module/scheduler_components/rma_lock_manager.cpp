@@ -9,101 +9,7 @@ using std::move;
 
 namespace slog {
 
-bool LockState::AcquireReadLock(TxnId txn_id) {
-  switch (mode) {
-    case LockMode::UNLOCKED:
-      holders_.push_back(txn_id);
-      mode = LockMode::READ;
-      return true;
-    case LockMode::READ:
-      if (waiter_queue_.empty()) {
-        holders_.push_back(txn_id);
-        return true;
-      } else {
-        waiter_queue_.push_back(make_pair(txn_id, LockMode::READ));
-        return false;
-      }
-    case LockMode::WRITE:
-      waiter_queue_.push_back(make_pair(txn_id, LockMode::READ));
-      return false;
-    default:
-      return false;
-  }
-}
-
-bool LockState::AcquireWriteLock(TxnId txn_id) {
-  switch (mode) {
-    case LockMode::UNLOCKED:
-      holders_.push_back(txn_id);
-      mode = LockMode::WRITE;
-      return true;
-    case LockMode::READ:
-    case LockMode::WRITE:
-      waiter_queue_.push_back(make_pair(txn_id, LockMode::WRITE));
-      return false;
-    default:
-      return false;
-  }
-}
-
-bool LockState::Contains(TxnId txn_id) {
-  return std::find(holders_.begin(), holders_.end(), txn_id) != holders_.end() ||
-         std::find_if(waiter_queue_.begin(), waiter_queue_.end(),
-                      [txn_id](auto& pair) { return pair.first == txn_id; }) != waiter_queue_.end();
-}
-
-vector<TxnId> LockState::Release(TxnId txn_id) {
-  // If the transaction is not among the lock holders, find and remove it in
-  // the queue of waiters
-  auto it = std::find(holders_.begin(), holders_.end(), txn_id);
-  if (it == holders_.end()) {
-    waiter_queue_.erase(std::remove_if(waiter_queue_.begin(), waiter_queue_.end(),
-                                       [txn_id](auto& pair) { return pair.first == txn_id; }),
-                        waiter_queue_.end());
-    // No new transaction get the lock
-    return {};
-  }
-
-  holders_.erase(it);
-
-  // If there are still holders for this lock, do nothing
-  if (!holders_.empty()) {
-    // No new transaction gets the lock
-    return {};
-  }
-
-  // If all holders release the lock but there is no waiter, the current state is
-  // changed to unlocked
-  if (waiter_queue_.empty()) {
-    mode = LockMode::UNLOCKED;
-    // No new transaction get the lock
-    return {};
-  }
-
-  auto front = waiter_queue_.front();
-  if (front.second == LockMode::READ) {
-    // Gives the READ lock to all read transactions at the head of the queue
-    do {
-      auto txn_id = waiter_queue_.front().first;
-      holders_.push_back(txn_id);
-      waiter_queue_.pop_front();
-    } while (!waiter_queue_.empty() && waiter_queue_.front().second == LockMode::READ);
-
-    mode = LockMode::READ;
-
-  } else if (front.second == LockMode::WRITE) {
-    // Give the WRITE lock to a single transaction at the head of the queue
-    holders_.push_back(front.first);
-    waiter_queue_.pop_front();
-    mode = LockMode::WRITE;
-  }
-  return holders_;
-}
-
-RMALockManager::RMALockManager() {
-  lock_table_.reserve(25000000);
-  txn_info_.reserve(1000000);
-}
+RMALockManager::RMALockManager() { txn_info_.reserve(1000000); }
 
 AcquireLocksResult RMALockManager::AcquireLocks(const Transaction& txn) {
   auto txn_id = txn.internal().id();
@@ -115,6 +21,7 @@ AcquireLocksResult RMALockManager::AcquireLocks(const Transaction& txn) {
   auto num_required_locks = is_remaster ? 2 : txn.keys_size();
   auto ins = txn_info_.try_emplace(txn_id, num_required_locks);
   auto& txn_info = ins.first->second;
+  auto is_sampled = contention_profiler_.is_sampled(txn_id);
 
   for (const auto& kv : txn.keys()) {
     // Skip keys that does not belong to the assigned home. Remaster txn is an exception where
@@ -123,28 +30,31 @@ AcquireLocksResult RMALockManager::AcquireLocks(const Transaction& txn) {
       continue;
     }
 
-    auto key_replica = MakeKeyReplica(kv.key(), home);
-    txn_info.keys.push_back(key_replica);
+    auto lock_id = lock_table_.FindOrInsert(kv.key(), home);
+    txn_info.locks.push_back(lock_id);
 
-    auto& lock_state = lock_table_[key_replica];
+    auto& lock_state = lock_table_.lock_state(lock_id);
 
-    DCHECK(!lock_state.Contains(txn_id)) << "Txn requested lock twice: " << txn_id << ", " << key_replica;
+    DCHECK(!lock_state.Contains(txn_id)) << "Txn requested lock twice: " << txn_id << ", "
+                                         << lock_table_.key_replica(lock_id).to_string();
 
     auto before_mode = lock_state.mode;
+    bool acquired = false;
     switch (kv.value_entry().type()) {
       case KeyType::READ:
-        if (lock_state.AcquireReadLock(txn_id)) {
-          txn_info.num_waiting_for--;
-        }
+        acquired = lock_state.AcquireReadLock(txn_id);
         break;
       case KeyType::WRITE:
-        if (lock_state.AcquireWriteLock(txn_id)) {
-          txn_info.num_waiting_for--;
-        }
+        acquired = lock_state.AcquireWriteLock(txn_id);
         break;
       default:
         LOG(FATAL) << "Invalid lock mode";
     }
+    if (acquired) {
+      txn_info.num_waiting_for--;
+    } else if (is_sampled) {
+      StartWait(txn_id, lock_id);
+    }
     if (before_mode == LockMode::UNLOCKED && lock_state.mode != before_mode) {
       num_locked_keys_++;
     }
@@ -156,6 +66,96 @@ AcquireLocksResult RMALockManager::AcquireLocks(const Transaction& txn) {
   return AcquireLocksResult::WAITING;
 }
 
+void RMALockManager::AcquireLocks(const vector<Transaction*>& txns, vector<TxnId>& ready_txns) {
+  batch_requests_.clear();
+  batch_txn_info_.clear();
+  for (uint32_t i = 0; i < txns.size(); i++) {
+    const auto& txn = *txns[i];
+    auto home = txn.internal().home();
+    auto is_remaster = txn.program_case() == Transaction::kRemaster;
+
+    // A remaster txn only has one key K but it acquires locks on (K, RO) and (K, RN)
+    // where RO and RN are the old and new region respectively.
+    auto num_required_locks = is_remaster ? 2 : txn.keys_size();
+    auto ins = txn_info_.try_emplace(txn.internal().id(), num_required_locks);
+    DCHECK(std::find(batch_txn_info_.begin(), batch_txn_info_.end(), &ins.first->second) == batch_txn_info_.end())
+        << "Txn appears twice in a batch: " << txn.internal().id();
+    batch_txn_info_.push_back(&ins.first->second);
+
+    uint32_t replica = home;
+    for (const auto& kv : txn.keys()) {
+      // Skip keys that does not belong to the assigned home. Remaster txn is an exception where
+      // it is allowed that the metadata on the txn does not match its assigned home
+      if (!is_remaster && static_cast<int>(kv.value_entry().metadata().master()) != home) {
+        continue;
+      }
+      batch_requests_.push_back({KeyReplicaHash{}(kv.key(), replica), &kv.key(), replica, i, kv.value_entry().type()});
+    }
+  }
+
+  // Group the requests on the same <key, replica> together. Within a group, the requests are
+  // in the order of the batch
+  std::sort(batch_requests_.begin(), batch_requests_.end(), [](const auto& a, const auto& b) {
+    if (a.hash != b.hash) {
+      return a.hash < b.hash;
+    }
+    if (a.replica != b.replica) {
+      return a.replica < b.replica;
+    }
+    if (auto cmp = a.key->compare(*b.key); cmp != 0) {
+      return cmp < 0;
+    }
+    return a.txn_index < b.txn_index;
+  });
+
+  for (size_t begin = 0, end; begin < batch_requests_.size(); begin = end) {
+    const auto& first = batch_requests_[begin];
+    auto lock_id = lock_table_.FindOrInsert(*first.key, first.replica, first.hash);
+    auto& lock_state = lock_table_.lock_state(lock_id);
+    auto before_mode = lock_state.mode;
+
+    for (end = begin; end < batch_requests_.size(); end++) {
+      const auto& request = batch_requests_[end];
+      if (request.hash != first.hash || request.replica != first.replica || *request.key != *first.key) {
+        break;
+      }
+      auto txn_id = txns[request.txn_index]->internal().id();
+      auto txn_info = batch_txn_info_[request.txn_index];
+      txn_info->locks.push_back(lock_id);
+
+      DCHECK(!lock_state.Contains(txn_id)) << "Txn requested lock twice: " << txn_id << ", "
+                                           << lock_table_.key_replica(lock_id).to_string();
+
+      bool acquired = false;
+      switch (request.type) {
+        case KeyType::READ:
+          acquired = lock_state.AcquireReadLock(txn_id);
+          break;
+        case KeyType::WRITE:
+          acquired = lock_state.AcquireWriteLock(txn_id);
+          break;
+        default:
+          LOG(FATAL) << "Invalid lock mode";
+      }
+      if (acquired) {
+        txn_info->num_waiting_for--;
+      } else if (contention_profiler_.is_sampled(txn_id)) {
+        StartWait(txn_id, lock_id);
+      }
+    }
+
+    if (before_mode == LockMode::UNLOCKED && lock_state.mode != before_mode) {
+      num_locked_keys_++;
+    }
+  }
+
+  for (uint32_t i = 0; i < txns.size(); i++) {
+    if (batch_txn_info_[i]->is_ready()) {
+      ready_txns.push_back(txns[i]->internal().id());
+    }
+  }
+}
+
 vector<TxnId> RMALockManager::ReleaseLocks(TxnId txn_id) {
   vector<TxnId> result;
   auto info_it = txn_info_.find(txn_id);
@@ -163,34 +163,46 @@ vector<TxnId> RMALockManager::ReleaseLocks(TxnId txn_id) {
     return result;
   }
   auto& info = info_it->second;
-  for (const auto& key_replica : info.keys) {
-    auto lock_state_it = lock_table_.find(key_replica);
-    if (lock_state_it == lock_table_.end()) {
-      continue;
-    }
-    auto& lock_state = lock_state_it->second;
-    auto old_mode = lock_state.mode;
-    auto new_grantees = lock_state.Release(txn_id);
-    // Prevent the lock table from growing too big
-    // TODO: automatically delete remastered keys
-    if (lock_state.mode == LockMode::UNLOCKED) {
-      if (old_mode != LockMode::UNLOCKED) {
-        num_locked_keys_--;
-      }
-    }
-
-    for (auto new_txn : new_grantees) {
-      auto it = txn_info_.find(new_txn);
-      DCHECK(it != txn_info_.end());
-      it->second.num_waiting_for--;
-      if (it->second.is_ready()) {
-        result.push_back(new_txn);
-      }
-    }
+  for (auto lock_id : info.locks) {
+    ReleaseLock(txn_id, lock_id, result);
   }
 
   txn_info_.erase(info_it);
 
+  // A txn that is released before getting all of its locks still has unfinished waits
+  if (contention_profiler_.is_sampled(txn_id)) {
+    contention_profiler_.EndWaits(txn_id);
+  }
+
+  // Deduplicate the result
+  std::sort(result.begin(), result.end());
+  auto last = std::unique(result.begin(), result.end());
+  result.erase(last, result.end());
+
+  return result;
+}
+
+vector<TxnId> RMALockManager::ReleaseReadLocks(TxnId txn_id) {
+  vector<TxnId> result;
+  auto info_it = txn_info_.find(txn_id);
+  if (info_it == txn_info_.end()) {
+    return result;
+  }
+  auto& info = info_it->second;
+  DCHECK(info.is_ready()) << "Txn " << txn_id << " released its read locks before holding all of its locks";
+
+  // Since the txn holds all of its locks, a lock in read mode is one of its read locks.
+  // The released locks are dropped from the txn because their entries may be recycled
+  size_t num_kept = 0;
+  for (auto lock_id : info.locks) {
+    if (lock_table_.lock_state(lock_id).mode == LockMode::READ) {
+      ReleaseLock(txn_id, lock_id, result);
+    } else {
+      info.locks[num_kept++] = lock_id;
+    }
+  }
+  info.locks.resize(num_kept);
+
   // Deduplicate the result
   std::sort(result.begin(), result.end());
   auto last = std::unique(result.begin(), result.end());
@@ -199,6 +211,41 @@ vector<TxnId> RMALockManager::ReleaseLocks(TxnId txn_id) {
   return result;
 }
 
+void RMALockManager::ReleaseLock(TxnId txn_id, LockTable::EntryId lock_id, vector<TxnId>& result) {
+  auto& lock_state = lock_table_.lock_state(lock_id);
+  auto old_mode = lock_state.mode;
+  new_grantees_.clear();
+  lock_state.Release(txn_id, new_grantees_);
+  if (lock_state.mode == LockMode::UNLOCKED) {
+    if (old_mode != LockMode::UNLOCKED) {
+      num_locked_keys_--;
+    }
+  }
+
+  for (auto new_txn : new_grantees_) {
+    auto it = txn_info_.find(new_txn);
+    DCHECK(it != txn_info_.end());
+    if (contention_profiler_.is_sampled(new_txn)) {
+      contention_profiler_.EndWait(new_txn, lock_table_.key_replica(lock_id));
+    }
+    it->second.num_waiting_for--;
+    if (it->second.is_ready()) {
+      result.push_back(new_txn);
+    }
+  }
+
+  // Recycle the entry to prevent the lock table from growing too big
+  if (lock_state.is_free()) {
+    lock_table_.Erase(lock_id);
+  }
+}
+
+void RMALockManager::StartWait(TxnId txn_id, LockTable::EntryId lock_id) {
+  // The waiting txn is at the end of the queue
+  auto num_ahead = lock_table_.lock_state(lock_id).queue_length() - 1;
+  contention_profiler_.StartWait(txn_id, lock_table_.key_replica(lock_id), num_ahead);
+}
+
 /**
  * {
  *    lock_manager_type: 0,
@@ -217,6 +264,7 @@ vector<TxnId> RMALockManager::ReleaseLocks(TxnId txn_id) {
  *      ],
  *      ...
  *    ],
+ *    contention: <see ContentionProfiler>
  * }
  */
 void RMALockManager::GetStats(rapidjson::Document& stats, uint32_t level) const {
@@ -238,12 +286,12 @@ void RMALockManager::GetStats(rapidjson::Document& stats, uint32_t level) const
   if (level >= 2) {
     // Collect data from lock tables
     rapidjson::Value lock_table(rapidjson::kArrayType);
-    for (const auto& [key, lock_state] : lock_table_) {
+    lock_table_.ForEach([&](const KeyReplica& key_replica, const LockState& lock_state) {
       if (lock_state.mode == LockMode::UNLOCKED) {
-        continue;
+        return;
       }
       rapidjson::Value entry(rapidjson::kArrayType);
-      rapidjson::Value key_json(key.c_str(), alloc);
+      rapidjson::Value key_json(key_replica.to_string().c_str(), alloc);
       entry.PushBack(key_json, alloc)
           .PushBack(static_cast<uint32_t>(lock_state.mode), alloc)
           .PushBack(ToJsonArray(lock_state.GetHolders(), alloc), alloc)
@@ -251,9 +299,11 @@ void RMALockManager::GetStats(rapidjson::Document& stats, uint32_t level) const
                         lock_state.GetWaiters(), [](const auto& v) { return static_cast<uint32_t>(v); }, alloc),
                     alloc);
       lock_table.PushBack(move(entry), alloc);
-    }
+    });
     stats.AddMember(StringRef(LOCK_TABLE), move(lock_table), alloc);
   }
+
+  contention_profiler_.GetStats(stats, level);
 }
 
 }  // namespace slog
\ No newline at end of file
@@ -15,6 +15,8 @@
 #include "common/constants.h"
 #include "common/json_utils.h"
 #include "common/types.h"
+#include "module/scheduler_components/contention_profiler.h"
+#include "module/scheduler_components/lock_table.h"
 #include "module/scheduler_components/txn_holder.h"
 
 using std::list;
@@ -26,31 +28,6 @@ using std::vector;
 
 namespace slog {
 
-/**
- * An object of this class represents the locking state of a key.
- * It contains the IDs of transactions that are holding and waiting
- * the lock and the mode of the lock.
- */
-class LockState {
- public:
-  bool AcquireReadLock(TxnId txn_id);
-  bool AcquireWriteLock(TxnId txn_id);
-  vector<TxnId> Release(TxnId txn_id);
-  bool Contains(TxnId txn_id);
-
-  LockMode mode = LockMode::UNLOCKED;
-
-  /* For debugging */
-  const vector<TxnId>& GetHolders() const { return holders_; }
-
-  /* For debugging */
-  const list<pair<TxnId, LockMode>>& GetWaiters() const { return waiter_queue_; }
-
- private:
-  vector<TxnId> holders_;
-  list<pair<TxnId, LockMode>> waiter_queue_;
-};
-
 /**
  * This is a deterministic lock manager which grants locks for transactions
  * in the order that they request. If transaction X, appears before
@@ -81,6 +58,19 @@ class RMALockManager {
    */
   AcquireLocksResult AcquireLocks(const Transaction& txn);
 
+  /**
+   * Acquires the locks of a batch of transactions in one pass. The lock requests of
+   * the whole batch are grouped by key so that each key is looked up only once and its
+   * requests are queued in the order of the batch. The outcome is the same as calling
+   * AcquireLocks on each transaction in order.
+   *
+   * @param txns       The transactions in log order. A transaction must appear at most
+   *                   once in a batch.
+   * @param ready_txns Appended with the IDs of the transactions that have acquired all
+   *                   of their locks, in the order of the batch.
+   */
+  void AcquireLocks(const vector<Transaction*>& txns, vector<TxnId>& ready_txns);
+
   /**
    * Releases all locks that a transaction is holding or waiting for.
    *
@@ -90,6 +80,19 @@ class RMALockManager {
    */
   vector<TxnId> ReleaseLocks(TxnId txn_id);
 
+  /**
+   * Releases the read locks of a transaction that holds all of its locks, keeping its
+   * write locks until ReleaseLocks is called. A transaction can give up its read locks
+   * once it has read the keys since locks are acquired all at once so no lock can be
+   * acquired after this release, and the values that it writes are only visible after
+   * its write locks are released.
+   *
+   * @param txn_id Id of transaction whose read locks are released.
+   * @return       A set of IDs of transactions that are able to obtain
+   *               all of their locks thanks to this release.
+   */
+  vector<TxnId> ReleaseReadLocks(TxnId txn_id);
+
   /**
    * Gets current statistics of the lock manager
    *
@@ -97,18 +100,44 @@ class RMALockManager {
    */
   void GetStats(rapidjson::Document& stats, uint32_t level) const;
 
+  /**
+   * Sets the percentage of txns whose lock waits are profiled. See ContentionProfiler
+   */
+  void SetContentionSampleRate(uint32_t sample_rate) { contention_profiler_.set_sample_rate(sample_rate); }
+
  private:
+  // Releases a lock of a txn and appends the txns that become ready to result
+  void ReleaseLock(TxnId txn_id, LockTable::EntryId lock_id, vector<TxnId>& result);
+
+  // Starts profiling a sampled txn that is blocked on a lock
+  void StartWait(TxnId txn_id, LockTable::EntryId lock_id);
+
   struct TxnInfo {
-    TxnInfo(int num_keys) : num_waiting_for(num_keys) { keys.reserve(num_keys); }
+    TxnInfo(int num_keys) : num_waiting_for(num_keys) { locks.reserve(num_keys); }
 
     bool is_ready() const { return num_waiting_for == 0; }
 
     int num_waiting_for;
-    std::vector<Key> keys;
+    vector<LockTable::EntryId> locks;
   };
   unordered_map<TxnId, TxnInfo> txn_info_;
-  unordered_map<KeyReplica, LockState> lock_table_;
+  LockTable lock_table_;
+
+  struct BatchLockRequest {
+    size_t hash;
+    const Key* key;
+    uint32_t replica;
+    // Position of the txn in the batch
+    uint32_t txn_index;
+    KeyType type;
+  };
+  // Reused across batches
+  vector<BatchLockRequest> batch_requests_;
+  vector<TxnInfo*> batch_txn_info_;
+  // Reused across releases to collect the txns that are granted locks
+  vector<TxnId> new_grantees_;
   uint32_t num_locked_keys_ = 0;
+  ContentionProfiler contention_profiler_;
 };
 
 }  // namespace slog
\ No newline at end of file
@@ -0,0 +1,291 @@
+#include "module/scheduler_components/sharded_lock_manager.h"
+
+#include <glog/logging.h>
+
+#include <string_view>
+
+#include "common/thread_utils.h"
+
+namespace slog {
+
+ShardedLockManager::~ShardedLockManager() {
+  for (auto& shard : shards_) {
+    shard->Stop();
+  }
+  for (auto& t : threads_) {
+    t.join();
+  }
+}
+
+zmq::socket_t ShardedLockManager::Start(uint32_t num_shards, const std::vector<int>& cpus,
+                                        const std::shared_ptr<zmq::context_t>& context) {
+  CHECK(shards_.empty()) << "Lock manager already started";
+  CHECK(num_shards >= 1 && num_shards <= 64) << "Number of lock manager shards must be between 1 and 64";
+
+  txn_info_.reserve(1000000);
+
+  zmq::socket_t signal_socket;
+  std::string signal_address;
+  if (context != nullptr) {
+    signal_address = "inproc://lock_manager_" + std::to_string(reinterpret_cast<uintptr_t>(this));
+    signal_socket = zmq::socket_t(*context, ZMQ_PULL);
+    signal_socket.set(zmq::sockopt::rcvhwm, 0);
+    signal_socket.bind(signal_address);
+  }
+
+  staged_requests_.resize(num_shards);
+  for (uint32_t i = 0; i < num_shards; i++) {
+    shards_.push_back(std::make_unique<Shard>(*this));
+  }
+  for (uint32_t i = 0; i < num_shards; i++) {
+    auto& t = threads_.emplace_back(&Shard::Run, shards_[i].get(), context, signal_address);
+    auto name = "lockmgr-" + std::to_string(i);
+    SetThreadName(t.native_handle(), name.c_str());
+    if (i < cpus.size()) {
+      PinToCpu(t.native_handle(), cpus[i]);
+    }
+  }
+
+  return signal_socket;
+}
+
+AcquireLocksResult ShardedLockManager::AcquireLocks(const Transaction& txn) {
+  auto txn_id = txn.internal().id();
+  auto home = txn.internal().home();
+  auto is_remaster = txn.program_case() == Transaction::kRemaster;
+
+  // A remaster txn only has one key K but it acquires locks on (K, RO) and (K, RN)
+  // where RO and RN are the old and new region respectively.
+  auto num_required_locks = is_remaster ? 2 : txn.keys_size();
+  auto& txn_info = txn_info_.try_emplace(txn_id, num_required_locks).first->second;
+
+  uint64_t touched_shards = 0;
+  for (const auto& kv : txn.keys()) {
+    // Skip keys that does not belong to the assigned home. Remaster txn is an exception where
+    // it is allowed that the metadata on the txn does not match its assigned home
+    if (!is_remaster && static_cast<int>(kv.value_entry().metadata().master()) != home) {
+      continue;
+    }
+
+    auto shard = std::hash<std::string_view>{}(kv.key()) % shards_.size();
+    auto& request = staged_requests_[shard].emplace_back();
+    switch (kv.value_entry().type()) {
+      case KeyType::READ:
+        request.type = Request::Type::ACQUIRE_READ;
+        break;
+      case KeyType::WRITE:
+        request.type = Request::Type::ACQUIRE_WRITE;
+        break;
+      default:
+        LOG(FATAL) << "Invalid lock mode";
+    }
+    request.txn_id = txn_id;
+    request.replica = home;
+    request.key = kv.key();
+    touched_shards |= 1ULL << shard;
+  }
+
+  txn_info.shards |= touched_shards;
+  FlushStagedRequests(touched_shards);
+
+  if (txn_info.num_waiting_for == 0) {
+    return AcquireLocksResult::ACQUIRED;
+  }
+  return AcquireLocksResult::WAITING;
+}
+
+void ShardedLockManager::ReleaseLocks(TxnId txn_id) {
+  auto info_it = txn_info_.find(txn_id);
+  if (info_it == txn_info_.end()) {
+    return;
+  }
+  auto shards = info_it->second.shards;
+  for (size_t i = 0; i < shards_.size(); i++) {
+    if (shards & (1ULL << i)) {
+      auto& request = staged_requests_[i].emplace_back();
+      request.type = Request::Type::RELEASE;
+      request.txn_id = txn_id;
+    }
+  }
+  FlushStagedRequests(shards);
+  // Grants that arrive later for this txn are ignored
+  txn_info_.erase(info_it);
+}
+
+void ShardedLockManager::TakeReadyTxns(std::vector<std::pair<TxnId, bool>>& ready_txns) {
+  {
+    std::lock_guard<std::mutex> guard(grants_mut_);
+    taken_grants_.swap(grants_);
+  }
+  for (const auto& grant : taken_grants_) {
+    auto it = txn_info_.find(grant.txn_id);
+    if (it == txn_info_.end()) {
+      continue;
+    }
+    auto& txn_info = it->second;
+    txn_info.waited |= grant.waited;
+    if (--txn_info.num_waiting_for == 0) {
+      ready_txns.emplace_back(grant.txn_id, !txn_info.waited);
+    }
+  }
+  taken_grants_.clear();
+}
+
+void ShardedLockManager::FlushStagedRequests(uint64_t shards) {
+  for (size_t i = 0; i < shards_.size(); i++) {
+    if (shards & (1ULL << i)) {
+      shards_[i]->Push(staged_requests_[i]);
+    }
+  }
+}
+
+bool ShardedLockManager::Publish(std::vector<Grant>& grants) {
+  std::lock_guard<std::mutex> guard(grants_mut_);
+  bool was_empty = grants_.empty();
+  if (was_empty) {
+    grants_.swap(grants);
+  } else {
+    grants_.insert(grants_.end(), grants.begin(), grants.end());
+  }
+  return was_empty;
+}
+
+void ShardedLockManager::Shard::Push(std::vector<Request>& requests) {
+  {
+    std::lock_guard<std::mutex> guard(mut_);
+    if (pending_.empty()) {
+      // Hand over the whole buffer and take back the empty one that the shard gave up
+      pending_.swap(requests);
+    } else {
+      pending_.insert(pending_.end(), std::make_move_iterator(requests.begin()),
+                      std::make_move_iterator(requests.end()));
+    }
+  }
+  requests.clear();
+  cv_.notify_one();
+}
+
+void ShardedLockManager::Shard::Stop() {
+  {
+    std::lock_guard<std::mutex> guard(mut_);
+    stopped_ = true;
+  }
+  cv_.notify_one();
+}
+
+void ShardedLockManager::Shard::Run(const std::shared_ptr<zmq::context_t>& context,
+                                    const std::string& signal_address) {
+  zmq::socket_t signal_socket;
+  if (context != nullptr) {
+    signal_socket = zmq::socket_t(*context, ZMQ_PUSH);
+    signal_socket.set(zmq::sockopt::sndhwm, 0);
+    signal_socket.set(zmq::sockopt::linger, 0);
+    signal_socket.connect(signal_address);
+  }
+
+  std::vector<Request> requests;
+  std::vector<Grant> grants;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mut_);
+      cv_.wait(lock, [this] { return !pending_.empty() || stopped_; });
+      if (stopped_) {
+        break;
+      }
+      requests.swap(pending_);
+    }
+
+    for (auto& request : requests) {
+      Process(request, grants);
+    }
+    requests.clear();
+
+    if (!grants.empty()) {
+      // Only wake up the owner if it has not been woken up for grants that are still not taken
+      if (manager_.Publish(grants) && context != nullptr) {
+        signal_socket.send(zmq::message_t(), zmq::send_flags::dontwait);
+      }
+      grants.clear();
+    }
+  }
+}
+
+void ShardedLockManager::Shard::Process(Request& request, std::vector<Grant>& grants) {
+  auto txn_id = request.txn_id;
+  if (request.type == Request::Type::RELEASE) {
+    auto it = txn_locks_.find(txn_id);
+    if (it == txn_locks_.end()) {
+      return;
+    }
+    for (auto lock_id : it->second) {
+      auto& lock_state = lock_table_.lock_state(lock_id);
+      auto old_mode = lock_state.mode;
+      new_grantees_.clear();
+      lock_state.Release(txn_id, new_grantees_);
+      if (lock_state.mode == LockMode::UNLOCKED && old_mode != LockMode::UNLOCKED) {
+        num_locked_keys_.fetch_sub(1, std::memory_order_relaxed);
+      }
+      if (lock_state.is_free()) {
+        lock_table_.Erase(lock_id);
+      }
+      for (auto new_txn : new_grantees_) {
+        grants.push_back({new_txn, true});
+      }
+    }
+    txn_locks_.erase(it);
+    return;
+  }
+
+  auto lock_id = lock_table_.FindOrInsert(request.key, request.replica);
+  txn_locks_[txn_id].push_back(lock_id);
+
+  auto& lock_state = lock_table_.lock_state(lock_id);
+  auto before_mode = lock_state.mode;
+  bool acquired = request.type == Request::Type::ACQUIRE_READ ? lock_state.AcquireReadLock(txn_id)
+                                                               : lock_state.AcquireWriteLock(txn_id);
+  if (acquired) {
+    grants.push_back({txn_id, false});
+  }
+  if (before_mode == LockMode::UNLOCKED && lock_state.mode != before_mode) {
+    num_locked_keys_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * {
+ *    lock_manager_type: 0,
+ *    num_txns_waiting_for_lock: <int>,
+ *    num_waiting_for_per_txn (lvl >= 1): [
+ *      [<txn id>, <number of locks waited>],
+ *      ...
+ *    ],
+ *    num_locked_keys: <number of keys locked>,
+ *    lock_table (lvl >= 2): [],
+ * }
+ */
+void ShardedLockManager::GetStats(rapidjson::Document& stats, uint32_t level) const {
+  using rapidjson::StringRef;
+
+  auto& alloc = stats.GetAllocator();
+  stats.AddMember(StringRef(LOCK_MANAGER_TYPE), 0, alloc);
+  stats.AddMember(StringRef(NUM_TXNS_WAITING_FOR_LOCK), txn_info_.size(), alloc);
+
+  if (level >= 1) {
+    // Collect number of locks waited per txn
+    stats.AddMember(StringRef(NUM_WAITING_FOR_PER_TXN),
+                    ToJsonArrayOfKeyValue(
+                        txn_info_, [](const auto& info) { return info.num_waiting_for; }, alloc),
+                    alloc);
+  }
+
+  uint32_t num_locked_keys = 0;
+  for (const auto& shard : shards_) {
+    num_locked_keys += shard->num_locked_keys();
+  }
+  stats.AddMember(StringRef(NUM_LOCKED_KEYS), num_locked_keys, alloc);
+  if (level >= 2) {
+    stats.AddMember(StringRef(LOCK_TABLE), rapidjson::Value(rapidjson::kArrayType), alloc);
+  }
+}
+
+}  // namespace slog
@@ -0,0 +1,167 @@
+#pragma once
+
+// Prevent mixing with other versions
+#ifdef LOCK_MANAGER
+#error "Only one lock manager can be included"
+#endif
+#define LOCK_MANAGER
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <zmq.hpp>
+
+#include "common/configuration.h"
+#include "common/constants.h"
+#include "common/json_utils.h"
+#include "common/types.h"
+#include "module/scheduler_components/lock_table.h"
+#include "module/scheduler_components/txn_holder.h"
+
+using std::pair;
+using std::shared_ptr;
+using std::unordered_map;
+using std::vector;
+
+namespace slog {
+
+/**
+ * This is a deterministic, remaster-aware lock manager that grants locks in
+ * the same order as the RMA lock manager, but whose lock table is split into
+ * shards by key hash. Each shard is owned by its own thread so that
+ * concurrency control of a partition can use more than one core.
+ *
+ * The lock requests of a transaction are fanned out to the shards of its keys
+ * in the order that the transaction is received. Since each shard processes its
+ * requests in that order, the waiters of every lock are queued exactly as they
+ * would be in a single lock table. The shards report back every lock that they
+ * grant and a transaction is ready once all of its locks have been reported.
+ *
+ * Acquiring and releasing locks is asynchronous: apart from a transaction that
+ * needs no lock, the transactions that become ready are collected with
+ * TakeReadyTxns. All methods except for the shard threads must be called from
+ * the same thread.
+ *
+ * Remastering:
+ * Locks are taken on the tuple <key, replica>, the same as in the RMA lock manager.
+ */
+class ShardedLockManager {
+ public:
+  ShardedLockManager() = default;
+  ~ShardedLockManager();
+
+  /**
+   * Starts the shard threads
+   *
+   * @param num_shards Number of shards of the lock table. At most 64
+   * @param cpus       CPUs that the shard threads are pinned to
+   * @param context    If given, the returned socket receives a message whenever
+   *                   the shards report new grants so that the owner can wait for
+   *                   them in a poller
+   */
+  zmq::socket_t Start(uint32_t num_shards, const std::vector<int>& cpus = {},
+                      const std::shared_ptr<zmq::context_t>& context = nullptr);
+
+  /**
+   * Sends the lock requests of a transaction to the shards.
+   *
+   * @param txn The transaction whose locks are acquired.
+   * @return    ACQUIRED if the transaction needs no lock, WAITING otherwise.
+   */
+  AcquireLocksResult AcquireLocks(const Transaction& txn);
+
+  /**
+   * Releases all locks that a transaction is holding or waiting for. The
+   * transactions that become ready thanks to this release are collected
+   * later with TakeReadyTxns.
+   */
+  void ReleaseLocks(TxnId txn_id);
+
+  /**
+   * Collects the grants reported by the shards and appends the transactions that
+   * obtained all of their locks to ready_txns. Each transaction is paired with
+   * true if it got all of its locks without waiting for another transaction.
+   */
+  void TakeReadyTxns(std::vector<std::pair<TxnId, bool>>& ready_txns);
+
+  /**
+   * Gets current statistics of the lock manager. The lock table is owned by
+   * the shard threads so it is never included.
+   *
+   * @param stats A JSON object where the statistics are stored into
+   */
+  void GetStats(rapidjson::Document& stats, uint32_t level) const;
+
+ private:
+  struct Request {
+    enum class Type { ACQUIRE_READ, ACQUIRE_WRITE, RELEASE };
+    Type type;
+    TxnId txn_id;
+    uint32_t replica;
+    Key key;
+  };
+
+  struct Grant {
+    TxnId txn_id;
+    // The txn had to wait for the lock
+    bool waited;
+  };
+
+  class Shard {
+   public:
+    Shard(ShardedLockManager& manager) : manager_(manager) {}
+
+    void Run(const std::shared_ptr<zmq::context_t>& context, const std::string& signal_address);
+    void Push(std::vector<Request>& requests);
+    void Stop();
+
+    uint32_t num_locked_keys() const { return num_locked_keys_.load(std::memory_order_relaxed); }
+
+   private:
+    void Process(Request& request, std::vector<Grant>& grants);
+
+    ShardedLockManager& manager_;
+
+    std::mutex mut_;
+    std::condition_variable cv_;
+    std::vector<Request> pending_;
+    bool stopped_ = false;
+
+    // Only accessed by the shard thread
+    LockTable lock_table_;
+    std::unordered_map<TxnId, std::vector<LockTable::EntryId>> txn_locks_;
+    std::vector<TxnId> new_grantees_;
+    std::atomic<uint32_t> num_locked_keys_ = 0;
+  };
+
+  // Called by the shards. Returns true if there were no grants waiting to be taken
+  bool Publish(std::vector<Grant>& grants);
+
+  void FlushStagedRequests(uint64_t shards);
+
+  struct TxnInfo {
+    TxnInfo(int num_locks) : num_waiting_for(num_locks), shards(0), waited(false) {}
+
+    int num_waiting_for;
+    // Bitmap of the shards holding locks of the txn
+    uint64_t shards;
+    bool waited;
+  };
+  std::unordered_map<TxnId, TxnInfo> txn_info_;
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::vector<std::thread> threads_;
+  // Requests being prepared for each shard by the owner thread
+  std::vector<std::vector<Request>> staged_requests_;
+
+  std::mutex grants_mut_;
+  std::vector<Grant> grants_;
+  // Swapped with grants_ when taking the grants
+  std::vector<Grant> taken_grants_;
+};
+
+}  // namespace slog
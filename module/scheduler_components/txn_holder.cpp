@@ -2,20 +2,37 @@
 
 namespace slog {
 
-TxnHolder::TxnHolder(const ConfigurationPtr& config, Transaction* txn)
-    : txn_id_(txn->internal().id()),
-      main_txn_idx_(txn->internal().home()),
-      lo_txns_(config->num_replicas()),
-      remaster_result_(std::nullopt),
-      aborting_(false),
-      done_(false),
-      num_lo_txns_(0),
-      expected_num_lo_txns_(txn->internal().involved_replicas_size()),
-      num_dispatches_(0) {
+TxnHolder::TxnHolder(const ConfigurationPtr& config, Transaction* txn) { Reset(config, txn); }
+
+void TxnHolder::Reset(const ConfigurationPtr& config, Transaction* txn) {
+  DCHECK_EQ(num_lo_txns_, 0) << "Holder must be cleared before being reused";
+  txn_id_ = txn->internal().id();
+  main_txn_idx_ = txn->internal().home();
+  // All slots are empty after Clear() so resizing keeps the buffer of the vector
+  lo_txns_.resize(config->num_replicas());
+  remaster_result_.reset();
+  aborting_ = false;
+  done_ = false;
+  num_lo_txns_ = 0;
+  expected_num_lo_txns_ = txn->internal().involved_replicas_size();
+  num_dispatches_ = 0;
+  generation_++;
+
   lo_txns_[main_txn_idx_].reset(txn);
   ++num_lo_txns_;
 }
 
+void TxnHolder::Clear() {
+  for (auto& lo_txn : lo_txns_) {
+    lo_txn.reset();
+  }
+  num_lo_txns_ = 0;
+#if defined(LOCK_MANAGER_MVCC)
+  versions_.reads.clear();
+  versions_.captures.clear();
+#endif
+}
+
 bool TxnHolder::AddLockOnlyTxn(Transaction* txn) {
   auto home = txn->internal().home();
   CHECK_LT(home, static_cast<int>(lo_txns_.size()));
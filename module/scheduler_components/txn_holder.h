@@ -10,19 +10,36 @@
 #include "common/types.h"
 #include "proto/transaction.pb.h"
 
+#if defined(LOCK_MANAGER_MVCC)
+#include "module/scheduler_components/version.h"
+#endif
+
 namespace slog {
 
 using EnvelopePtr = std::unique_ptr<internal::Envelope>;
 
+/**
+ * Holds the main txn and the lock-only txns of a txn while it is in the scheduler.
+ * Holders are pooled by the scheduler so a holder is reused for many txns over its
+ * lifetime. The generation of a holder changes every time it is reused, which lets
+ * the users of a holder pointer check that it still refers to the same txn.
+ */
 class TxnHolder {
  public:
   TxnHolder(const ConfigurationPtr& config, Transaction* txn);
 
+  // Re-initializes a cleared holder for another txn
+  void Reset(const ConfigurationPtr& config, Transaction* txn);
+
+  // Deletes the txns that the holder still owns but keeps its buffers for the next txn
+  void Clear();
+
   bool AddLockOnlyTxn(Transaction* txn);
 
   Transaction* FinalizeAndRelease();
 
   TxnId txn_id() const { return txn_id_; }
+  uint32_t generation() const { return generation_; }
   Transaction& txn() const {
     CHECK(lo_txns_[main_txn_idx_] != nullptr);
     return *lo_txns_[main_txn_idx_];
@@ -41,6 +58,11 @@ class TxnHolder {
   void IncNumDispatches() { num_dispatches_++; }
   int num_dispatches() const { return num_dispatches_; }
 
+#if defined(LOCK_MANAGER_MVCC)
+  // Versions that the worker reads and captures for this txn. Set by the scheduler before dispatching
+  VersionSet& versions() { return versions_; }
+#endif
+
   bool is_ready_for_gc() const { return done_ && num_lo_txns_ == expected_num_lo_txns_; }
   int num_lock_only_txns() const { return num_lo_txns_; }
   int expected_num_lock_only_txns() const { return expected_num_lo_txns_; }
@@ -52,9 +74,13 @@ class TxnHolder {
   std::optional<pair<Key, uint32_t>> remaster_result_;
   bool aborting_;
   bool done_;
-  int num_lo_txns_;
+  int num_lo_txns_ = 0;
   int expected_num_lo_txns_;
   int num_dispatches_;
+  uint32_t generation_ = 0;
+#if defined(LOCK_MANAGER_MVCC)
+  VersionSet versions_;
+#endif
 };
 
 }  // namespace slog
\ No newline at end of file
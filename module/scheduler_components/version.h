@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "common/types.h"
+#include "storage/storage.h"
+
+namespace slog {
+
+/**
+ * A version of a key as of a position in the log. The storage always holds the newest
+ * version that has been written. When a writer is about to overwrite a key while some
+ * earlier readers still need the current version, it first captures the current record
+ * here so that the readers can still find it after the overwrite.
+ *
+ * A version is shared between the scheduler, the txn that captures it and the txns that
+ * read it. It is garbage collected once all of them have let go of it.
+ */
+class Version {
+ public:
+  // Called by the overwriting txn before it writes anything to the storage
+  void Capture(const Storage& storage, const Key& key) {
+    exists_ = storage.Read(key, record_);
+    captured_.store(true, std::memory_order_release);
+  }
+
+  /**
+   * A reader must read the key from the storage first then call this. If the version is
+   * not captured yet, the key has not been overwritten when it was read from the storage
+   */
+  bool captured() const { return captured_.load(std::memory_order_acquire); }
+
+  // Only valid after the version is captured
+  bool exists() const { return exists_; }
+  const Record& record() const { return record_; }
+
+ private:
+  std::atomic<bool> captured_{false};
+  bool exists_ = false;
+  Record record_;
+};
+
+using VersionPtr = std::shared_ptr<Version>;
+
+struct VersionSet {
+  // Versions of the keys read by a txn
+  std::vector<std::pair<Key, VersionPtr>> reads;
+  // Versions that a txn must capture before overwriting the keys
+  std::vector<std::pair<Key, VersionPtr>> captures;
+};
+
+}  // namespace slog
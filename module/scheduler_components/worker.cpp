@@ -6,6 +6,7 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <thread>
 
 #include "common/proto_utils.h"
@@ -20,8 +21,13 @@ using internal::Request;
 using internal::Response;
 
 Worker::Worker(int id, const std::shared_ptr<Broker>& broker, const shared_ptr<Storage>& storage,
-               const MetricsRepositoryManagerPtr& metrics_manager, std::chrono::milliseconds poll_timeout)
-    : NetworkedModule(broker, kMaxChannel + id, metrics_manager, poll_timeout), storage_(storage) {
+               const MetricsRepositoryManagerPtr& metrics_manager, const WorkerQueuesList& all_queues,
+               std::chrono::milliseconds poll_timeout)
+    : NetworkedModule(broker, kMaxChannel + id, metrics_manager, poll_timeout),
+      storage_(storage),
+      id_(id),
+      all_queues_(all_queues),
+      queues_(*all_queues[id]) {
   switch (config()->execution_type()) {
     case internal::ExecutionType::KEY_VALUE:
       execution_ = make_unique<KeyValueExecution>(Sharder::MakeSharder(config()), storage);
@@ -35,13 +41,20 @@ Worker::Worker(int id, const std::shared_ptr<Broker>& broker, const shared_ptr<S
   }
 }
 
-void Worker::Initialize() {
-  zmq::socket_t sched_socket(*context(), ZMQ_DEALER);
-  sched_socket.set(zmq::sockopt::rcvhwm, 0);
-  sched_socket.set(zmq::sockopt::sndhwm, 0);
-  sched_socket.connect(MakeInProcChannelAddress(kWorkerChannel));
+Worker::~Worker() {
+  storage_->RemoveDurableListener(durable_listener_id_);
+  for (auto [position, txn] : pending_replies_) {
+    delete txn;
+  }
+}
 
-  AddCustomSocket(std::move(sched_socket));
+void Worker::Initialize() {
+  AddCustomNotifier(queues_.worker_notifier);
+  durable_listener_id_ = storage_->AddDurableListener([this] {
+    if (waiting_for_durability_) {
+      queues_.worker_notifier.Notify();
+    }
+  });
 }
 
 void Worker::OnInternalRequestReceived(EnvelopePtr&& env) {
@@ -50,15 +63,15 @@ void Worker::OnInternalRequestReceived(EnvelopePtr&& env) {
   }
   auto& read_result = env->request().remote_read_result();
   auto txn_id = read_result.txn_id();
-  auto state_it = txn_states_.find(txn_id);
-  if (state_it == txn_states_.end()) {
+  auto state_ptr = txn_states_.Find(txn_id);
+  if (state_ptr == nullptr) {
     VLOG(1) << "Transaction " << txn_id << " does not exist for remote read result";
     return;
   }
 
   VLOG(2) << "Got remote read result for txn " << txn_id;
 
-  auto& state = state_it->second;
+  auto& state = *state_ptr;
   auto& txn = state.txn_holder->txn();
 
   if (txn.status() != TransactionStatus::ABORTED) {
@@ -77,46 +90,42 @@ void Worker::OnInternalRequestReceived(EnvelopePtr&& env) {
 
   state.remote_reads_waiting_on -= 1;
 
-  // Move the transaction to a new phase if all remote reads arrive
-  if (state.remote_reads_waiting_on == 0) {
-    if (state.phase == TransactionState::Phase::WAIT_REMOTE_READ) {
-      state.phase = TransactionState::Phase::EXECUTE;
-
-      // Remove the redirection at broker for this txn
-      auto redirect_env = NewEnvelope();
-      redirect_env->mutable_request()->mutable_broker_redirect()->set_tag(txn_id);
-      redirect_env->mutable_request()->mutable_broker_redirect()->set_stop(true);
-      Send(move(redirect_env), Broker::MakeChannel(config()->broker_ports_size() - 1));
-
-      VLOG(3) << "Execute txn " << txn_id << " after receving all remote read results";
-    } else {
-      LOG(FATAL) << "Invalid phase";
-    }
+  // The broker has already removed the redirection for this txn after forwarding the last remote read
+  if (state.remote_reads_waiting_on == 0 && state.phase == TransactionState::Phase::WAIT_REMOTE_READ) {
+    state.phase = TransactionState::Phase::EXECUTE;
+    VLOG(3) << "Commit txn " << txn_id << " after receving all remote read results";
   }
 
-  AdvanceTransaction(txn_id);
+  // A txn that is suspended on remote keys is resumed with every remote read because any of them
+  // may carry the keys that it waits for
+  if (state.phase == TransactionState::Phase::EXECUTE) {
+    AdvanceTransaction(txn_id);
+  }
 }
 
 bool Worker::OnCustomSocket() {
-  auto& sched_socket = GetCustomSocket(0);
-
-  zmq::message_t msg;
-  if (!sched_socket.recv(msg, zmq::recv_flags::dontwait)) {
-    return false;
+  TxnHolder* txn_holder;
+  auto has_txn = NextTxn(txn_holder);
+  // Checked after NextTxn, which may have cleared a notification about more writes being durable
+  auto sent_replies = SendDurableReplies();
+  if (!has_txn) {
+    return sent_replies;
+  }
+  if (queues_.idle.load(std::memory_order_relaxed)) {
+    queues_.idle.store(false, std::memory_order_relaxed);
   }
 
-  auto txn_holder = *msg.data<TxnHolder*>();
   auto& txn = txn_holder->txn();
   auto txn_id = txn.internal().id();
 
   RECORD(txn.mutable_internal(), TransactionEvent::ENTER_WORKER);
 
   // Create a state for the new transaction
-  auto [iter, ok] = txn_states_.try_emplace(txn_id, txn_holder);
+  auto [state, ok] = txn_states_.TryEmplace(txn_id, txn_holder);
 
   DCHECK(ok) << "Transaction " << txn_id << " has already been dispatched to this worker";
 
-  iter->second.phase = TransactionState::Phase::READ_LOCAL_STORAGE;
+  state->phase = TransactionState::Phase::READ_LOCAL_STORAGE;
 
   VLOG(3) << "Initialized state for txn " << txn_id;
 
@@ -125,23 +134,41 @@ bool Worker::OnCustomSocket() {
   return true;
 }
 
+bool Worker::NextTxn(TxnHolder*& txn_holder) {
+  if (queues_.txns.Pop(txn_holder)) {
+    return true;
+  }
+  // The worker may go to sleep after this so clear the notifications then check once more
+  // to not miss a txn pushed in between
+  queues_.worker_notifier.Clear();
+  if (queues_.txns.Pop(txn_holder)) {
+    return true;
+  }
+  for (size_t i = 1; i < all_queues_.size(); i++) {
+    if (all_queues_[(id_ + i) % all_queues_.size()]->txns.Pop(txn_holder)) {
+      queues_.num_steals.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  queues_.idle.store(true, std::memory_order_relaxed);
+  return false;
+}
+
 void Worker::AdvanceTransaction(TxnId txn_id) {
   auto& state = TxnState(txn_id);
   switch (state.phase) {
     case TransactionState::Phase::READ_LOCAL_STORAGE:
       ReadLocalStorage(txn_id);
       [[fallthrough]];
+    case TransactionState::Phase::EXECUTE:
+      Execute(txn_id);
+      [[fallthrough]];
     case TransactionState::Phase::WAIT_REMOTE_READ:
-      if (state.phase == TransactionState::Phase::WAIT_REMOTE_READ) {
-        // The only way to get out of this phase is through remote messages
+      if (state.phase != TransactionState::Phase::FINISH) {
+        // The only way to get out of a suspended EXECUTE phase or this phase is through remote messages
         break;
       }
       [[fallthrough]];
-    case TransactionState::Phase::EXECUTE:
-      if (state.phase == TransactionState::Phase::EXECUTE) {
-        Execute(txn_id);
-      }
-      [[fallthrough]];
     case TransactionState::Phase::FINISH:
       Finish(txn_id);
       // Never fallthrough after this point because Finish and PreAbort
@@ -155,6 +182,14 @@ void Worker::ReadLocalStorage(TxnId txn_id) {
   auto txn_holder = state.txn_holder;
   auto& txn = txn_holder->txn();
 
+#if defined(LOCK_MANAGER_MVCC)
+  // Capture the current versions for the earlier readers before this txn can overwrite them.
+  // This must happen even if the txn aborts because the next writer will not capture these versions
+  for (const auto& [key, version] : txn_holder->versions().captures) {
+    version->Capture(*storage_, key);
+  }
+#endif
+
   if (txn.status() != TransactionStatus::ABORTED) {
 #if defined(REMASTER_PROTOCOL_SIMPLE) || defined(REMASTER_PROTOCOL_PER_KEY)
     switch (RemasterManager::CheckCounters(txn, false, storage_)) {
@@ -178,24 +213,54 @@ void Worker::ReadLocalStorage(TxnId txn_id) {
 
     // We don't need to check if keys are in partition here since the assumption is that
     // the out-of-partition keys have already been removed
-    for (auto& kv : *(txn.mutable_keys())) {
-      const auto& key = kv.key();
+    std::vector<const Key*> keys;
+    keys.reserve(txn.keys_size());
+    for (const auto& kv : txn.keys()) {
+      keys.push_back(&kv.key());
+    }
+#if defined(LOCK_MANAGER_MVCC)
+    // Versions that the keys are bound to. Keys that are written have none
+    std::vector<const Version*> versions(keys.size(), nullptr);
+    for (const auto& [key, version] : txn_holder->versions().reads) {
+      for (size_t i = 0; i < keys.size(); i++) {
+        if (*keys[i] == key) {
+          versions[i] = version.get();
+          break;
+        }
+      }
+    }
+#endif
+    storage_->MultiRead(keys, [&](size_t i, const RecordView& view) {
+      auto& kv = *txn.mutable_keys(i);
       auto value = kv.mutable_value_entry();
-      if (Record record; storage_->Read(key, record)) {
+      auto copy_record = [&](const auto& record) {
         // Check whether the stored master metadata matches with the information
         // stored in the transaction
         if (value->metadata().master() != record.metadata().master) {
           txn.set_status(TransactionStatus::ABORTED);
           txn.set_abort_reason("Outdated master");
-          break;
+          return false;
         }
-        value->set_value(record.to_string());
+        // Copy the value straight from the storage to the transaction
+        value->set_value(record.data(), record.size());
+        return true;
+      };
+#if defined(LOCK_MANAGER_MVCC)
+      // The record in the storage is still the bound version unless a later writer has captured
+      // that version. The capture is checked only after reading the storage for this reason
+      if (auto version = versions[i]; version != nullptr && version->captured()) {
+        return !version->exists() || copy_record(version->record());
+      }
+#endif
+      if (view.valid()) {
+        return copy_record(view);
       } else if (txn.program_case() == Transaction::kRemaster) {
         txn.set_status(TransactionStatus::ABORTED);
-        txn.set_abort_reason("Remaster non-existent key " + key);
-        break;
+        txn.set_abort_reason("Remaster non-existent key " + kv.key());
+        return false;
       }
-    }
+      return true;
+    });
   }
 
   NotifyOtherPartitions(txn_id);
@@ -210,17 +275,32 @@ void Worker::ReadLocalStorage(TxnId txn_id) {
   }
   if (state.remote_reads_waiting_on == 0) {
     VLOG(3) << "Execute txn " << txn_id << " without remote reads";
-    state.phase = TransactionState::Phase::EXECUTE;
   } else {
-    // Establish a redirection at broker for this txn so that we can receive remote reads
+    // Establish a redirection at broker for this txn so that we can receive remote reads. It
+    // expires by itself after the expected number of remote reads so that a waiting txn costs
+    // only one message to the broker
     auto redirect_env = NewEnvelope();
-    redirect_env->mutable_request()->mutable_broker_redirect()->set_tag(txn_id);
-    redirect_env->mutable_request()->mutable_broker_redirect()->set_channel(channel());
+    auto redirect = redirect_env->mutable_request()->mutable_broker_redirect();
+    redirect->set_tag(txn_id);
+    redirect->set_channel(channel());
+    redirect->set_num_messages(state.remote_reads_waiting_on);
     Send(move(redirect_env), Broker::MakeChannel(config()->broker_ports_size() - 1));
 
-    VLOG(3) << "Defer executing txn " << txn_id << " until having enough remote reads";
-    state.phase = TransactionState::Phase::WAIT_REMOTE_READ;
+#if defined(LOCK_MANAGER_RMA)
+    // The local keys that are only read are not needed anymore so there is no reason to
+    // block the later txns writing them for the whole round trip of the remote reads
+    if (config()->early_lock_release()) {
+      auto has_read_key = std::any_of(txn.keys().begin(), txn.keys().end(),
+                                      [](const auto& kv) { return kv.value_entry().type() == KeyType::READ; });
+      if (has_read_key) {
+        NotifyScheduler(state, WorkerSignal::Type::READS_DONE);
+      }
+    }
+#endif
+
+    VLOG(3) << "Execute txn " << txn_id << " while waiting for remote reads";
   }
+  state.phase = TransactionState::Phase::EXECUTE;
 }
 
 void Worker::Execute(TxnId txn_id) {
@@ -229,13 +309,26 @@ void Worker::Execute(TxnId txn_id) {
 
   switch (txn.program_case()) {
     case Transaction::kCode: {
-      if (txn.status() != TransactionStatus::ABORTED) {
-        execution_->Execute(txn);
+      auto& cont = state.continuation;
+      if (!cont.done) {
+        cont.remote_values_pending = state.remote_reads_waiting_on > 0;
+        cont.done = txn.status() == TransactionStatus::ABORTED || execution_->Resume(txn, cont);
+        if (!cont.done) {
+          VLOG(3) << "Txn " << txn_id << " is suspended on remote keys";
+          return;
+        }
+      }
+      if (state.remote_reads_waiting_on > 0) {
+        // Another partition can still abort the txn so its writes wait for the rest of the remote reads
+        state.phase = TransactionState::Phase::WAIT_REMOTE_READ;
+        return;
       }
 
       if (txn.status() == TransactionStatus::ABORTED) {
         VLOG(3) << "Txn " << txn_id << " aborted with reason: " << txn.abort_reason();
       } else {
+        txn.set_status(TransactionStatus::COMMITTED);
+        execution_->Commit(txn);
         VLOG(3) << "Committed txn " << txn_id;
       }
       break;
@@ -263,12 +356,25 @@ void Worker::Finish(TxnId txn_id) {
   auto& state = TxnState(txn_id);
   auto txn = state.txn_holder->FinalizeAndRelease();
 
+#if defined(LOCK_MANAGER_MVCC)
+  // Let go of the versions so that they can be garbage collected. The buffers are kept for the next
+  // txn of the holder
+  state.txn_holder->versions().reads.clear();
+  state.txn_holder->versions().captures.clear();
+#endif
+
   RECORD(txn->mutable_internal(), TransactionEvent::EXIT_WORKER);
 
+  // The writes have been applied and the outcome of the txn cannot change anymore, so with early
+  // lock release, the later txns do not have to wait for the reply to the server. The txn has
+  // already been taken out of its holder so the scheduler is free to destroy the holder.
+  // Either way, the locks are released without waiting for the writes to be durable
+  auto early_lock_release = config()->early_lock_release();
+  if (early_lock_release) {
+    NotifyScheduler(state, WorkerSignal::Type::FINISHED);
+  }
+
   // Send the txn back to the coordinating server if it is in the same region.
-  // This must happen before the sending to scheduler below. Otherwise,
-  // the scheduler may destroy the transaction holder before we can
-  // send the transaction to the server.
   auto coordinator = txn->internal().coordinating_server();
   if (config()->UnpackMachineId(coordinator).first == config()->local_replica()) {
     if (config()->return_dummy_txn()) {
@@ -276,26 +382,49 @@ void Worker::Finish(TxnId txn_id) {
       txn->mutable_code()->Clear();
       txn->mutable_remaster()->Clear();
     }
-    Envelope env;
-    auto finished_sub_txn = env.mutable_request()->mutable_finished_subtxn();
-    finished_sub_txn->set_partition(config()->local_partition());
-    finished_sub_txn->set_allocated_txn(txn);
-    Send(env, txn->internal().coordinating_server(), kServerChannel);
+    // The log position covers the writes of this txn and of the earlier txns that it has read from.
+    // The flag is set before SendDurableReplies reads the durable position so that a flush right after
+    // that read wakes up the worker
+    pending_replies_.emplace_back(storage_->log_position(), txn);
+    waiting_for_durability_ = true;
+    SendDurableReplies();
   } else {
     delete txn;
   }
 
   // Notify the scheduler that we're done
-  zmq::message_t msg(sizeof(TxnId));
-  *msg.data<TxnId>() = txn_id;
-  GetCustomSocket(0).send(msg, zmq::send_flags::none);
+  if (!early_lock_release) {
+    NotifyScheduler(state, WorkerSignal::Type::FINISHED);
+  }
 
   // Done with this txn. Remove it from the state map
-  txn_states_.erase(txn_id);
+  txn_states_.Erase(txn_id);
 
   VLOG(3) << "Finished with txn " << txn_id;
 }
 
+bool Worker::SendDurableReplies() {
+  if (pending_replies_.empty()) {
+    return false;
+  }
+  auto durable_position = storage_->durable_position();
+  bool sent = false;
+  while (!pending_replies_.empty() && pending_replies_.front().first <= durable_position) {
+    auto txn = pending_replies_.front().second;
+    pending_replies_.pop_front();
+    Envelope env;
+    auto finished_sub_txn = env.mutable_request()->mutable_finished_subtxn();
+    finished_sub_txn->set_partition(config()->local_partition());
+    finished_sub_txn->set_allocated_txn(txn);
+    Send(env, txn->internal().coordinating_server(), kServerChannel);
+    sent = true;
+  }
+  if (pending_replies_.empty()) {
+    waiting_for_durability_ = false;
+  }
+  return sent;
+}
+
 void Worker::NotifyOtherPartitions(TxnId txn_id) {
   auto& state = TxnState(txn_id);
   auto txn_holder = state.txn_holder;
@@ -332,10 +461,24 @@ void Worker::NotifyOtherPartitions(TxnId txn_id) {
   Send(env, destinations, txn_id);
 }
 
+void Worker::NotifyScheduler(const TransactionState& state, WorkerSignal::Type type) {
+  WorkerSignal signal{state.txn_holder->txn_id(), state.generation, type};
+  bool was_empty;
+  // The scheduler never blocks on the workers so a full queue is drained shortly
+  while (!queues_.signals.Push(signal, was_empty)) {
+    std::this_thread::yield();
+  }
+  if (was_empty) {
+    queues_.scheduler_notifier.Notify();
+  }
+}
+
 TransactionState& Worker::TxnState(TxnId txn_id) {
-  auto state_it = txn_states_.find(txn_id);
-  DCHECK(state_it != txn_states_.end());
-  return state_it->second;
+  auto state = txn_states_.Find(txn_id);
+  DCHECK(state != nullptr);
+  DCHECK_EQ(state->txn_holder->generation(), state->generation)
+      << "Holder of txn " << txn_id << " was reused while the txn is still running";
+  return *state;
 }
 
 }  // namespace slog
\ No newline at end of file
@@ -1,14 +1,18 @@
 #pragma once
 
+#include <atomic>
+#include <deque>
 #include <functional>
 #include <optional>
-#include <unordered_map>
 #include <unordered_set>
-#include <zmq.hpp>
 
 #include "common/configuration.h"
 #include "common/metrics.h"
 #include "common/types.h"
+#include "connection/event_notifier.h"
+#include "data_structure/spmc_queue.h"
+#include "data_structure/spsc_queue.h"
+#include "data_structure/txn_table.h"
 #include "execution/execution.h"
 #include "module/base/networked_module.h"
 #include "module/scheduler_components/txn_holder.h"
@@ -19,15 +23,75 @@
 namespace slog {
 
 struct TransactionState {
-  enum class Phase { READ_LOCAL_STORAGE, WAIT_REMOTE_READ, EXECUTE, FINISH };
+  // A txn in EXECUTE may be suspended on remote keys. A txn in WAIT_REMOTE_READ has run its procedure
+  // to the end and waits for the rest of the remote reads, any of which can still abort it
+  enum class Phase { READ_LOCAL_STORAGE, EXECUTE, WAIT_REMOTE_READ, FINISH };
+
+  TransactionState(TxnHolder* txn_holder) { Reset(txn_holder); }
+
+  // Re-initializes a pooled state for another txn
+  void Reset(TxnHolder* txn_holder) {
+    this->txn_holder = txn_holder;
+    generation = txn_holder->generation();
+    remote_reads_waiting_on = 0;
+    phase = Phase::READ_LOCAL_STORAGE;
+    continuation = Continuation();
+  }
+
+  void Clear() { txn_holder = nullptr; }
 
-  TransactionState(TxnHolder* txn_holder)
-      : txn_holder(txn_holder), remote_reads_waiting_on(0), phase(Phase::READ_LOCAL_STORAGE) {}
   TxnHolder* txn_holder;
+  // Generation of the holder when the txn was dispatched. The holder is recycled for another
+  // txn after the scheduler is told that the txn finished so the generation must not change before that
+  uint32_t generation;
   uint32_t remote_reads_waiting_on;
   Phase phase;
+  Continuation continuation;
+};
+
+/**
+ * A message that a worker sends to the scheduler about a transaction
+ */
+struct WorkerSignal {
+  enum class Type : uint8_t {
+    // The txn has read its local keys so its read locks can be released. Only sent with early lock release
+    READS_DONE,
+    // The txn has been executed and its writes applied so all of its locks can be released
+    FINISHED
+  };
+  TxnId txn_id;
+  // Generation of the holder of the txn. See TransactionState
+  uint32_t generation;
+  Type type;
+};
+
+/**
+ * The queues through which the scheduler dispatches txns to a worker and the worker
+ * sends back WorkerSignals. They replace a pair of inproc sockets, which allocate a
+ * message for every txn and go through the mailbox of zmq. The scheduler notifier is
+ * shared by all workers.
+ *
+ * A worker that runs out of txns steals from the txn queues of the other workers, so
+ * a txn queued behind a long-running one does not have to wait for it.
+ */
+struct WorkerQueues {
+  WorkerQueues(size_t capacity, EventNotifier& scheduler_notifier)
+      : txns(capacity), signals(capacity), scheduler_notifier(scheduler_notifier) {}
+
+  SpmcQueue<TxnHolder*> txns;
+  EventNotifier worker_notifier;
+  SpscQueue<WorkerSignal> signals;
+  EventNotifier& scheduler_notifier;
+
+  // Set by the worker when it finds no txn to run or steal. This is only a hint for the
+  // scheduler to wake the worker up when txns start to queue up elsewhere
+  std::atomic<bool> idle = false;
+  // Number of txns that the worker took from the queues of the other workers
+  std::atomic<uint64_t> num_steals = 0;
 };
 
+using WorkerQueuesList = std::vector<std::unique_ptr<WorkerQueues>>;
+
 /**
  * A worker executes and commits transactions. Every time it receives from
  * the scheduler a message pertaining to a transaction X, it will either
@@ -37,25 +101,33 @@ struct TransactionState {
 class Worker : public NetworkedModule {
  public:
   Worker(int id, const std::shared_ptr<Broker>& broker, const std::shared_ptr<Storage>& storage,
-         const MetricsRepositoryManagerPtr& metrics_manager,
+         const MetricsRepositoryManagerPtr& metrics_manager, const WorkerQueuesList& all_queues,
          std::chrono::milliseconds poll_timeout_ms = kModuleTimeout);
+  ~Worker();
 
   std::string name() const override { return "Worker-" + std::to_string(channel()); }
 
  protected:
   void Initialize() final;
   /**
-   * Applies remote read for transactions that are in the WAIT_REMOTE_READ phase.
-   * When all remote reads are received, the transaction is moved to the EXECUTE phase.
+   * Applies a remote read to a transaction and resumes its procedure if it is suspended on remote keys.
+   * When all remote reads are received, a transaction in the WAIT_REMOTE_READ phase is moved back to the
+   * EXECUTE phase to commit.
    */
   void OnInternalRequestReceived(EnvelopePtr&& env) final;
 
   /**
-   * Receives new transaction from the scheduler
+   * Receives new transaction from the scheduler through the queues
    */
   bool OnCustomSocket() final;
 
  private:
+  /**
+   * Takes the next txn from the queue of this worker or, if it is empty, from the queue
+   * of another worker. Returns false if there is no txn anywhere
+   */
+  bool NextTxn(TxnHolder*& txn_holder);
+
   /**
    * Drives most of the phase transition of a transaction
    */
@@ -68,7 +140,9 @@ class Worker : public NetworkedModule {
   void ReadLocalStorage(TxnId txn_id);
 
   /**
-   * Executes the code inside the transaction
+   * Runs or resumes the code inside the transaction. The code may suspend on remote keys, in which
+   * case the transaction stays in the EXECUTE phase. The transaction commits once its code has ended
+   * and all remote reads are received
    */
   void Execute(TxnId txn_id);
 
@@ -77,15 +151,33 @@ class Worker : public NetworkedModule {
    */
   void Finish(TxnId txn_id);
 
+  /**
+   * Sends the finished txns whose log positions have become durable back to their coordinating servers.
+   * Returns true if any was sent
+   */
+  bool SendDurableReplies();
+
   void NotifyOtherPartitions(TxnId txn_id);
 
+  void NotifyScheduler(const TransactionState& state, WorkerSignal::Type type);
+
   // Precondition: txn_id must exists in txn states table
   TransactionState& TxnState(TxnId txn_id);
 
   std::shared_ptr<Storage> storage_;
   std::unique_ptr<Execution> execution_;
-
-  std::unordered_map<TxnId, TransactionState> txn_states_;
+  size_t id_;
+  const WorkerQueuesList& all_queues_;
+  WorkerQueues& queues_;
+
+  TxnTable<TransactionState> txn_states_;
+
+  // Finished txns waiting for the storage to make durable their writes and the writes that they have
+  // seen before they are sent back to the server, with the log positions that they wait for
+  std::deque<std::pair<uint64_t, Transaction*>> pending_replies_;
+  // Set while there are pending replies so that the storage wakes up the worker when more writes are durable
+  std::atomic<bool> waiting_for_durability_ = false;
+  int durable_listener_id_ = -1;
 };
 
 }  // namespace slog
\ No newline at end of file
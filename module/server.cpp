@@ -50,7 +50,9 @@ Transaction* Server::FinishedTransaction::ReleaseTxn() {
 
 Server::Server(const std::shared_ptr<Broker>& broker, const MetricsRepositoryManagerPtr& metrics_manager,
                std::chrono::milliseconds poll_timeout)
-    : NetworkedModule(broker, kServerChannel, metrics_manager, poll_timeout), txn_id_counter_(0) {}
+    : NetworkedModule(broker, kServerChannel, metrics_manager, poll_timeout),
+      sharder_(Sharder::MakeSharder(config())),
+      txn_id_counter_(0) {}
 
 /***********************************************
                 Initialization
@@ -122,6 +124,16 @@ bool Server::OnCustomSocket() {
 
       RECORD(txn_internal, TransactionEvent::EXIT_SERVER_TO_FORWARDER);
 
+      uint32_t partition;
+      if (CanServeFromSnapshot(*txn, partition)) {
+        txn_internal->set_snapshot(true);
+        // The forwarder of the partition can look up all masters locally
+        auto env = NewEnvelope();
+        env->mutable_request()->mutable_forward_txn()->set_allocated_txn(txn);
+        Send(move(env), config()->MakeMachineId(config()->local_replica(), partition), kForwarderChannel);
+        break;
+      }
+
       // Send to forwarder
       auto env = NewEnvelope();
       env->mutable_request()->mutable_forward_txn()->set_allocated_txn(txn);
@@ -294,6 +306,25 @@ void Server::SendResponseToClient(TxnId txn_id, api::Response&& res) {
   pending_responses_.erase(txn_id);
 }
 
+bool Server::CanServeFromSnapshot(const Transaction& txn, uint32_t& partition) const {
+  if (!config()->snapshot_read_only_txns() || txn.program_case() != Transaction::kCode ||
+      txn.keys().empty()) {
+    return false;
+  }
+  try {
+    partition = sharder_->compute_partition(txn.keys(0).key());
+    for (const auto& kv : txn.keys()) {
+      if (kv.value_entry().type() != KeyType::READ || sharder_->compute_partition(kv.key()) != partition) {
+        return false;
+      }
+    }
+  } catch (std::invalid_argument&) {
+    // Let the forwarder report the invalid key
+    return false;
+  }
+  return true;
+}
+
 TxnId Server::NextTxnId() {
   txn_id_counter_++;
   return txn_id_counter_ * kMaxNumMachines + config()->local_machine_id();
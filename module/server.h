@@ -12,6 +12,7 @@
 
 #include "common/configuration.h"
 #include "common/proto_utils.h"
+#include "common/sharder.h"
 #include "common/types.h"
 #include "connection/broker.h"
 #include "module/base/networked_module.h"
@@ -28,6 +29,18 @@ namespace slog {
  * OUTPUT: For external TransactionRequest, it forwards the txn internally
  *         to appropriate modules and waits for internal responses before
  *         responding back to the client with an external TransactionResponse.
+ *
+ * Snapshot reads:
+ * If snapshot_read_only_txns is enabled, a txn that only reads keys of a single
+ * partition is sent to the Forwarder of that partition in the local region, which
+ * looks up the masters of the keys. If all keys have the same home, the txn skips
+ * the global log and is handed to the Scheduler of the same machine. Otherwise, it
+ * goes through the log like any other multi-home txn, because locking keys of
+ * several homes outside of the log order can deadlock. In the Scheduler, the txn
+ * is placed at the current end of the local log: it observes the effects of every
+ * txn that entered the Scheduler before it and of none after it. The snapshot is
+ * consistent but may lag behind other regions, whose logs are replicated to the
+ * local region asynchronously.
  */
 class Server : public NetworkedModule {
  public:
@@ -61,6 +74,10 @@ class Server : public NetworkedModule {
 
   TxnId NextTxnId();
 
+  // Returns true if the txn can be served from a snapshot of the local region
+  bool CanServeFromSnapshot(const Transaction& txn, uint32_t& partition) const;
+
+  SharderPtr sharder_;
   TxnId txn_id_counter_;
 
   struct PendingResponse {
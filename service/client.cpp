@@ -233,6 +233,7 @@ string LockModeStr(LockMode mode) {
 
 void PrintSchedulerStats(const rapidjson::Document& stats, uint32_t level) {
   cout << "Number of active txns: " << stats[NUM_ALL_TXNS].GetUint() << "\n";
+  cout << "Number of pooled txn holders: " << stats[NUM_POOLED_TXN_HOLDERS].GetUint() << "\n";
   cout << "\nACTIVE TRANSACTIONS\n\n";
   if (level == 0) {
     TRUNCATED_FOR_EACH(txn_id, stats[ALL_TXNS].GetArray()) { cout << txn_id.GetUint() << " "; }
@@ -0,0 +1,154 @@
+#include <time.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <random>
+#include <type_traits>
+
+#include "common/string_utils.h"
+#include "module/scheduler_components/ddr_lock_manager.h"
+#include "module/scheduler_components/dependency_graph_manager.h"
+#include "service/service_utils.h"
+
+DEFINE_uint32(txns, 1000000, "Number of transactions");
+DEFINE_string(keys, "100,1000000", "Comma-separated list of key space sizes. Smaller key spaces have higher contention");
+DEFINE_uint32(keys_per_txn, 10, "Number of keys accessed by each transaction");
+DEFINE_uint32(write_pct, 50, "Percentage of keys that are written");
+DEFINE_uint32(batch_size, 100, "Number of transactions in a batch");
+DEFINE_uint32(in_flight, 1000, "Maximum number of transactions in the scheduler at any time");
+DEFINE_uint32(rounds, 3, "Number of times each benchmark is repeated. The best round is reported");
+
+using namespace slog;
+
+using std::vector;
+
+namespace {
+
+vector<Transaction> GenerateTxns(uint64_t num_keys) {
+  std::mt19937 rg(0);
+  std::uniform_int_distribution<uint64_t> key_dist(0, num_keys - 1);
+  std::uniform_int_distribution<uint32_t> pct_dist(0, 99);
+  vector<Transaction> txns(FLAGS_txns);
+  vector<uint64_t> keys;
+  for (size_t i = 0; i < txns.size(); i++) {
+    auto& txn = txns[i];
+    txn.mutable_internal()->set_id(i + 1);
+    txn.mutable_internal()->set_home(0);
+    keys.clear();
+    while (keys.size() < std::min<uint64_t>(FLAGS_keys_per_txn, num_keys)) {
+      auto key = key_dist(rg);
+      if (std::find(keys.begin(), keys.end(), key) == keys.end()) {
+        keys.push_back(key);
+      }
+    }
+    for (auto key : keys) {
+      auto entry = txn.add_keys();
+      entry->set_key("key" + std::to_string(key));
+      auto value_entry = entry->mutable_value_entry();
+      value_entry->set_type(pct_dist(rg) < FLAGS_write_pct ? KeyType::WRITE : KeyType::READ);
+      value_entry->mutable_metadata()->set_master(0);
+    }
+  }
+  return txns;
+}
+
+double CpuTimeNs() {
+  timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Feeds the txns to the scheduler component in batches and finishes the ready txns in the order
+ * they become ready, keeping at most FLAGS_in_flight txns in the component. The DDR lock manager
+ * takes the txns of a batch one by one while the dependency graph takes the whole batch at once.
+ * Returns the CPU time per txn in nanoseconds and a checksum of the finishing order.
+ */
+template <typename Manager>
+std::pair<double, uint64_t> Run(vector<Transaction>& txns) {
+  Manager manager;
+  std::queue<TxnId> ready;
+  vector<TxnId> batch_ready;
+  vector<Transaction*> batch;
+  size_t num_in_flight = 0;
+  uint64_t checksum = 0, num_finished = 0;
+  auto FinishOne = [&] {
+    auto txn_id = ready.front();
+    ready.pop();
+    num_in_flight--;
+    checksum = checksum * 31 + txn_id;
+    num_finished++;
+    for (auto new_txn : manager.ReleaseLocks(txn_id)) {
+      ready.push(new_txn);
+    }
+  };
+
+  auto start_time = CpuTimeNs();
+  for (size_t batch_start = 0; batch_start < txns.size(); batch_start += FLAGS_batch_size) {
+    auto batch_end = std::min<size_t>(batch_start + FLAGS_batch_size, txns.size());
+    while (num_in_flight > 0 && num_in_flight + batch_end - batch_start > FLAGS_in_flight) {
+      FinishOne();
+    }
+    num_in_flight += batch_end - batch_start;
+
+    if constexpr (std::is_same_v<Manager, DependencyGraphManager>) {
+      batch.clear();
+      for (auto i = batch_start; i < batch_end; i++) {
+        batch.push_back(&txns[i]);
+      }
+      batch_ready.clear();
+      manager.AcquireLocks(batch, batch_ready);
+      for (auto txn_id : batch_ready) {
+        ready.push(txn_id);
+      }
+    } else {
+      for (auto i = batch_start; i < batch_end; i++) {
+        if (manager.AcquireLocks(txns[i]) == AcquireLocksResult::ACQUIRED) {
+          ready.push(txns[i].internal().id());
+        }
+      }
+    }
+  }
+  while (!ready.empty()) {
+    FinishOne();
+  }
+  auto elapsed = CpuTimeNs() - start_time;
+  CHECK_EQ(num_finished, txns.size()) << "Some txns never became ready";
+  return {elapsed / txns.size(), checksum};
+}
+
+template <typename Manager>
+std::pair<double, uint64_t> RunBest(vector<Transaction>& txns) {
+  std::pair<double, uint64_t> best{std::numeric_limits<double>::max(), 0};
+  for (uint32_t i = 0; i < FLAGS_rounds; i++) {
+    auto res = Run<Manager>(txns);
+    best = {std::min(best.first, res.first), res.second};
+  }
+  return best;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  InitializeService(&argc, &argv);
+
+  std::cout << std::setw(12) << "keys" << std::setw(16) << "ddr (ns/txn)" << std::setw(16) << "dag (ns/txn)"
+            << std::setw(10) << "speedup" << std::endl;
+  for (const auto& keys_str : Split(FLAGS_keys, ",")) {
+    auto num_keys = std::stoull(keys_str);
+    auto txns = GenerateTxns(num_keys);
+
+    auto [ddr_time, ddr_checksum] = RunBest<DDRLockManager>(txns);
+    auto [dag_time, dag_checksum] = RunBest<DependencyGraphManager>(txns);
+    CHECK_EQ(ddr_checksum, dag_checksum) << "Transactions became ready in different orders";
+
+    std::cout << std::setw(12) << num_keys << std::setw(16) << std::fixed << std::setprecision(0) << ddr_time
+              << std::setw(16) << dag_time << std::setw(10) << std::setprecision(2) << ddr_time / dag_time
+              << std::endl;
+  }
+
+  return 0;
+}
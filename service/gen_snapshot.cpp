@@ -0,0 +1,127 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <random>
+#include <thread>
+
+#include "common/configuration.h"
+#include "common/offline_data_reader.h"
+#include "common/sharder.h"
+#include "common/snapshot.h"
+#include "service/service_utils.h"
+
+DEFINE_string(config, "slog.conf", "Path to the configuration file. Used to partition the keys");
+DEFINE_string(out_dir, ".", "Directory to write the snapshots to");
+DEFINE_int32(partition, -1, "Generate data for this partition only. Use -1 to generate data for all partitions");
+DEFINE_uint64(records, 1000000, "Total number of records across all partitions");
+DEFINE_uint32(record_size, 100, "Size of each record in bytes");
+DEFINE_string(convert, "",
+              "If set, convert this data file in the length-prefixed Datum format, as produced by "
+              "tools/gen_data.py, into a snapshot instead of generating new data");
+
+using namespace slog;
+
+using std::string;
+
+namespace {
+
+const char kAlphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+const char kBase64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Same key encoding as tools/gen_data.py: base64 of the 8-byte little-endian representation of the key
+string EncodeKey(uint64_t key) {
+  uint8_t bytes[9] = {};
+  for (int i = 0; i < 8; i++) {
+    bytes[i] = (key >> (8 * i)) & 0xFF;
+  }
+  string encoded;
+  for (int i = 0; i < 9; i += 3) {
+    uint32_t triple = (bytes[i] << 16) | (bytes[i + 1] << 8) | bytes[i + 2];
+    encoded += kBase64Chars[(triple >> 18) & 0x3F];
+    encoded += kBase64Chars[(triple >> 12) & 0x3F];
+    encoded += kBase64Chars[(triple >> 6) & 0x3F];
+    encoded += kBase64Chars[triple & 0x3F];
+  }
+  // 8 bytes are encoded into 11 characters plus one padding character
+  encoded[11] = '=';
+  return encoded;
+}
+
+void GeneratePartition(const ConfigurationPtr& config, const SharderPtr& sharder, uint32_t partition) {
+  uint64_t num_records = 0;
+  for (uint64_t key = 0; key < FLAGS_records; key++) {
+    num_records += sharder->compute_partition(EncodeKey(key)) == partition;
+  }
+
+  auto path = FLAGS_out_dir + "/" + std::to_string(partition) + ".snap";
+  LOG(INFO) << "Generating " << num_records << " records for " << path;
+
+  // Per-partition seed so that partitions have different values
+  std::mt19937 rg(partition);
+  std::uniform_int_distribution<size_t> char_dist(0, sizeof(kAlphabet) - 2);
+  string value(FLAGS_record_size, ' ');
+
+  SnapshotWriter writer(path, num_records);
+  for (uint64_t key = 0; key < FLAGS_records; key++) {
+    auto encoded_key = EncodeKey(key);
+    if (sharder->compute_partition(encoded_key) != partition) {
+      continue;
+    }
+    for (auto& c : value) {
+      c = kAlphabet[char_dist(rg)];
+    }
+    writer.Add(encoded_key, value, Metadata(key % config->num_replicas()));
+  }
+  writer.Finish();
+
+  LOG(INFO) << "Finished " << path;
+}
+
+void Convert(const string& data_file) {
+  auto fd = open(data_file.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(FATAL) << "Error while opening \"" << data_file << "\": " << strerror(errno);
+  }
+  OfflineDataReader reader(fd);
+
+  auto name = data_file.substr(data_file.rfind('/') + 1);
+  name = name.substr(0, name.rfind('.'));
+  auto path = FLAGS_out_dir + "/" + name + ".snap";
+  LOG(INFO) << "Converting " << reader.GetNumDatums() << " datums from " << data_file << " into " << path;
+
+  SnapshotWriter writer(path, reader.GetNumDatums());
+  while (reader.HasNextDatum()) {
+    auto datum = reader.GetNextDatum();
+    writer.Add(datum.key(), datum.record(), Metadata(datum.master()));
+  }
+  writer.Finish();
+  close(fd);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  InitializeService(&argc, &argv);
+
+  if (!FLAGS_convert.empty()) {
+    Convert(FLAGS_convert);
+    return 0;
+  }
+
+  auto config = Configuration::FromFile(FLAGS_config, "");
+  CHECK(!config->proto_config().has_simple_partitioning() && !config->proto_config().has_tpcc_partitioning())
+      << "Only hash partitioning loads data from files";
+  auto sharder = Sharder::MakeSharder(config);
+
+  std::vector<std::thread> threads;
+  for (uint32_t p = 0; p < config->num_partitions(); p++) {
+    if (FLAGS_partition < 0 || static_cast<uint32_t>(FLAGS_partition) == p) {
+      threads.emplace_back(GeneratePartition, config, sharder, p);
+    }
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  return 0;
+}
@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <queue>
+#include <random>
+#include <unordered_map>
+
+#include "common/string_utils.h"
+#include "module/scheduler_components/rma_lock_manager.h"
+#include "service/service_utils.h"
+
+DEFINE_uint32(txns, 1000000, "Number of transactions");
+DEFINE_string(keys, "100,1000000", "Comma-separated list of key space sizes. Smaller key spaces have higher contention");
+DEFINE_uint32(keys_per_txn, 10, "Number of keys accessed by each transaction");
+DEFINE_uint32(write_pct, 50, "Percentage of keys that are written");
+DEFINE_uint32(in_flight, 1000, "Maximum number of transactions in the lock manager at any time");
+DEFINE_uint32(rounds, 3, "Number of times each benchmark is repeated. The best round is reported");
+
+using namespace slog;
+using namespace std::chrono;
+
+using std::string;
+using std::vector;
+
+namespace {
+
+/**
+ * The RMA lock manager as it was before the flat lock table: a node-based hash map from
+ * <key, replica> to a lock state holding a vector of holders and a linked list of waiters.
+ * Kept here as the baseline of the benchmark.
+ */
+class BaselineLockManager {
+ public:
+  BaselineLockManager() { txn_info_.reserve(1000000); }
+
+  AcquireLocksResult AcquireLocks(const Transaction& txn) {
+    auto txn_id = txn.internal().id();
+    auto home = txn.internal().home();
+    auto& txn_info = txn_info_.try_emplace(txn_id, txn.keys_size()).first->second;
+    for (const auto& kv : txn.keys()) {
+      if (static_cast<int>(kv.value_entry().metadata().master()) != home) {
+        continue;
+      }
+      key_replica_.key.assign(kv.key());
+      key_replica_.replica = home;
+      auto& lock_state = lock_table_[key_replica_];
+      txn_info.locks.push_back(&lock_state);
+      bool acquired = kv.value_entry().type() == KeyType::READ ? lock_state.AcquireReadLock(txn_id)
+                                                                 : lock_state.AcquireWriteLock(txn_id);
+      if (acquired) {
+        txn_info.num_waiting_for--;
+      }
+    }
+    return txn_info.num_waiting_for == 0 ? AcquireLocksResult::ACQUIRED : AcquireLocksResult::WAITING;
+  }
+
+  vector<TxnId> ReleaseLocks(TxnId txn_id) {
+    vector<TxnId> result;
+    auto info_it = txn_info_.find(txn_id);
+    for (auto lock_state : info_it->second.locks) {
+      for (auto new_txn : lock_state->Release(txn_id)) {
+        if (--txn_info_.at(new_txn).num_waiting_for == 0) {
+          result.push_back(new_txn);
+        }
+      }
+    }
+    txn_info_.erase(info_it);
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+  }
+
+ private:
+  struct LockState {
+    bool AcquireReadLock(TxnId txn_id) {
+      if (mode == LockMode::UNLOCKED || (mode == LockMode::READ && waiters.empty())) {
+        holders.push_back(txn_id);
+        mode = LockMode::READ;
+        return true;
+      }
+      waiters.emplace_back(txn_id, LockMode::READ);
+      return false;
+    }
+
+    bool AcquireWriteLock(TxnId txn_id) {
+      if (mode == LockMode::UNLOCKED) {
+        holders.push_back(txn_id);
+        mode = LockMode::WRITE;
+        return true;
+      }
+      waiters.emplace_back(txn_id, LockMode::WRITE);
+      return false;
+    }
+
+    vector<TxnId> Release(TxnId txn_id) {
+      holders.erase(std::find(holders.begin(), holders.end(), txn_id));
+      if (!holders.empty()) {
+        return {};
+      }
+      if (waiters.empty()) {
+        mode = LockMode::UNLOCKED;
+        return {};
+      }
+      mode = waiters.front().second;
+      do {
+        holders.push_back(waiters.front().first);
+        waiters.pop_front();
+      } while (mode == LockMode::READ && !waiters.empty() && waiters.front().second == LockMode::READ);
+      return holders;
+    }
+
+    LockMode mode = LockMode::UNLOCKED;
+    vector<TxnId> holders;
+    std::list<std::pair<TxnId, LockMode>> waiters;
+  };
+
+  struct TxnInfo {
+    TxnInfo(int num_keys) : num_waiting_for(num_keys) { locks.reserve(num_keys); }
+    int num_waiting_for;
+    vector<LockState*> locks;
+  };
+
+  std::unordered_map<TxnId, TxnInfo> txn_info_;
+  std::unordered_map<KeyReplica, LockState, KeyReplicaHash> lock_table_;
+  KeyReplica key_replica_;
+};
+
+vector<Transaction> GenerateTxns(uint64_t num_keys) {
+  std::mt19937 rg(0);
+  std::uniform_int_distribution<uint64_t> key_dist(0, num_keys - 1);
+  std::uniform_int_distribution<uint32_t> pct_dist(0, 99);
+  vector<Transaction> txns(FLAGS_txns);
+  vector<uint64_t> keys;
+  for (size_t i = 0; i < txns.size(); i++) {
+    auto& txn = txns[i];
+    txn.mutable_internal()->set_id(i + 1);
+    txn.mutable_internal()->set_home(0);
+    keys.clear();
+    while (keys.size() < std::min<uint64_t>(FLAGS_keys_per_txn, num_keys)) {
+      auto key = key_dist(rg);
+      if (std::find(keys.begin(), keys.end(), key) == keys.end()) {
+        keys.push_back(key);
+      }
+    }
+    for (auto key : keys) {
+      auto entry = txn.add_keys();
+      entry->set_key("key" + std::to_string(key));
+      auto value_entry = entry->mutable_value_entry();
+      value_entry->set_type(pct_dist(rg) < FLAGS_write_pct ? KeyType::WRITE : KeyType::READ);
+      value_entry->mutable_metadata()->set_master(0);
+    }
+  }
+  return txns;
+}
+
+/**
+ * Feeds the txns to the lock manager in order and releases the ready txns in the order they
+ * become ready, keeping at most FLAGS_in_flight txns in the lock manager. Returns the elapsed
+ * time and a checksum of the release order, which must be the same for all lock managers
+ */
+template <typename LockManager>
+std::pair<double, uint64_t> Run(const vector<Transaction>& txns) {
+  LockManager lock_manager;
+  std::queue<TxnId> ready;
+  size_t num_in_flight = 0;
+  uint64_t checksum = 0, num_released = 0;
+  auto ReleaseOne = [&] {
+    auto txn_id = ready.front();
+    ready.pop();
+    num_in_flight--;
+    checksum = checksum * 31 + txn_id;
+    num_released++;
+    for (auto new_txn : lock_manager.ReleaseLocks(txn_id)) {
+      ready.push(new_txn);
+    }
+  };
+
+  auto start_time = steady_clock::now();
+  for (const auto& txn : txns) {
+    while (num_in_flight >= FLAGS_in_flight) {
+      ReleaseOne();
+    }
+    num_in_flight++;
+    if (lock_manager.AcquireLocks(txn) == AcquireLocksResult::ACQUIRED) {
+      ready.push(txn.internal().id());
+    }
+  }
+  while (!ready.empty()) {
+    ReleaseOne();
+  }
+  auto elapsed = duration_cast<microseconds>(steady_clock::now() - start_time).count() / 1000000.0;
+  CHECK_EQ(num_released, txns.size()) << "Some txns never got their locks";
+  return {elapsed, checksum};
+}
+
+template <typename LockManager>
+std::pair<double, uint64_t> RunBest(const vector<Transaction>& txns) {
+  std::pair<double, uint64_t> best{std::numeric_limits<double>::max(), 0};
+  for (uint32_t i = 0; i < FLAGS_rounds; i++) {
+    auto res = Run<LockManager>(txns);
+    best = {std::min(best.first, res.first), res.second};
+  }
+  return best;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  InitializeService(&argc, &argv);
+
+  std::cout << std::setw(12) << "keys" << std::setw(22) << "baseline (txns/s)" << std::setw(22) << "rma (txns/s)"
+            << std::setw(10) << "speedup" << std::endl;
+  for (const auto& keys_str : Split(FLAGS_keys, ",")) {
+    auto num_keys = std::stoull(keys_str);
+    auto txns = GenerateTxns(num_keys);
+
+    auto [baseline_time, baseline_checksum] = RunBest<BaselineLockManager>(txns);
+    auto [rma_time, rma_checksum] = RunBest<RMALockManager>(txns);
+    CHECK_EQ(baseline_checksum, rma_checksum) << "Lock managers granted locks in different orders";
+
+    std::cout << std::setw(12) << num_keys << std::setw(22) << std::fixed << std::setprecision(0)
+              << txns.size() / baseline_time << std::setw(22) << txns.size() / rma_time << std::setw(10)
+              << std::setprecision(2) << baseline_time / rma_time << std::endl;
+  }
+
+  return 0;
+}
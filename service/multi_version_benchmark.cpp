@@ -0,0 +1,162 @@
+#include <time.h>
+
+#include <algorithm>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "common/configuration.h"
+#include "module/scheduler_components/ddr_lock_manager.h"
+#include "module/scheduler_components/multi_version_manager.h"
+#include "service/service_utils.h"
+#include "workload/tpcc.h"
+#include "workload/workload.h"
+
+DEFINE_string(workload, "ycsb", "Workload to run. Choose from (ycsb and tpcc)");
+DEFINE_uint32(txns, 200000, "Number of transactions");
+DEFINE_uint32(records, 1000000, "Number of records in the YCSB workload");
+DEFINE_double(zipf, 0.99, "Zipf coefficient of the keys accessed in the YCSB workload");
+DEFINE_uint32(keys_per_txn, 10, "Number of keys accessed by each transaction in the YCSB workload");
+DEFINE_uint32(write_pct, 20, "Percentage of keys that are written in the YCSB workload");
+DEFINE_uint32(warehouses, 4, "Number of warehouses in the TPC-C workload");
+DEFINE_uint32(workers, 32, "Number of transactions that can execute at the same time");
+DEFINE_uint32(in_flight, 1000, "Maximum number of transactions in the scheduler at any time");
+
+using namespace slog;
+
+using std::vector;
+
+namespace {
+
+vector<Transaction> GenerateYCSBTxns() {
+  std::mt19937 rg(0);
+  auto key_dist = zipf_distribution(FLAGS_zipf, FLAGS_records);
+  std::uniform_int_distribution<uint32_t> pct_dist(0, 99);
+  vector<Transaction> txns(FLAGS_txns);
+  vector<int> keys;
+  for (auto& txn : txns) {
+    keys.clear();
+    while (keys.size() < std::min<size_t>(FLAGS_keys_per_txn, FLAGS_records)) {
+      auto key = key_dist(rg);
+      if (std::find(keys.begin(), keys.end(), key) == keys.end()) {
+        keys.push_back(key);
+      }
+    }
+    for (auto key : keys) {
+      auto entry = txn.add_keys();
+      entry->set_key("key" + std::to_string(key));
+      entry->mutable_value_entry()->set_type(pct_dist(rg) < FLAGS_write_pct ? KeyType::WRITE : KeyType::READ);
+    }
+  }
+  return txns;
+}
+
+vector<Transaction> GenerateTPCCTxns() {
+  internal::Configuration config_proto;
+  config_proto.add_replicas()->add_addresses("/tmp/multi_version_benchmark");
+  config_proto.add_broker_ports(0);
+  config_proto.set_server_port(5000);
+  config_proto.set_sequencer_port(5001);
+  config_proto.set_forwarder_port(5002);
+  config_proto.set_num_partitions(1);
+  config_proto.mutable_tpcc_partitioning()->set_warehouses(FLAGS_warehouses);
+  config_proto.set_execution_type(internal::ExecutionType::TPC_C);
+  auto config = std::make_shared<Configuration>(config_proto, "/tmp/multi_version_benchmark");
+
+  TPCCWorkload workload(config, 0, "overlap_ratio=0", {1, 1}, 0);
+  vector<Transaction> txns(FLAGS_txns);
+  for (auto& txn : txns) {
+    std::unique_ptr<Transaction> generated(workload.NextTransaction().first);
+    txn.mutable_keys()->Swap(generated->mutable_keys());
+  }
+  return txns;
+}
+
+double CpuTimeNs() {
+  timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+struct Result {
+  // Number of time steps needed to execute all txns
+  uint64_t steps;
+  double cpu_ns_per_txn;
+};
+
+/**
+ * Simulates the scheduler with a fixed number of workers. In each time step, up to FLAGS_workers
+ * ready txns execute and finish, then new txns are admitted until FLAGS_in_flight txns are in
+ * the scheduler. The fewer steps, the more concurrency the scheduling scheme allows.
+ */
+template <typename Manager>
+Result Run(const vector<Transaction>& txns) {
+  Manager manager;
+  std::deque<TxnId> ready;
+  vector<TxnId> executing;
+  size_t next_txn = 0, num_in_flight = 0, num_finished = 0;
+  uint64_t steps = 0;
+
+  auto start_time = CpuTimeNs();
+  while (num_finished < txns.size()) {
+    while (next_txn < txns.size() && num_in_flight < FLAGS_in_flight) {
+      if (manager.AcquireLocks(txns[next_txn]) == AcquireLocksResult::ACQUIRED) {
+        ready.push_back(txns[next_txn].internal().id());
+      }
+      next_txn++;
+      num_in_flight++;
+    }
+
+    executing.clear();
+    while (!ready.empty() && executing.size() < FLAGS_workers) {
+      executing.push_back(ready.front());
+      ready.pop_front();
+    }
+    CHECK(!executing.empty()) << "No txn can make progress";
+    for (auto txn_id : executing) {
+      for (auto new_txn : manager.ReleaseLocks(txn_id)) {
+        ready.push_back(new_txn);
+      }
+    }
+    num_in_flight -= executing.size();
+    num_finished += executing.size();
+    steps++;
+  }
+  return {steps, (CpuTimeNs() - start_time) / txns.size()};
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  InitializeService(&argc, &argv);
+
+  vector<Transaction> txns;
+  if (FLAGS_workload == "ycsb") {
+    txns = GenerateYCSBTxns();
+  } else if (FLAGS_workload == "tpcc") {
+    txns = GenerateTPCCTxns();
+  } else {
+    LOG(FATAL) << "Unknown workload: " << FLAGS_workload;
+  }
+  for (size_t i = 0; i < txns.size(); i++) {
+    txns[i].mutable_internal()->set_id(i + 1);
+    txns[i].mutable_internal()->set_home(0);
+    for (auto& kv : *txns[i].mutable_keys()) {
+      kv.mutable_value_entry()->mutable_metadata()->set_master(0);
+    }
+  }
+
+  auto ddr = Run<DDRLockManager>(txns);
+  auto mvcc = Run<MultiVersionManager>(txns);
+
+  std::cout << std::setw(8) << "scheme" << std::setw(12) << "steps" << std::setw(16) << "txns/step"
+            << std::setw(16) << "cpu (ns/txn)" << std::endl;
+  for (auto [name, res] : {std::make_pair("ddr", ddr), std::make_pair("mvcc", mvcc)}) {
+    std::cout << std::setw(8) << name << std::setw(12) << res.steps << std::setw(16) << std::fixed
+              << std::setprecision(2) << static_cast<double>(txns.size()) / res.steps << std::setw(16)
+              << std::setprecision(0) << res.cpu_ns_per_txn << std::endl;
+  }
+
+  return 0;
+}
@@ -17,6 +17,9 @@ DEFINE_string(params, "hot=0,hot_records=0", "Basic workload params");
 DEFINE_double(sample, 10, "Percent of sampled transactions to be written to result files");
 DEFINE_string(out_dir, ".", "Directory containing output data");
 DEFINE_string(execution, "key_value", "Execution type. Choose from (noop and key_value)");
+DEFINE_uint32(max_in_flight, 0,
+              "Maximum number of txns sent to the scheduler whose results have not been received yet. With 1, the "
+              "txns go through the scheduler one at a time. Send all txns at once if 0");
 
 using namespace slog;
 using namespace std::chrono;
@@ -55,7 +58,13 @@ int main(int argc, char* argv[]) {
     LOG(FATAL) << "Unknown commands type: " << FLAGS_execution;
   }
 
+  // Record the events around the handoff between the scheduler and the workers
+  config_proto.add_enabled_events(TransactionEvent::DISPATCHED_FAST);
+  config_proto.add_enabled_events(TransactionEvent::DISPATCHED_SLOW);
+  config_proto.add_enabled_events(TransactionEvent::ENTER_WORKER);
+
   auto config = make_shared<Configuration>(config_proto, address);
+  INIT_RECORDING(config);
   auto storage = make_shared<slog::MemOnlyStorage>();
 
   // Prepare the modules
@@ -84,25 +93,29 @@ int main(int argc, char* argv[]) {
 
   auto start_time = std::chrono::steady_clock::now();
 
-  // Send transactions to the scheduler
-  LOG(INFO) << "Sending all transactions through the scheduler";
+  // Send transactions to the scheduler and receive the results, keeping at most max_in_flight txns in flight
+  LOG(INFO) << "Sending transactions through the scheduler with at most "
+            << (FLAGS_max_in_flight == 0 ? string("all") : std::to_string(FLAGS_max_in_flight)) << " in flight";
   std::unordered_map<TxnId, TxnInfo::TimePoint> sent_at;
   Sender sender(config, broker->context());
-  for (auto txn : transactions) {
-    auto env = std::make_unique<internal::Envelope>();
-    env->mutable_request()->mutable_forward_txn()->set_allocated_txn(txn);
-    sender.Send(std::move(env), kSchedulerChannel);
-    sent_at[txn->internal().id()] = std::chrono::system_clock::now();
-  }
-
-  // Receive the results
-  LOG(INFO) << "Collecting results";
   vector<TxnInfo> results;
-  for (size_t i = 0; i < transactions.size(); i++) {
+  size_t num_sent = 0;
+  system_clock::duration total_latency(0);
+  while (results.size() < transactions.size()) {
+    while (num_sent < transactions.size() &&
+           (FLAGS_max_in_flight == 0 || num_sent - results.size() < FLAGS_max_in_flight)) {
+      auto txn = transactions[num_sent++];
+      auto env = std::make_unique<internal::Envelope>();
+      env->mutable_request()->mutable_forward_txn()->set_allocated_txn(txn);
+      sent_at[txn->internal().id()] = std::chrono::system_clock::now();
+      sender.Send(std::move(env), kSchedulerChannel);
+    }
+
     auto env = RecvEnvelope(result_socket);
     auto txn = env->mutable_request()->mutable_finished_subtxn()->release_txn();
     auto txn_id = txn->internal().id();
     results.push_back({.txn = txn, .sent_at = sent_at[txn_id]});
+    total_latency += system_clock::now() - results.back().sent_at;
   }
 
   auto duration = duration_cast<milliseconds>(std::chrono::steady_clock::now() - start_time);
@@ -113,6 +126,27 @@ int main(int argc, char* argv[]) {
     auto avg_throughput = FLAGS_txns / (duration.count() / 1000.0);
     LOG(INFO) << "Avg. Throughput: " << std::fixed << std::setprecision(3) << avg_throughput << " txn/s";
   }
+  LOG(INFO) << "Avg. latency: " << duration_cast<nanoseconds>(total_latency).count() / 1000.0 / results.size() << " us";
+
+  // Measure the time from being dispatched by the scheduler to entering a worker
+  int64_t total_dispatch_latency = 0;
+  size_t num_dispatches = 0;
+  for (const auto& info : results) {
+    int64_t dispatched_at = 0;
+    for (const auto& e : info.txn->internal().events()) {
+      if (e.event() == TransactionEvent::DISPATCHED_FAST || e.event() == TransactionEvent::DISPATCHED_SLOW) {
+        dispatched_at = e.time();
+      } else if (e.event() == TransactionEvent::ENTER_WORKER && dispatched_at > 0) {
+        total_dispatch_latency += e.time() - dispatched_at;
+        num_dispatches++;
+      }
+    }
+  }
+  if (num_dispatches > 0) {
+    auto avg_dispatch_latency = duration_cast<nanoseconds>(system_clock::duration(total_dispatch_latency)).count() /
+                                static_cast<double>(num_dispatches);
+    LOG(INFO) << "Avg. dispatch latency: " << avg_dispatch_latency / 1000.0 << " us";
+  }
 
   // Sample a subset of the result
   std::mt19937 rg(0);
@@ -1,6 +1,10 @@
 #include <fcntl.h>
+#include <unistd.h>
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <queue>
 #include <vector>
 
 #include "common/configuration.h"
@@ -8,6 +12,7 @@
 #include "common/metrics.h"
 #include "common/offline_data_reader.h"
 #include "common/sharder.h"
+#include "common/snapshot.h"
 #include "common/types.h"
 #include "connection/broker.h"
 #include "execution/tpcc/load_tables.h"
@@ -22,6 +27,8 @@
 #include "proto/internal.pb.h"
 #include "proto/offline_data.pb.h"
 #include "service/service_utils.h"
+#include "storage/flat_mem_only_storage.h"
+#include "storage/log_storage.h"
 #include "storage/mem_only_storage.h"
 #include "storage/metadata_initializer.h"
 #include "version.h"
@@ -29,7 +36,7 @@
 DEFINE_string(config, "slog.conf", "Path to the configuration file");
 DEFINE_string(address, "", "Address of the local machine");
 DEFINE_string(data_dir, "", "Directory containing intial data");
-DEFINE_uint32(data_threads, 3, "Number of threads used to generate initial data");
+DEFINE_uint32(data_threads, 3, "Number of threads used to generate or load initial data");
 
 using slog::Broker;
 using slog::ConfigurationPtr;
@@ -40,45 +47,198 @@ using slog::Record;
 
 using std::make_shared;
 
+void LoadSnapshot(slog::Storage& storage, const ConfigurationPtr& config, const string& snapshot_file) {
+  slog::SnapshotReader reader(snapshot_file);
+  auto num_records = reader.num_records();
+  LOG(INFO) << "Loading " << num_records << " records from snapshot using " << FLAGS_data_threads << " threads...";
+
+  auto sharder = slog::Sharder::MakeSharder(config);
+  storage.Reserve(num_records);
+
+  // Each thread loads a contiguous range of records so that it reads the file sequentially. Records
+  // are written in batches so that each segment of the storage is latched once per batch
+  const size_t kBatchSize = 1000;
+  std::atomic<uint64_t> counter = 0;
+  std::atomic<size_t> num_done = 0;
+  auto LoadFn = [&](uint64_t from, uint64_t to) {
+    reader.WillNeed(from, to);
+    vector<Key> keys(kBatchSize);
+    vector<const Key*> key_ptrs;
+    vector<Record> records;
+    for (uint64_t i = from; i < to; i++) {
+      auto entry = reader.Get(i);
+      auto& key = keys[key_ptrs.size()];
+      key.assign(entry.key);
+      CHECK(sharder->is_local_key(key))
+          << "Key " << key << " does not belong to partition " << config->local_partition();
+      CHECK_LT(entry.metadata.master, config->num_replicas()) << "Master number exceeds number of replicas";
+
+      auto& record = records.emplace_back();
+      record.SetValue(entry.value.data(), entry.value.size());
+      record.SetMetadata(entry.metadata);
+      key_ptrs.push_back(&key);
+
+      if (key_ptrs.size() == kBatchSize || i + 1 == to) {
+        storage.MultiWrite(key_ptrs, records);
+        counter += key_ptrs.size();
+        key_ptrs.clear();
+        records.clear();
+      }
+    }
+    num_done++;
+  };
+  std::vector<std::thread> threads;
+  uint64_t range = num_records / FLAGS_data_threads + 1;
+  for (uint32_t i = 0; i < FLAGS_data_threads; i++) {
+    threads.emplace_back(LoadFn, std::min(i * range, num_records), std::min((i + 1) * range, num_records));
+  }
+  while (num_done < FLAGS_data_threads) {
+    std::this_thread::sleep_for(std::chrono::seconds(5));
+    LOG(INFO) << "Loaded " << counter.load() << " records";
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
 void LoadData(slog::Storage& storage, const ConfigurationPtr& config, const string& data_dir) {
   if (data_dir.empty()) {
     LOG(INFO) << "No initial data directory specified. Starting with an empty storage.";
     return;
   }
 
-  auto data_file = data_dir + "/" + std::to_string(config->local_partition()) + ".dat";
+  // Prefer the snapshot format, which can be loaded in parallel
+  auto snapshot_file = data_dir + "/" + std::to_string(config->local_partition()) + ".snap";
+  if (access(snapshot_file.c_str(), F_OK) == 0) {
+    LoadSnapshot(storage, config, snapshot_file);
+    return;
+  }
 
-  auto fd = open(data_file.c_str(), O_RDONLY);
-  if (fd < 0) {
-    LOG(ERROR) << "Error while loading \"" << data_file << "\": " << strerror(errno)
-               << ". Starting with an empty storage.";
+  // The data of a partition is either in a single file or split into shards <partition>_<shard>.dat
+  auto partition_str = std::to_string(config->local_partition());
+  vector<string> data_files;
+  if (auto single_file = data_dir + "/" + partition_str + ".dat"; access(single_file.c_str(), F_OK) == 0) {
+    data_files.push_back(single_file);
+  } else {
+    for (int shard = 0;; shard++) {
+      auto shard_file = data_dir + "/" + partition_str + "_" + std::to_string(shard) + ".dat";
+      if (access(shard_file.c_str(), F_OK) != 0) {
+        break;
+      }
+      data_files.push_back(shard_file);
+    }
+  }
+  if (data_files.empty()) {
+    LOG(ERROR) << "No data file found for partition " << partition_str << " in \"" << data_dir
+               << "\". Starting with an empty storage.";
     return;
   }
 
-  slog::OfflineDataReader reader(fd);
-  LOG(INFO) << "Loading " << reader.GetNumDatums() << " datums...";
+  // One thread per file reads raw datums and hands them over in batches to the loader
+  // threads, which parse the datums and insert them into the storage
+  const size_t kBatchSize = 1000;
+  const size_t kMaxPendingBatches = 4 * FLAGS_data_threads;
+  std::mutex mut;
+  std::condition_variable not_full, not_empty;
+  std::queue<vector<string>> batches;
+  size_t num_readers_done = 0;
+
+  // Open all files upfront to size the storage for the total number of datums
+  vector<int> fds;
+  uint64_t num_datums = 0;
+  for (const auto& data_file : data_files) {
+    auto fd = open(data_file.c_str(), O_RDONLY);
+    if (fd < 0) {
+      LOG(FATAL) << "Error while loading \"" << data_file << "\": " << strerror(errno);
+    }
+    fds.push_back(fd);
+    num_datums += slog::OfflineDataReader(fd).GetNumDatums();
+    lseek(fd, 0, SEEK_SET);
+  }
+  storage.Reserve(num_datums);
+
+  auto ReadFn = [&](int fd) {
+    slog::OfflineDataReader reader(fd);
+    vector<string> batch;
+    for (;;) {
+      bool has_next = reader.HasNextDatum();
+      if (has_next) {
+        reader.GetNextRawDatum(batch.emplace_back());
+      }
+      if (batch.size() == kBatchSize || (!has_next && !batch.empty())) {
+        std::unique_lock<std::mutex> lock(mut);
+        not_full.wait(lock, [&] { return batches.size() < kMaxPendingBatches; });
+        batches.push(std::move(batch));
+        batch.clear();
+        not_empty.notify_one();
+      }
+      if (!has_next) {
+        break;
+      }
+    }
+    close(fd);
+    std::lock_guard<std::mutex> lock(mut);
+    num_readers_done++;
+    not_empty.notify_all();
+  };
 
   auto sharder = slog::Sharder::MakeSharder(config);
-
-  VLOG(1) << "First 10 datums are: ";
-  int c = 10;
-  while (reader.HasNextDatum()) {
-    auto datum = reader.GetNextDatum();
-    if (c > 0) {
-      VLOG(1) << datum.key() << " " << datum.record() << " " << datum.master();
-      c--;
+  std::atomic<uint64_t> counter = 0;
+  std::atomic<size_t> num_done = 0;
+  auto LoadFn = [&] {
+    slog::Datum datum;
+    vector<Key> keys;
+    vector<const Key*> key_ptrs;
+    vector<Record> records;
+    for (;;) {
+      vector<string> batch;
+      {
+        std::unique_lock<std::mutex> lock(mut);
+        not_empty.wait(lock, [&] { return !batches.empty() || num_readers_done == data_files.size(); });
+        if (batches.empty()) {
+          break;
+        }
+        batch = std::move(batches.front());
+        batches.pop();
+        not_full.notify_one();
+      }
+      keys.resize(batch.size());
+      key_ptrs.clear();
+      records.clear();
+      for (size_t i = 0; i < batch.size(); i++) {
+        datum.ParseFromString(batch[i]);
+        CHECK(sharder->is_local_key(datum.key()))
+            << "Key " << datum.key() << " does not belong to partition " << config->local_partition();
+        CHECK_LT(datum.master(), config->num_replicas()) << "Master number exceeds number of replicas";
+
+        keys[i] = std::move(*datum.mutable_key());
+        key_ptrs.push_back(&keys[i]);
+        records.emplace_back(datum.record(), datum.master());
+      }
+      // Write the whole batch so that each segment of the storage is latched once per batch
+      storage.MultiWrite(key_ptrs, records);
+      counter += batch.size();
     }
+    num_done++;
+  };
 
-    CHECK(sharder->is_local_key(datum.key()))
-        << "Key " << datum.key() << " does not belong to partition " << config->local_partition();
-
-    CHECK_LT(datum.master(), config->num_replicas()) << "Master number exceeds number of replicas";
-
-    // Write to storage
-    Record record(datum.record(), datum.master());
-    storage.Write(datum.key(), record);
+  LOG(INFO) << "Loading " << num_datums << " datums from " << data_files.size() << " file(s) using " << FLAGS_data_threads
+            << " threads...";
+  vector<std::thread> threads;
+  for (auto fd : fds) {
+    threads.emplace_back(ReadFn, fd);
+  }
+  for (uint32_t i = 0; i < FLAGS_data_threads; i++) {
+    threads.emplace_back(LoadFn);
+  }
+  while (num_done < FLAGS_data_threads) {
+    std::this_thread::sleep_for(std::chrono::seconds(5));
+    LOG(INFO) << "Loaded " << counter.load() << " datums";
+  }
+  for (auto& t : threads) {
+    t.join();
   }
-  close(fd);
+  LOG(INFO) << "Loaded " << num_datums << " datums";
 }
 
 void GenerateSimpleData(std::shared_ptr<slog::Storage> storage,
@@ -95,6 +255,8 @@ void GenerateSimpleData(std::shared_ptr<slog::Storage> storage,
   LOG(INFO) << "Generating ~" << num_records / num_partitions << " records using " << FLAGS_data_threads << " threads. "
             << "Record size = " << simple_partitioning.record_size_bytes() << " bytes";
 
+  storage->Reserve(num_records / num_partitions + 1);
+
   std::atomic<uint64_t> counter = 0;
   std::atomic<size_t> num_done = 0;
   auto GenerateFn = [&](uint64_t from_key, uint64_t to_key) {
@@ -154,6 +316,8 @@ int main(int argc, char* argv[]) {
 #endif /* REMASTER_PROTOCOL_SIMPLE */
 
   CHECK(!FLAGS_address.empty()) << "Address must not be empty";
+  // The loaders split the data among the threads and bound their queues by the number of threads
+  CHECK_GT(FLAGS_data_threads, 0U) << "Number of data threads must be positive";
   auto config = slog::Configuration::FromFile(FLAGS_config, FLAGS_address);
 
   INIT_RECORDING(config);
@@ -173,25 +337,76 @@ int main(int argc, char* argv[]) {
   auto broker = Broker::New(config);
 
   // Create and initialize storage layer
-  auto storage = make_shared<slog::MemOnlyStorage>();
+  std::shared_ptr<slog::Storage> storage;
+  std::shared_ptr<slog::LookupMasterIndex> lookup_master_index;
+  std::shared_ptr<slog::LogStorage> log_storage;
+  switch (config->storage_type()) {
+    case slog::internal::StorageType::FLAT_MEM_ONLY: {
+      auto flat_storage = make_shared<slog::FlatMemOnlyStorage>();
+      storage = flat_storage;
+      lookup_master_index = flat_storage;
+      break;
+    }
+    case slog::internal::StorageType::LOG: {
+      log_storage = make_shared<slog::LogStorage>(config->log_storage_dir(), config->log_storage_group_commit_window(),
+                                                  config->log_storage_compaction_bytes());
+      storage = log_storage;
+      lookup_master_index = log_storage;
+      break;
+    }
+    default: {
+      auto mem_only_storage = make_shared<slog::MemOnlyStorage>();
+      storage = mem_only_storage;
+      lookup_master_index = mem_only_storage;
+      break;
+    }
+  }
+  LOG(INFO) << "Storage type: " << ENUM_NAME(config->storage_type(), slog::internal::StorageType);
+
+  // A durable storage that has recorded a complete initial load does not need to be loaded again.
+  // Otherwise, the initial data is written without waiting for each write to be flushed. A load that
+  // was interrupted by a crash is simply redone on top of what was recovered, since no txn could have
+  // run before the load completed. The writes of the txns do not wait to be flushed either because the
+  // workers wait for them to be durable only before replying, after the locks have been released
+  bool skip_loading = log_storage != nullptr && log_storage->load_complete();
+  if (log_storage != nullptr) {
+    log_storage->SetSyncWrites(false);
+  }
+  if (skip_loading) {
+    LOG(INFO) << "Skipped loading initial data since the storage was recovered from disk";
+  } else if (log_storage != nullptr && log_storage->num_recovered_entries() > 0) {
+    LOG(WARNING) << "The previous initial load did not complete. Reloading initial data";
+  }
+
   std::shared_ptr<slog::MetadataInitializer> metadata_initializer;
   switch (config->proto_config().partitioning_case()) {
     case slog::internal::Configuration::kSimplePartitioning:
       metadata_initializer =
           make_shared<slog::SimpleMetadataInitializer>(config->num_replicas(), config->num_partitions());
-      GenerateSimpleData(storage, metadata_initializer, config);
+      if (!skip_loading) {
+        GenerateSimpleData(storage, metadata_initializer, config);
+      }
       break;
     case slog::internal::Configuration::kTpccPartitioning:
       metadata_initializer =
           make_shared<slog::tpcc::TPCCMetadataInitializer>(config->num_replicas(), config->num_partitions());
-      GenerateTPCCData(storage, metadata_initializer, config);
+      if (!skip_loading) {
+        GenerateTPCCData(storage, metadata_initializer, config);
+      }
       break;
     default:
       metadata_initializer = make_shared<slog::ConstantMetadataInitializer>(0);
-      LoadData(*storage, config, FLAGS_data_dir);
+      if (!skip_loading) {
+        LoadData(*storage, config, FLAGS_data_dir);
+      }
       break;
   }
 
+  if (log_storage != nullptr && !skip_loading) {
+    log_storage->Flush();
+    log_storage->MarkLoadComplete();
+  }
+
   auto config_name = FLAGS_config;
   if (auto pos = config_name.rfind('/'); pos != std::string::npos) {
     config_name = config_name.substr(pos + 1);
@@ -206,7 +421,7 @@ int main(int argc, char* argv[]) {
                        slog::ModuleId::MHORDERER);
   modules.emplace_back(MakeRunnerFor<slog::LocalPaxos>(broker),
                        slog::ModuleId::LOCALPAXOS);
-  modules.emplace_back(MakeRunnerFor<slog::Forwarder>(broker->context(), broker->config(), storage,
+  modules.emplace_back(MakeRunnerFor<slog::Forwarder>(broker->context(), broker->config(), lookup_master_index,
                                                       metadata_initializer, metrics_manager),
                        slog::ModuleId::FORWARDER);
   modules.emplace_back(MakeRunnerFor<slog::Sequencer>(broker->context(), broker->config(), metrics_manager),
@@ -0,0 +1,158 @@
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <random>
+#include <thread>
+
+#include "common/string_utils.h"
+#include "service/service_utils.h"
+#include "storage/flat_mem_only_storage.h"
+#include "storage/log_storage.h"
+#include "storage/mem_only_storage.h"
+
+DEFINE_uint64(records, 10000000, "Number of records");
+DEFINE_uint32(record_size, 100, "Size of a record in bytes");
+DEFINE_uint32(threads, 4, "Number of threads used for loading and running operations");
+DEFINE_uint64(ops, 10000000, "Number of operations per thread");
+DEFINE_uint32(read_pct, 95, "Percentage of read operations");
+DEFINE_uint32(keys_per_op, 1, "Number of keys read or written together in one operation, like in a multi-key txn");
+DEFINE_string(storage, "mem_only,flat_mem_only", "Comma-separated list of storages to benchmark");
+DEFINE_string(log_dir, "storage_benchmark_log", "Directory of the log storage. Removed before the benchmark");
+DEFINE_uint32(group_commit_us, 0, "Group commit window of the log storage in microseconds");
+DEFINE_uint64(compaction_bytes, 1ULL << 30, "Log size after which the log storage is compacted");
+DEFINE_uint32(max_pending_acks, 0,
+              "If positive, a write operation of the log storage returns before it is durable, like a worker releasing "
+              "the locks of a txn before replying, and each thread waits for durability only once it has this many "
+              "operations that are not durable yet. Otherwise, every write operation waits for durability");
+
+using namespace slog;
+using namespace std::chrono;
+
+using std::make_shared;
+using std::string;
+using std::vector;
+
+template <typename Fn>
+double RunInThreads(Fn&& fn) {
+  auto start_time = steady_clock::now();
+  vector<std::thread> threads;
+  for (uint32_t i = 0; i < FLAGS_threads; i++) {
+    threads.emplace_back(fn, i);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  return duration_cast<microseconds>(steady_clock::now() - start_time).count() / 1000000.0;
+}
+
+// on_loaded is called after loading and counted towards the load time
+void Benchmark(const string& name, const std::shared_ptr<Storage>& storage,
+               const std::function<void()>& on_loaded = nullptr) {
+  LOG(INFO) << "Benchmarking " << name;
+
+  // Load all records, each thread taking a strided share of the key space
+  string value(FLAGS_record_size, 'a');
+  auto load_time = RunInThreads([&](uint32_t thread_id) {
+    Record record(value);
+    for (uint64_t key = thread_id; key < FLAGS_records; key += FLAGS_threads) {
+      storage->Write(std::to_string(key), record);
+    }
+  });
+  if (on_loaded) {
+    auto start_time = steady_clock::now();
+    on_loaded();
+    load_time += duration_cast<microseconds>(steady_clock::now() - start_time).count() / 1000000.0;
+  }
+  LOG(INFO) << name << " - Loaded " << FLAGS_records << " records in " << load_time << " s ("
+            << std::fixed << std::setprecision(3) << FLAGS_records / load_time / 1000000 << " M records/s)";
+
+  // Run a mix of reads and writes on uniformly random keys
+  std::atomic<uint64_t> num_found = 0;
+  std::atomic<uint64_t> num_writes = 0;
+  std::atomic<uint64_t> write_us = 0;
+  auto run_time = RunInThreads([&](uint32_t thread_id) {
+    std::mt19937_64 rg(thread_id);
+    std::uniform_int_distribution<uint64_t> key_dist(0, FLAGS_records - 1);
+    std::uniform_int_distribution<uint32_t> pct_dist(0, 99);
+    vector<Key> keys(FLAGS_keys_per_op);
+    vector<const Key*> key_ptrs;
+    for (const auto& key : keys) {
+      key_ptrs.push_back(&key);
+    }
+    vector<Record> records;
+    uint64_t found = 0;
+    uint64_t writes = 0;
+    microseconds write_time(0);
+    // Log positions of the write operations that are not known to be durable yet
+    std::deque<uint64_t> pending_acks;
+    for (uint64_t i = 0; i < FLAGS_ops; i++) {
+      for (auto& key : keys) {
+        key = std::to_string(key_dist(rg));
+      }
+      if (pct_dist(rg) < FLAGS_read_pct) {
+        storage->MultiRead(key_ptrs, [&found](size_t, const RecordView& view) {
+          found += view.valid();
+          return true;
+        });
+      } else {
+        records.assign(keys.size(), Record(value));
+        // The time spent in a write is the time that a txn would hold its locks for
+        auto start_time = steady_clock::now();
+        storage->MultiWrite(key_ptrs, records);
+        write_time += duration_cast<microseconds>(steady_clock::now() - start_time);
+        writes++;
+        if (FLAGS_max_pending_acks > 0) {
+          pending_acks.push_back(storage->log_position());
+          if (pending_acks.size() > FLAGS_max_pending_acks) {
+            storage->WaitUntilDurable(pending_acks.front());
+            pending_acks.pop_front();
+          }
+        }
+      }
+    }
+    if (!pending_acks.empty()) {
+      storage->WaitUntilDurable(pending_acks.back());
+    }
+    num_found += found;
+    num_writes += writes;
+    write_us += write_time.count();
+  });
+  auto total_ops = FLAGS_ops * FLAGS_threads;
+  LOG(INFO) << name << " - Ran " << total_ops << " operations in " << run_time << " s (" << std::fixed
+            << std::setprecision(3) << total_ops / run_time / 1000000 << " M ops/s). Found " << num_found.load()
+            << " keys. Average write time: " << (num_writes > 0 ? static_cast<double>(write_us) / num_writes : 0) << " us";
+}
+
+int main(int argc, char* argv[]) {
+  InitializeService(&argc, &argv);
+
+  LOG(INFO) << "Records: " << FLAGS_records << ". Record size: " << FLAGS_record_size
+            << " bytes. Threads: " << FLAGS_threads << ". Read percentage: " << FLAGS_read_pct
+            << ". Keys per operation: " << FLAGS_keys_per_op;
+
+  for (const auto& name : Split(FLAGS_storage, ",")) {
+    if (name == "mem_only") {
+      Benchmark(name, make_shared<MemOnlyStorage>());
+    } else if (name == "flat_mem_only") {
+      Benchmark(name, make_shared<FlatMemOnlyStorage>());
+    } else if (name == "log") {
+      if (system(("rm -rf " + FLAGS_log_dir).c_str()) != 0) {
+        LOG(FATAL) << "Cannot remove " << FLAGS_log_dir;
+      }
+      auto storage = make_shared<LogStorage>(FLAGS_log_dir, microseconds(FLAGS_group_commit_us), FLAGS_compaction_bytes);
+      // Only the operations after loading wait for durability, either in the writes or after them
+      storage->SetSyncWrites(false);
+      Benchmark(name, storage, [&storage] {
+        storage->Flush();
+        storage->SetSyncWrites(FLAGS_max_pending_acks == 0);
+      });
+      LOG(INFO) << name << " - Flushed " << storage->num_flushes() << " times";
+    } else {
+      LOG(FATAL) << "Unknown storage: " << name;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,198 @@
+#include <time.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <unordered_map>
+
+#include "common/configuration.h"
+#include "data_structure/txn_table.h"
+#include "module/scheduler_components/txn_holder.h"
+#include "module/scheduler_components/worker.h"
+#include "service/service_utils.h"
+
+DEFINE_uint32(txns, 200000, "Number of transactions");
+DEFINE_uint32(in_flight, 1000, "Number of transactions in the scheduler at any time");
+DEFINE_uint32(replicas, 2, "Number of replicas");
+DEFINE_uint32(mh_pct, 10, "Percentage of multi-home transactions");
+
+using namespace slog;
+
+using std::vector;
+
+namespace {
+
+// Counts the heap allocations of the whole process
+std::atomic<uint64_t> num_allocations = 0;
+
+}  // namespace
+
+void* operator new(size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (auto p = std::malloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+/**
+ * Access to the per-txn maps of the scheduler and the workers, before and after pooling
+ */
+template <typename T>
+using UnorderedMap = std::unordered_map<TxnId, T>;
+
+template <typename T, typename... Args>
+std::pair<T*, bool> TryEmplace(UnorderedMap<T>& map, TxnId txn_id, Args&&... args) {
+  auto ins = map.try_emplace(txn_id, std::forward<Args>(args)...);
+  return {&ins.first->second, ins.second};
+}
+
+template <typename T>
+T* Find(UnorderedMap<T>& map, TxnId txn_id) {
+  return &map.at(txn_id);
+}
+
+template <typename T>
+void Erase(UnorderedMap<T>& map, TxnId txn_id) {
+  map.erase(txn_id);
+}
+
+template <typename T, typename... Args>
+std::pair<T*, bool> TryEmplace(TxnTable<T>& table, TxnId txn_id, Args&&... args) {
+  return table.TryEmplace(txn_id, std::forward<Args>(args)...);
+}
+
+template <typename T>
+T* Find(TxnTable<T>& table, TxnId txn_id) {
+  return table.Find(txn_id);
+}
+
+template <typename T>
+void Erase(TxnTable<T>& table, TxnId txn_id) {
+  table.Erase(txn_id);
+}
+
+// The main txn and the lock-only txns of a txn
+using TxnParts = vector<Transaction*>;
+
+// Generates the same txns num_sets times. The copies of a txn are allocated next to each other so
+// that each set is laid out in the same way in memory
+vector<vector<TxnParts>> GenerateTxns(int num_sets) {
+  std::mt19937 rg(0);
+  std::uniform_int_distribution<uint32_t> pct_dist(0, 99);
+  vector<vector<TxnParts>> sets(num_sets, vector<TxnParts>(FLAGS_txns));
+  for (size_t i = 0; i < FLAGS_txns; i++) {
+    auto num_homes = pct_dist(rg) < FLAGS_mh_pct ? FLAGS_replicas : 1;
+    for (auto& txns : sets) {
+      for (uint32_t home = 0; home < num_homes; home++) {
+        auto txn = new Transaction();
+        auto internal = txn->mutable_internal();
+        internal->set_id(i * 1000 + 1);
+        internal->set_home(home);
+        for (uint32_t r = 0; r < num_homes; r++) {
+          internal->add_involved_replicas(r);
+        }
+        txns[i].push_back(txn);
+      }
+    }
+  }
+  return sets;
+}
+
+double CpuTimeNs() {
+  timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+struct Result {
+  double allocations_per_txn;
+  double cpu_ns_per_txn;
+};
+
+/**
+ * Replays the life of the txns in the scheduler and a worker: a txn gets a holder when it enters the
+ * scheduler, is joined by its lock-only txns, gets a state in the worker when it is dispatched and
+ * leaves both maps when it finishes. The txns finish in the order they enter and FLAGS_in_flight
+ * txns are active at any time. Like in the worker, the main txn is taken out of its holder when the
+ * txn finishes and the lock-only txns are deleted. The main txns are deleted by the caller.
+ */
+template <template <typename> typename Map>
+Result Run(const ConfigurationPtr& config, const vector<TxnParts>& txns) {
+  Map<TxnHolder> active_txns;
+  Map<TransactionState> txn_states;
+  std::deque<TxnId> in_flight;
+  auto finish = [&](TxnId txn_id) {
+    Find(active_txns, txn_id)->FinalizeAndRelease();
+    Erase(txn_states, txn_id);
+    Erase(active_txns, txn_id);
+  };
+
+  auto start_allocations = num_allocations.load();
+  auto start_time = CpuTimeNs();
+  for (const auto& parts : txns) {
+    auto txn_id = parts[0]->internal().id();
+    auto holder = TryEmplace(active_txns, txn_id, config, parts[0]).first;
+    for (size_t i = 1; i < parts.size(); i++) {
+      holder->AddLockOnlyTxn(parts[i]);
+    }
+    TryEmplace(txn_states, txn_id, holder);
+    in_flight.push_back(txn_id);
+
+    if (in_flight.size() > FLAGS_in_flight) {
+      finish(in_flight.front());
+      in_flight.pop_front();
+    }
+  }
+  for (auto txn_id : in_flight) {
+    finish(txn_id);
+  }
+  auto allocations = num_allocations.load() - start_allocations;
+  return {static_cast<double>(allocations) / txns.size(), (CpuTimeNs() - start_time) / txns.size()};
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  InitializeService(&argc, &argv);
+
+  internal::Configuration config_proto;
+  for (uint32_t r = 0; r < FLAGS_replicas; r++) {
+    config_proto.add_replicas()->add_addresses("/tmp/txn_table_benchmark" + std::to_string(r));
+  }
+  config_proto.add_broker_ports(0);
+  config_proto.set_server_port(5000);
+  config_proto.set_sequencer_port(5001);
+  config_proto.set_forwarder_port(5002);
+  config_proto.set_num_partitions(1);
+  auto config = std::make_shared<Configuration>(config_proto, "/tmp/txn_table_benchmark0");
+
+  // Each run deletes the lock-only txns so it needs its own set of txns
+  auto sets = GenerateTxns(2);
+  auto unordered_map = Run<UnorderedMap>(config, sets[0]);
+  auto txn_table = Run<TxnTable>(config, sets[1]);
+  for (const auto& txns : sets) {
+    for (const auto& parts : txns) {
+      delete parts[0];
+    }
+  }
+
+  std::cout << std::setw(16) << "map" << std::setw(20) << "allocations/txn" << std::setw(16) << "cpu (ns/txn)"
+            << std::endl;
+  for (auto [name, res] : {std::make_pair("unordered_map", unordered_map), std::make_pair("txn_table", txn_table)}) {
+    std::cout << std::setw(16) << name << std::setw(20) << std::fixed << std::setprecision(2)
+              << res.allocations_per_txn << std::setw(16) << std::setprecision(0) << res.cpu_ns_per_txn << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "data_structure/flat_hash_map.h"
+#include "storage/lookup_master_index.h"
+#include "storage/master_index.h"
+#include "storage/storage.h"
+
+namespace slog {
+
+/**
+ * Same as MemOnlyStorage but backed by an open-addressing table instead of a
+ * chained hash map
+ */
+class FlatMemOnlyStorage : public Storage, public LookupMasterIndex {
+ public:
+  bool Read(const Key& key, Record& result) const final { return table_.Get(result, key); }
+
+  bool ReadMetadata(const Key& key, Metadata& metadata) const final {
+    return master_index_.GetMasterMetadata(key, metadata);
+  }
+
+  bool Write(const Key& key, const Record& record) final {
+    master_index_.Set(key, record.metadata());
+    return table_.InsertOrUpdate(key, record);
+  }
+
+  bool Write(const Key& key, Record&& record) final {
+    master_index_.Set(key, record.metadata());
+    return table_.InsertOrUpdate(key, std::move(record));
+  }
+
+  bool Delete(const Key& key) final {
+    master_index_.Erase(key);
+    return table_.Erase(key);
+  }
+
+  void Reserve(size_t num_records) final {
+    table_.Reserve(num_records);
+    master_index_.Reserve(num_records);
+  }
+
+  bool GetMasterMetadata(const Key& key, Metadata& metadata) const final {
+    return master_index_.GetMasterMetadata(key, metadata);
+  }
+
+  void GetMasterMetadata(const std::vector<const Key*>& keys,
+                         std::vector<std::optional<Metadata>>& results) const final {
+    master_index_.GetMasterMetadata(keys, results);
+  }
+
+ private:
+  ConcurrentFlatHashMap<Record> table_;
+  // Master metadata is duplicated here so that master lookups do not go through the records
+  MasterIndex master_index_;
+};
+
+}  // namespace slog
@@ -0,0 +1,552 @@
+#include "storage/log_storage.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace slog {
+
+namespace {
+
+// checksum (4) | type (1) | key size (4) | value size (4) | master (4) | counter (4)
+constexpr size_t kHeaderSize = 21;
+constexpr size_t kChecksumSize = 4;
+// Size of the buffer accumulated before being written out while writing a checkpoint
+constexpr size_t kCheckpointBufferSize = 1 << 20;
+
+const char* kLogPrefix = "wal-";
+const char* kLogSuffix = ".log";
+const char* kCheckpointPrefix = "checkpoint-";
+const char* kCheckpointSuffix = ".dat";
+const char* kTmpSuffix = ".tmp";
+
+uint32_t Checksum(const char* data, size_t size) {
+  // FNV-1a
+  uint32_t hash = 2166136261U;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= 16777619U;
+  }
+  return hash;
+}
+
+void PutUInt32(std::string& buf, uint32_t value) { buf.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+
+// Fills in the checksum of the entry that starts at the given offset and runs to the end of buf
+void SealEntry(std::string& buf, size_t start) {
+  auto checksum = Checksum(buf.data() + start + kChecksumSize, buf.size() - start - kChecksumSize);
+  memcpy(buf.data() + start, &checksum, sizeof(checksum));
+}
+
+uint32_t GetUInt32(const char* data) {
+  uint32_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+void WriteAll(int fd, const std::string& buf, const std::string& path) {
+  size_t written = 0;
+  while (written < buf.size()) {
+    auto res = write(fd, buf.data() + written, buf.size() - written);
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG(FATAL) << "Error while writing to \"" << path << "\": " << strerror(errno);
+    }
+    written += res;
+  }
+}
+
+void SyncFile(int fd, const std::string& path) {
+  if (fdatasync(fd) < 0) {
+    LOG(FATAL) << "Error while syncing \"" << path << "\": " << strerror(errno);
+  }
+}
+
+// Makes creations, renames and deletions of files in a directory durable
+void SyncDir(const std::string& dir) {
+  auto fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0) {
+    LOG(FATAL) << "Error while opening \"" << dir << "\": " << strerror(errno);
+  }
+  if (fsync(fd) < 0) {
+    LOG(FATAL) << "Error while syncing \"" << dir << "\": " << strerror(errno);
+  }
+  close(fd);
+}
+
+// Parses file names of the form <prefix><seq><suffix>
+bool ParseSeq(const std::string& name, const char* prefix, const char* suffix, uint64_t& seq) {
+  auto prefix_len = strlen(prefix);
+  auto suffix_len = strlen(suffix);
+  if (name.size() <= prefix_len + suffix_len || name.compare(0, prefix_len, prefix) != 0 ||
+      name.compare(name.size() - suffix_len, suffix_len, suffix) != 0) {
+    return false;
+  }
+  auto digits = name.substr(prefix_len, name.size() - prefix_len - suffix_len);
+  if (!std::all_of(digits.begin(), digits.end(), ::isdigit)) {
+    return false;
+  }
+  seq = std::stoull(digits);
+  return true;
+}
+
+struct DirContent {
+  std::vector<uint64_t> logs;
+  std::vector<uint64_t> checkpoints;
+  std::vector<std::string> tmp_files;
+};
+
+DirContent ListDir(const std::string& dir) {
+  DirContent content;
+  auto d = opendir(dir.c_str());
+  if (d == nullptr) {
+    LOG(FATAL) << "Error while opening \"" << dir << "\": " << strerror(errno);
+  }
+  while (auto entry = readdir(d)) {
+    std::string name(entry->d_name);
+    uint64_t seq;
+    if (ParseSeq(name, kLogPrefix, kLogSuffix, seq)) {
+      content.logs.push_back(seq);
+    } else if (ParseSeq(name, kCheckpointPrefix, kCheckpointSuffix, seq)) {
+      content.checkpoints.push_back(seq);
+    } else if (name.size() > strlen(kTmpSuffix) &&
+               name.compare(name.size() - strlen(kTmpSuffix), strlen(kTmpSuffix), kTmpSuffix) == 0) {
+      content.tmp_files.push_back(dir + "/" + name);
+    }
+  }
+  closedir(d);
+  std::sort(content.logs.begin(), content.logs.end());
+  std::sort(content.checkpoints.begin(), content.checkpoints.end());
+  return content;
+}
+
+}  // namespace
+
+LogStorage::LogStorage(const std::string& dir, std::chrono::microseconds group_commit_window,
+                       uint64_t compaction_bytes)
+    : dir_(dir), group_commit_window_(group_commit_window), compaction_bytes_(compaction_bytes) {
+  Recover();
+  flush_thread_ = std::thread(&LogStorage::FlushLoop, this);
+  compact_thread_ = std::thread(&LogStorage::CompactLoop, this);
+}
+
+LogStorage::~LogStorage() {
+  {
+    std::lock_guard<std::mutex> lock(mut_);
+    stopping_ = true;
+  }
+  flush_cv_.notify_all();
+  compact_cv_.notify_all();
+  flush_thread_.join();
+  compact_thread_.join();
+  close(log_fd_);
+}
+
+bool LogStorage::Write(const Key& key, const Record& record) {
+  static thread_local std::string entry;
+  entry.clear();
+  Encode(entry, EntryType::WRITE, key, &record);
+  bool exists;
+  uint64_t lsn;
+  {
+    // Apply to memory before appending to the log so that a checkpoint started after
+    // the log is closed sees every write in that log
+    std::shared_lock<std::shared_mutex> latch(apply_latch_);
+    exists = memory_.Write(key, record);
+    lsn = Append(entry);
+  }
+  if (sync_writes_) {
+    WaitUntilDurable(lsn);
+  }
+  return exists;
+}
+
+bool LogStorage::Write(const Key& key, Record&& record) {
+  static thread_local std::string entry;
+  entry.clear();
+  Encode(entry, EntryType::WRITE, key, &record);
+  bool exists;
+  uint64_t lsn;
+  {
+    std::shared_lock<std::shared_mutex> latch(apply_latch_);
+    exists = memory_.Write(key, std::move(record));
+    lsn = Append(entry);
+  }
+  if (sync_writes_) {
+    WaitUntilDurable(lsn);
+  }
+  return exists;
+}
+
+bool LogStorage::Delete(const Key& key) {
+  static thread_local std::string entry;
+  entry.clear();
+  Encode(entry, EntryType::DELETE, key, nullptr);
+  bool exists;
+  uint64_t lsn;
+  {
+    std::shared_lock<std::shared_mutex> latch(apply_latch_);
+    exists = memory_.Delete(key);
+    lsn = Append(entry);
+  }
+  if (sync_writes_) {
+    WaitUntilDurable(lsn);
+  }
+  return exists;
+}
+
+void LogStorage::MultiWrite(const std::vector<const Key*>& keys, std::vector<Record>& records) {
+  static const std::vector<const Key*> kNoDeletedKeys;
+  WriteBatch(keys, records, kNoDeletedKeys);
+}
+
+void LogStorage::WriteBatch(const std::vector<const Key*>& keys, std::vector<Record>& records,
+                            const std::vector<const Key*>& deleted_keys) {
+  static thread_local std::string entries;
+  static thread_local std::string batch;
+  entries.clear();
+  for (size_t i = 0; i < keys.size(); i++) {
+    Encode(entries, EntryType::WRITE, *keys[i], &records[i]);
+  }
+  for (auto key : deleted_keys) {
+    Encode(entries, EntryType::DELETE, *key, nullptr);
+  }
+  // A single entry is already recovered either whole or not at all
+  const std::string* to_append = &entries;
+  if (keys.size() + deleted_keys.size() > 1) {
+    batch.clear();
+    EncodeBatch(batch, entries);
+    to_append = &batch;
+  }
+  uint64_t lsn;
+  {
+    std::shared_lock<std::shared_mutex> latch(apply_latch_);
+    memory_.MultiWrite(keys, records);
+    for (auto key : deleted_keys) {
+      memory_.Delete(*key);
+    }
+    lsn = Append(*to_append);
+  }
+  if (sync_writes_) {
+    WaitUntilDurable(lsn);
+  }
+}
+
+void LogStorage::Flush() { WaitUntilDurable(appended_lsn_); }
+
+uint64_t LogStorage::log_position() const { return appended_lsn_.load(); }
+
+uint64_t LogStorage::durable_position() const { return durable_lsn_.load(); }
+
+void LogStorage::WaitUntilDurable(uint64_t lsn) {
+  std::unique_lock<std::mutex> lock(mut_);
+  durable_cv_.wait(lock, [this, lsn] { return durable_lsn_ >= lsn; });
+}
+
+int LogStorage::AddDurableListener(std::function<void()>&& listener) {
+  std::lock_guard<std::mutex> lock(mut_);
+  auto id = next_listener_id_++;
+  durable_listeners_.emplace(id, std::move(listener));
+  return id;
+}
+
+void LogStorage::RemoveDurableListener(int id) {
+  std::lock_guard<std::mutex> lock(mut_);
+  durable_listeners_.erase(id);
+}
+
+void LogStorage::MarkLoadComplete() {
+  std::string entry;
+  Encode(entry, EntryType::LOAD_COMPLETE, "", nullptr);
+  // Set before appending so that a checkpoint covering the log of the marker also carries it
+  load_complete_ = true;
+  WaitUntilDurable(Append(entry));
+}
+
+uint64_t LogStorage::num_flushes() const {
+  std::lock_guard<std::mutex> lock(mut_);
+  return num_flushes_;
+}
+
+void LogStorage::Encode(std::string& buf, EntryType type, const Key& key, const Record* record) {
+  auto start = buf.size();
+  PutUInt32(buf, 0);
+  buf.push_back(static_cast<char>(type));
+  PutUInt32(buf, key.size());
+  PutUInt32(buf, record == nullptr ? 0 : record->size());
+  PutUInt32(buf, record == nullptr ? 0 : record->metadata().master);
+  PutUInt32(buf, record == nullptr ? 0 : record->metadata().counter);
+  buf.append(key);
+  if (record != nullptr && record->size() > 0) {
+    buf.append(record->data(), record->size());
+  }
+  SealEntry(buf, start);
+}
+
+void LogStorage::EncodeBatch(std::string& buf, const std::string& entries) {
+  auto start = buf.size();
+  PutUInt32(buf, 0);
+  buf.push_back(static_cast<char>(EntryType::BATCH));
+  PutUInt32(buf, 0);
+  PutUInt32(buf, entries.size());
+  PutUInt32(buf, 0);
+  PutUInt32(buf, 0);
+  buf.append(entries);
+  SealEntry(buf, start);
+}
+
+size_t LogStorage::Replay(const std::string& path) {
+  auto fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(FATAL) << "Error while opening \"" << path << "\": " << strerror(errno);
+  }
+  struct stat st;
+  fstat(fd, &st);
+  std::string data(st.st_size, '\0');
+  size_t num_read = 0;
+  while (num_read < data.size()) {
+    auto res = read(fd, data.data() + num_read, data.size() - num_read);
+    if (res < 0 && errno == EINTR) {
+      continue;
+    }
+    if (res <= 0) {
+      LOG(FATAL) << "Error while reading \"" << path << "\": " << strerror(errno);
+    }
+    num_read += res;
+  }
+  close(fd);
+
+  size_t num_entries = 0;
+  auto pos = ReplayEntries(data.data(), data.size(), num_entries);
+
+  // A crash in the middle of a flush may leave a partially written entry at the end of a log.
+  // Since a log is never appended to after a restart, it is enough to ignore the rest of the file
+  if (pos < data.size()) {
+    LOG(WARNING) << "Ignored " << data.size() - pos << " trailing bytes of \"" << path << "\"";
+  }
+
+  return num_entries;
+}
+
+size_t LogStorage::ReplayEntries(const char* data, size_t size, size_t& num_entries) {
+  size_t pos = 0;
+  while (pos + kHeaderSize <= size) {
+    auto header = data + pos;
+    auto key_size = GetUInt32(header + 5);
+    auto value_size = GetUInt32(header + 9);
+    auto entry_size = kHeaderSize + key_size + value_size;
+    if (pos + entry_size > size || Checksum(header + kChecksumSize, entry_size - kChecksumSize) != GetUInt32(header)) {
+      break;
+    }
+    Key key(header + kHeaderSize, key_size);
+    auto type = static_cast<EntryType>(header[4]);
+    if (type == EntryType::WRITE) {
+      Record record;
+      record.SetValue(header + kHeaderSize + key_size, value_size);
+      record.SetMetadata(Metadata(GetUInt32(header + 13), GetUInt32(header + 17)));
+      memory_.Write(key, std::move(record));
+      num_entries++;
+    } else if (type == EntryType::DELETE) {
+      memory_.Delete(key);
+      num_entries++;
+    } else if (type == EntryType::BATCH) {
+      // The checksum of the batch covers all of its entries
+      ReplayEntries(header + kHeaderSize, value_size, num_entries);
+    } else {
+      load_complete_ = true;
+    }
+    pos += entry_size;
+  }
+  return pos;
+}
+
+void LogStorage::Recover() {
+  if (mkdir(dir_.c_str(), 0755) < 0 && errno != EEXIST) {
+    LOG(FATAL) << "Error while creating \"" << dir_ << "\": " << strerror(errno);
+  }
+
+  auto content = ListDir(dir_);
+  for (const auto& file : content.tmp_files) {
+    unlink(file.c_str());
+  }
+
+  // A checkpoint covers all logs up to the same sequence number
+  uint64_t max_seq = 0;
+  if (!content.checkpoints.empty()) {
+    checkpoint_seq_ = content.checkpoints.back();
+    max_seq = checkpoint_seq_;
+    num_recovered_entries_ += Replay(CheckpointPath(checkpoint_seq_));
+  }
+  for (auto seq : content.logs) {
+    if (seq > checkpoint_seq_) {
+      num_recovered_entries_ += Replay(LogPath(seq));
+    }
+    max_seq = std::max(max_seq, seq);
+  }
+
+  // Clean up files left behind by a compaction that was interrupted
+  for (auto seq : content.logs) {
+    if (seq <= checkpoint_seq_) {
+      unlink(LogPath(seq).c_str());
+    }
+  }
+  for (auto seq : content.checkpoints) {
+    if (seq < checkpoint_seq_) {
+      unlink(CheckpointPath(seq).c_str());
+    }
+  }
+
+  LOG(INFO) << "Recovered " << num_recovered_entries_ << " log entries from \"" << dir_ << "\""
+            << (num_recovered_entries_ > 0 && !load_complete_ ? " without a complete initial load" : "");
+
+  // Never append to an existing log since it may end with a partially written entry
+  OpenLog(max_seq + 1);
+}
+
+uint64_t LogStorage::Append(const std::string& entries) {
+  std::lock_guard<std::mutex> lock(mut_);
+  buffer_ += entries;
+  appended_lsn_ += entries.size();
+  flush_cv_.notify_one();
+  return appended_lsn_;
+}
+
+void LogStorage::OpenLog(uint64_t seq) {
+  auto path = LogPath(seq);
+  log_fd_ = open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_APPEND, 0644);
+  if (log_fd_ < 0) {
+    LOG(FATAL) << "Error while opening \"" << path << "\": " << strerror(errno);
+  }
+  SyncDir(dir_);
+  log_seq_ = seq;
+  log_size_ = 0;
+}
+
+void LogStorage::FlushLoop() {
+  std::unique_lock<std::mutex> lock(mut_);
+  for (;;) {
+    flush_cv_.wait(lock, [this] { return stopping_ || !buffer_.empty(); });
+    if (buffer_.empty()) {
+      // Stopping with nothing left to flush
+      break;
+    }
+    if (group_commit_window_.count() > 0 && !stopping_) {
+      // Give writes from other threads a chance to join this group
+      flush_cv_.wait_for(lock, group_commit_window_, [this] { return stopping_; });
+    }
+
+    flushing_buffer_.swap(buffer_);
+    uint64_t lsn = appended_lsn_;
+    lock.unlock();
+
+    auto path = LogPath(log_seq_);
+    WriteAll(log_fd_, flushing_buffer_, path);
+    SyncFile(log_fd_, path);
+    log_size_ += flushing_buffer_.size();
+    flushing_buffer_.clear();
+
+    bool rotated = false;
+    if (log_size_ >= compaction_bytes_) {
+      close(log_fd_);
+      OpenLog(log_seq_ + 1);
+      rotated = true;
+    }
+
+    lock.lock();
+    durable_lsn_ = lsn;
+    num_flushes_++;
+    durable_cv_.notify_all();
+    for (const auto& [id, listener] : durable_listeners_) {
+      listener();
+    }
+    if (rotated) {
+      compact_seq_ = log_seq_ - 1;
+      compact_cv_.notify_one();
+    }
+  }
+}
+
+void LogStorage::CompactLoop() {
+  std::unique_lock<std::mutex> lock(mut_);
+  for (;;) {
+    compact_cv_.wait(lock, [this] { return stopping_ || compact_seq_ > checkpoint_seq_; });
+    if (stopping_) {
+      // The closed logs are still complete so an unfinished compaction can simply be dropped
+      break;
+    }
+    auto seq = compact_seq_;
+    lock.unlock();
+    WriteCheckpoint(seq);
+    lock.lock();
+  }
+}
+
+void LogStorage::WriteCheckpoint(uint64_t seq) {
+  auto path = CheckpointPath(seq);
+  auto tmp_path = path + kTmpSuffix;
+  auto fd = open(tmp_path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  if (fd < 0) {
+    LOG(FATAL) << "Error while opening \"" << tmp_path << "\": " << strerror(errno);
+  }
+
+  // Every write in the logs up to seq has been applied to memory before the logs were
+  // closed, so the checkpoint covers them. It may also contain newer writes, which are
+  // replayed again from the newer logs during recovery
+  std::string buf;
+  if (load_complete_) {
+    Encode(buf, EntryType::LOAD_COMPLETE, "", nullptr);
+  }
+  size_t num_records = 0;
+  memory_.ForEach([&](const Key& key, const Record& record) {
+    Encode(buf, EntryType::WRITE, key, &record);
+    num_records++;
+    if (buf.size() >= kCheckpointBufferSize) {
+      WriteAll(fd, buf, tmp_path);
+      buf.clear();
+    }
+  });
+  WriteAll(fd, buf, tmp_path);
+  SyncFile(fd, tmp_path);
+  close(fd);
+
+  // The newer writes in the checkpoint may not be durable yet and may be only part of a txn. Once
+  // the writes being applied have been appended, waiting for the whole log to be durable makes
+  // the checkpoint plus the newer logs exactly the durable state
+  { std::unique_lock<std::shared_mutex> latch(apply_latch_); }
+  Flush();
+
+  if (rename(tmp_path.c_str(), path.c_str()) < 0) {
+    LOG(FATAL) << "Error while renaming \"" << tmp_path << "\": " << strerror(errno);
+  }
+  SyncDir(dir_);
+
+  auto content = ListDir(dir_);
+  for (auto log_seq : content.logs) {
+    if (log_seq <= seq) {
+      unlink(LogPath(log_seq).c_str());
+    }
+  }
+  for (auto checkpoint_seq : content.checkpoints) {
+    if (checkpoint_seq < seq) {
+      unlink(CheckpointPath(checkpoint_seq).c_str());
+    }
+  }
+  checkpoint_seq_ = seq;
+
+  VLOG(1) << "Compacted logs up to " << seq << " into a checkpoint of " << num_records << " records";
+}
+
+std::string LogStorage::LogPath(uint64_t seq) const { return dir_ + "/" + kLogPrefix + std::to_string(seq) + kLogSuffix; }
+
+std::string LogStorage::CheckpointPath(uint64_t seq) const {
+  return dir_ + "/" + kCheckpointPrefix + std::to_string(seq) + kCheckpointSuffix;
+}
+
+}  // namespace slog
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "storage/lookup_master_index.h"
+#include "storage/mem_only_storage.h"
+#include "storage/storage.h"
+
+namespace slog {
+
+/**
+ * A durable storage that keeps all records in memory like MemOnlyStorage and persists
+ * every write to an append-only write-ahead log in a directory.
+ *
+ * Writes from all threads are appended to a shared buffer that a background thread writes
+ * to the log, followed by a single fsync, after gathering writes for a group commit window.
+ * With sync writes, a write only returns after the fsync covering it completes, so the cost
+ * of an fsync is shared among all writes in the same group. Otherwise, a write returns right
+ * after being applied to memory and the caller waits for log_position() to become durable
+ * whenever it needs to, e.g. only before acknowledging a txn. WriteBatch is logged as a single
+ * entry so that the writes of a txn are recovered either all or none.
+ *
+ * Once a log exceeds the compaction threshold, the background thread closes it and starts
+ * a new one. Another thread then dumps all records in memory into a checkpoint, after which
+ * the closed logs and the previous checkpoint are deleted. The dump runs concurrently with
+ * writes, so it may contain newer writes, some of them only part of a txn. This is fine as
+ * long as these writes are durable in the newer logs, which are replayed on top of the
+ * checkpoint at startup, so the checkpoint is only published once they are.
+ *
+ * Writes to the same key must not be concurrent, which is guaranteed by the lock manager,
+ * so that the order of the writes in memory is the same as in the log.
+ */
+class LogStorage : public Storage, public LookupMasterIndex {
+ public:
+  /**
+   * Recovers the records persisted in the given directory, creating it if needed
+   */
+  LogStorage(const std::string& dir, std::chrono::microseconds group_commit_window, uint64_t compaction_bytes);
+  ~LogStorage();
+
+  bool Read(const Key& key, Record& result) const final { return memory_.Read(key, result); }
+  bool ReadView(const Key& key, RecordView& view) const final { return memory_.ReadView(key, view); }
+  bool ReadMetadata(const Key& key, Metadata& metadata) const final { return memory_.ReadMetadata(key, metadata); }
+  void MultiRead(const std::vector<const Key*>& keys,
+                 const std::function<bool(size_t, const RecordView&)>& fn) const final {
+    memory_.MultiRead(keys, fn);
+  }
+
+  bool Write(const Key& key, const Record& record) final;
+  bool Write(const Key& key, Record&& record) final;
+  bool Delete(const Key& key) final;
+  void MultiWrite(const std::vector<const Key*>& keys, std::vector<Record>& records) final;
+  void WriteBatch(const std::vector<const Key*>& keys, std::vector<Record>& records,
+                  const std::vector<const Key*>& deleted_keys) final;
+  void Reserve(size_t num_records) final { memory_.Reserve(num_records); }
+
+  bool GetMasterMetadata(const Key& key, Metadata& metadata) const final {
+    return memory_.GetMasterMetadata(key, metadata);
+  }
+  void GetMasterMetadata(const std::vector<const Key*>& keys,
+                         std::vector<std::optional<Metadata>>& results) const final {
+    memory_.GetMasterMetadata(keys, results);
+  }
+
+  uint64_t log_position() const final;
+  uint64_t durable_position() const final;
+  void WaitUntilDurable(uint64_t lsn) final;
+  int AddDurableListener(std::function<void()>&& listener) final;
+  void RemoveDurableListener(int id) final;
+
+  /**
+   * If disabled, writes return without waiting for their log entries to be flushed. The
+   * caller is then responsible for waiting with WaitUntilDurable() or Flush()
+   */
+  void SetSyncWrites(bool sync_writes) { sync_writes_ = sync_writes; }
+
+  // Blocks until everything written so far is durable
+  void Flush();
+
+  /**
+   * Durably records that the initial data has been fully loaded. Without this marker, the data
+   * recovered at startup may be a partial load that was interrupted by a crash
+   */
+  void MarkLoadComplete();
+  bool load_complete() const { return load_complete_; }
+
+  /* For debugging */
+  size_t num_recovered_entries() const { return num_recovered_entries_; }
+  uint64_t num_flushes() const;
+
+ private:
+  // A BATCH entry has no key and its value is a sequence of WRITE and DELETE entries
+  enum class EntryType : uint8_t { WRITE = 0, DELETE = 1, LOAD_COMPLETE = 2, BATCH = 3 };
+
+  static void Encode(std::string& buf, EntryType type, const Key& key, const Record* record);
+  // Appends a BATCH entry holding the given encoded entries to buf
+  static void EncodeBatch(std::string& buf, const std::string& entries);
+  // Applies the valid entries of a file to memory. Returns the number of records applied
+  size_t Replay(const std::string& path);
+  // Applies the entries in data and returns the position of the first invalid entry, or size if there is none
+  size_t ReplayEntries(const char* data, size_t size, size_t& num_entries);
+
+  void Recover();
+  // Appends encoded entries to the log buffer and returns the log position right after them
+  uint64_t Append(const std::string& entries);
+
+  void OpenLog(uint64_t seq);
+  void FlushLoop();
+  void CompactLoop();
+  void WriteCheckpoint(uint64_t seq);
+
+  std::string LogPath(uint64_t seq) const;
+  std::string CheckpointPath(uint64_t seq) const;
+
+  const std::string dir_;
+  const std::chrono::microseconds group_commit_window_;
+  const uint64_t compaction_bytes_;
+
+  MemOnlyStorage memory_;
+  // Held shared by writers from applying a write to memory until it is appended to the log, and
+  // exclusively by a checkpoint to wait for the writes that it may have seen in memory to be appended
+  std::shared_mutex apply_latch_;
+  size_t num_recovered_entries_ = 0;
+  std::atomic<bool> sync_writes_ = true;
+  std::atomic<bool> load_complete_ = false;
+
+  // Guards the members below it
+  mutable std::mutex mut_;
+  std::condition_variable flush_cv_;
+  std::condition_variable durable_cv_;
+  std::condition_variable compact_cv_;
+  std::string buffer_;
+  // Only modified with the mutex held but can be read without it
+  std::atomic<uint64_t> appended_lsn_ = 0;
+  std::atomic<uint64_t> durable_lsn_ = 0;
+  uint64_t num_flushes_ = 0;
+  std::unordered_map<int, std::function<void()>> durable_listeners_;
+  int next_listener_id_ = 0;
+  // Sequence number of the newest closed log that is not covered by a checkpoint yet
+  uint64_t compact_seq_ = 0;
+  bool stopping_ = false;
+
+  // Only accessed by the flush thread after construction
+  int log_fd_ = -1;
+  uint64_t log_seq_ = 0;
+  uint64_t log_size_ = 0;
+  std::string flushing_buffer_;
+
+  // Only accessed by the compaction thread after construction
+  uint64_t checkpoint_seq_ = 0;
+
+  std::thread flush_thread_;
+  std::thread compact_thread_;
+};
+
+}  // namespace slog
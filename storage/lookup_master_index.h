@@ -1,5 +1,8 @@
 #pragma once
 
+#include <optional>
+#include <vector>
+
 #include "common/types.h"
 
 namespace slog {
@@ -7,6 +10,21 @@ namespace slog {
 class LookupMasterIndex {
  public:
   virtual bool GetMasterMetadata(const Key& key, Metadata& metadata) const = 0;
+
+  /**
+   * Looks up a batch of keys. The i-th result is empty if the i-th key does not exist
+   */
+  virtual void GetMasterMetadata(const std::vector<const Key*>& keys,
+                                 std::vector<std::optional<Metadata>>& results) const {
+    results.resize(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+      if (Metadata metadata; GetMasterMetadata(*keys[i], metadata)) {
+        results[i] = metadata;
+      } else {
+        results[i].reset();
+      }
+    }
+  }
 };
 
-}  // namespace slog
\ No newline at end of file
+}  // namespace slog
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "data_structure/concurrent_hash_map.h"
+#include "storage/lookup_master_index.h"
+
+namespace slog {
+
+/**
+ * A compact key-to-metadata table that is kept next to the record table of a storage.
+ * Master lookups are served from this table so that they never touch the records.
+ */
+class MasterIndex : public LookupMasterIndex {
+ public:
+  bool GetMasterMetadata(const Key& key, Metadata& metadata) const final {
+    EpochGuard guard;
+    auto stored = table_.GetPinned(key);
+    if (stored == nullptr) {
+      return false;
+    }
+    metadata = *stored;
+    return true;
+  }
+
+  void GetMasterMetadata(const std::vector<const Key*>& keys,
+                         std::vector<std::optional<Metadata>>& results) const final {
+    results.resize(keys.size());
+    // Enter the epoch once for the whole batch instead of once per key
+    EpochGuard guard;
+    table_.MultiGetPinned(keys, [&](size_t i, const Metadata* stored) {
+      if (stored == nullptr) {
+        results[i].reset();
+      } else {
+        results[i] = *stored;
+      }
+      return true;
+    });
+  }
+
+  void Set(const Key& key, const Metadata& metadata) {
+    // Most writes do not change the metadata of a key so avoid replacing the entry in that case
+    {
+      EpochGuard guard;
+      auto stored = table_.GetPinned(key);
+      if (stored != nullptr && stored->master == metadata.master && stored->counter == metadata.counter) {
+        return;
+      }
+    }
+    table_.InsertOrUpdate(key, metadata);
+  }
+
+  void Erase(const Key& key) { table_.Erase(key); }
+
+  void Reserve(size_t num_keys) { table_.Reserve(num_keys); }
+
+ private:
+  ConcurrentHashMap<Key, Metadata> table_;
+};
+
+}  // namespace slog
@@ -2,6 +2,7 @@
 
 #include "data_structure/concurrent_hash_map.h"
 #include "storage/lookup_master_index.h"
+#include "storage/master_index.h"
 #include "storage/storage.h"
 
 namespace slog {
@@ -10,21 +11,78 @@ class MemOnlyStorage : public Storage, public LookupMasterIndex {
  public:
   bool Read(const Key& key, Record& result) const final { return table_.Get(result, key); }
 
-  bool Write(const Key& key, const Record& record) final { return table_.InsertOrUpdate(key, record); }
-
-  bool Delete(const Key& key) final { return table_.Erase(key); }
-
-  bool GetMasterMetadata(const Key& key, Metadata& metadata) const final {
-    Record rec;
-    if (!table_.Get(rec, key)) {
+  bool ReadView(const Key& key, RecordView& view) const final {
+    view.Pin();
+    auto record = table_.GetPinned(key);
+    if (record == nullptr) {
+      view.Reset();
       return false;
     }
-    metadata = rec.metadata();
+    view.SetPinned(record);
     return true;
   }
 
+  bool ReadMetadata(const Key& key, Metadata& metadata) const final {
+    return master_index_.GetMasterMetadata(key, metadata);
+  }
+
+  bool Write(const Key& key, const Record& record) final {
+    master_index_.Set(key, record.metadata());
+    return table_.InsertOrUpdate(key, record);
+  }
+
+  bool Write(const Key& key, Record&& record) final {
+    master_index_.Set(key, record.metadata());
+    return table_.InsertOrUpdate(key, std::move(record));
+  }
+
+  bool Delete(const Key& key) final {
+    master_index_.Erase(key);
+    return table_.Erase(key);
+  }
+
+  void MultiRead(const std::vector<const Key*>& keys,
+                 const std::function<bool(size_t, const RecordView&)>& fn) const final {
+    // A single epoch covers the whole batch
+    RecordView view;
+    view.Pin();
+    table_.MultiGetPinned(keys, [&](size_t i, const Record* record) {
+      view.SetPinned(record);
+      return fn(i, view);
+    });
+  }
+
+  void MultiWrite(const std::vector<const Key*>& keys, std::vector<Record>& records) final {
+    for (size_t i = 0; i < keys.size(); i++) {
+      master_index_.Set(*keys[i], records[i].metadata());
+    }
+    table_.MultiInsertOrUpdate(keys, records);
+  }
+
+  void Reserve(size_t num_records) final {
+    table_.Reserve(num_records);
+    master_index_.Reserve(num_records);
+  }
+
+  bool GetMasterMetadata(const Key& key, Metadata& metadata) const final {
+    return master_index_.GetMasterMetadata(key, metadata);
+  }
+
+  // Calls fn(key, record) on every record. See ConcurrentHashMap::ForEach
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    table_.ForEach(fn);
+  }
+
+  void GetMasterMetadata(const std::vector<const Key*>& keys,
+                         std::vector<std::optional<Metadata>>& results) const final {
+    master_index_.GetMasterMetadata(keys, results);
+  }
+
  private:
   ConcurrentHashMap<Key, Record> table_;
+  // Master metadata is duplicated here so that master lookups do not go through the records
+  MasterIndex master_index_;
 };
 
 }  // namespace slog
\ No newline at end of file
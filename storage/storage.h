@@ -1,17 +1,151 @@
 #pragma once
 
+#include <glog/logging.h>
+
+#include <functional>
+#include <string_view>
+#include <vector>
+
 #include "common/types.h"
+#include "data_structure/epoch_manager.h"
 
 namespace slog {
 
+/**
+ * A read-only view of a record returned by Storage::ReadView.
+ *
+ * Depending on the storage, the view either points directly into the storage memory,
+ * which is then pinned by an epoch until the view is reset or destroyed, or owns a
+ * copy of the record. Since an epoch is bound to the calling thread, a view must not
+ * be passed to another thread, and it should be short-lived so that it does not hold
+ * back memory reclamation in the storage.
+ */
+class RecordView {
+ public:
+  RecordView() = default;
+  ~RecordView() { Reset(); }
+
+  RecordView(const RecordView&) = delete;
+  RecordView& operator=(const RecordView&) = delete;
+
+  const char* data() const { return record_->data(); }
+  size_t size() const { return record_->size(); }
+  std::string_view value() const { return std::string_view(data(), size()); }
+  const Metadata& metadata() const { return record_->metadata(); }
+  std::string to_string() const { return record_->to_string(); }
+
+  bool valid() const { return record_ != nullptr; }
+
+  void Reset() {
+    record_ = nullptr;
+    if (pinned_) {
+      EpochManager::Instance().Exit();
+      pinned_ = false;
+    }
+  }
+
+  /* For Storage implementations */
+
+  // Enters an epoch. Must be called before looking up the record to be pinned
+  void Pin() {
+    Reset();
+    EpochManager::Instance().Enter();
+    pinned_ = true;
+  }
+
+  // Points the view to a record that is protected by the epoch entered in Pin()
+  void SetPinned(const Record* record) {
+    DCHECK(pinned_);
+    record_ = record;
+  }
+
+  // Returns a record owned by the view, to be filled by the storage
+  Record& Own() {
+    Reset();
+    record_ = &owned_;
+    return owned_;
+  }
+
+ private:
+  const Record* record_ = nullptr;
+  Record owned_;
+  bool pinned_ = false;
+};
+
 class Storage {
  public:
   virtual ~Storage() = default;
   virtual bool Read(const Key& key, Record& result) const = 0;
+  // Reads a record without copying it out of the storage if possible. By default, the record is copied into the view
+  virtual bool ReadView(const Key& key, RecordView& view) const {
+    if (!Read(key, view.Own())) {
+      view.Reset();
+      return false;
+    }
+    return true;
+  }
+  // Reads only the master metadata of a record
+  virtual bool ReadMetadata(const Key& key, Metadata& metadata) const {
+    RecordView view;
+    if (!ReadView(key, view)) {
+      return false;
+    }
+    metadata = view.metadata();
+    return true;
+  }
   // Returns true if key exists
   virtual bool Write(const Key& key, const Record& record) = 0;
   virtual bool Write(const Key& key, Record&& record) { return Write(key, record); };
   virtual bool Delete(const Key& key) = 0;
+
+  /**
+   * Reads a batch of keys, calling fn(i, view) in order for each keys[i]. The view is invalid if the
+   * key does not exist and is only valid during the call. Reading stops early if fn returns false
+   */
+  virtual void MultiRead(const std::vector<const Key*>& keys,
+                         const std::function<bool(size_t, const RecordView&)>& fn) const {
+    RecordView view;
+    for (size_t i = 0; i < keys.size(); i++) {
+      ReadView(*keys[i], view);
+      if (!fn(i, view)) {
+        return;
+      }
+    }
+  }
+
+  // Prepares the storage for bulk loading about the given number of records
+  virtual void Reserve(size_t /* num_records */) {}
+
+  // Writes a batch of records, which are moved from
+  virtual void MultiWrite(const std::vector<const Key*>& keys, std::vector<Record>& records) {
+    for (size_t i = 0; i < keys.size(); i++) {
+      Write(*keys[i], std::move(records[i]));
+    }
+  }
+
+  // Writes a batch of records, which are moved from, and deletes a batch of keys as one unit, like the writes of a txn
+  virtual void WriteBatch(const std::vector<const Key*>& keys, std::vector<Record>& records,
+                          const std::vector<const Key*>& deleted_keys) {
+    MultiWrite(keys, records);
+    for (auto key : deleted_keys) {
+      Delete(*key);
+    }
+  }
+
+  /* Durability. A storage that persists its writes may make them durable after they return */
+
+  // Position in the log right after the last write made to the storage
+  virtual uint64_t log_position() const { return 0; }
+  // Position in the log up to which the writes are durable
+  virtual uint64_t durable_position() const { return 0; }
+  // Blocks until the writes up to a log position are durable
+  virtual void WaitUntilDurable(uint64_t /* position */) {}
+  /**
+   * Registers a function that is called from a background thread every time durable_position() advances.
+   * Returns an id to unregister it with
+   */
+  virtual int AddDurableListener(std::function<void()>&& /* listener */) { return -1; }
+  virtual void RemoveDurableListener(int /* id */) {}
 };
 
-}  // namespace slog
\ No newline at end of file
+}  // namespace slog
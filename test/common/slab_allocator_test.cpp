@@ -0,0 +1,64 @@
+#include "common/slab_allocator.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "common/types.h"
+
+using namespace std;
+using namespace slog;
+
+TEST(SlabAllocatorTest, RecycleFreedSlots) {
+  SlabAllocator& allocator = SlabAllocator::Default();
+  auto a = allocator.Allocate(100);
+  allocator.Deallocate(a, 100);
+  // A freed slot is reused by the next allocation of the same size class
+  auto b = allocator.Allocate(110);
+  ASSERT_EQ(a, b);
+  allocator.Deallocate(b, 110);
+}
+
+TEST(SlabAllocatorTest, SizeClasses) {
+  ASSERT_TRUE(SlabAllocator::FitsSameSlot(1, 16));
+  ASSERT_FALSE(SlabAllocator::FitsSameSlot(16, 17));
+  ASSERT_TRUE(SlabAllocator::FitsSameSlot(129, 160));
+  ASSERT_FALSE(SlabAllocator::FitsSameSlot(160, 161));
+  ASSERT_TRUE(SlabAllocator::FitsSameSlot(3585, 4096));
+  ASSERT_FALSE(SlabAllocator::FitsSameSlot(4096, 4097));
+  ASSERT_FALSE(SlabAllocator::FitsSameSlot(0, 1));
+}
+
+TEST(SlabAllocatorTest, AllocationsDoNotOverlap) {
+  SlabAllocator& allocator = SlabAllocator::Default();
+  vector<pair<char*, size_t>> allocs;
+  for (size_t i = 1; i <= 5000; i++) {
+    auto ptr = allocator.Allocate(i);
+    memset(ptr, i % 256, i);
+    allocs.emplace_back(ptr, i);
+  }
+  for (auto [ptr, size] : allocs) {
+    for (size_t j = 0; j < size; j++) {
+      ASSERT_EQ(static_cast<unsigned char>(ptr[j]), size % 256);
+    }
+    allocator.Deallocate(ptr, size);
+  }
+}
+
+TEST(SlabAllocatorTest, RecordsAcrossThreads) {
+  vector<Record> records;
+  for (int i = 0; i < 10000; i++) {
+    records.emplace_back(to_string(i));
+  }
+  // Free the records on a different thread than the one allocating them
+  thread t([records = std::move(records)]() mutable { records.clear(); });
+  t.join();
+
+  Record record("foo");
+  record.SetValue("foobar");
+  ASSERT_EQ(record.to_string(), "foobar");
+  Record copy(record);
+  ASSERT_EQ(copy.to_string(), "foobar");
+  Record moved(std::move(copy));
+  ASSERT_EQ(moved.to_string(), "foobar");
+}
@@ -0,0 +1,93 @@
+#include "common/snapshot.h"
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstddef>
+
+using namespace std;
+using namespace slog;
+
+TEST(SnapshotTest, WriteThenRead) {
+  char path[] = "/tmp/snapshot_test_XXXXXX";
+  auto fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  close(fd);
+
+  // Enough records to flush the write buffers several times
+  const uint64_t kNumRecords = 100000;
+  {
+    SnapshotWriter writer(path, kNumRecords);
+    for (uint64_t i = 0; i < kNumRecords; i++) {
+      writer.Add("key" + to_string(i), string(i % 200, 'a' + i % 26), Metadata(i % 3, i % 5));
+    }
+    writer.Finish();
+  }
+
+  SnapshotReader reader(path);
+  ASSERT_EQ(reader.num_records(), kNumRecords);
+  reader.WillNeed(0, kNumRecords);
+  for (uint64_t i = 0; i < kNumRecords; i++) {
+    auto entry = reader.Get(i);
+    ASSERT_EQ(entry.key, "key" + to_string(i));
+    ASSERT_EQ(entry.value, string(i % 200, 'a' + i % 26));
+    ASSERT_EQ(entry.metadata.master, i % 3);
+    ASSERT_EQ(entry.metadata.counter, i % 5);
+  }
+
+  unlink(path);
+}
+
+namespace {
+
+void WriteSnapshot(const char* path, uint64_t num_records) {
+  SnapshotWriter writer(path, num_records);
+  for (uint64_t i = 0; i < num_records; i++) {
+    writer.Add("key" + to_string(i), "value" + to_string(i), Metadata());
+  }
+  writer.Finish();
+}
+
+// Overwrites a 64-bit field of the snapshot at the given position
+void Corrupt(const char* path, off_t pos, uint64_t value) {
+  auto fd = open(path, O_WRONLY);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(pwrite(fd, &value, sizeof(value), pos), static_cast<ssize_t>(sizeof(value)));
+  close(fd);
+}
+
+}  // namespace
+
+TEST(SnapshotTest, RejectCorruptHeader) {
+  char path[] = "/tmp/snapshot_test_XXXXXX";
+  auto fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  close(fd);
+  WriteSnapshot(path, 10);
+
+  // More records than the directory region can hold
+  Corrupt(path, offsetof(snapshot::Header, num_records), 1000);
+  ASSERT_DEATH(SnapshotReader reader(path), "truncated");
+
+  unlink(path);
+}
+
+TEST(SnapshotTest, RejectCorruptEntry) {
+  char path[] = "/tmp/snapshot_test_XXXXXX";
+  auto fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  close(fd);
+  WriteSnapshot(path, 10);
+
+  // Point the last entry past the end of the data region
+  auto entry_pos = sizeof(snapshot::Header) + 9 * sizeof(snapshot::DirectoryEntry);
+  Corrupt(path, entry_pos + offsetof(snapshot::DirectoryEntry, offset), 1 << 20);
+
+  SnapshotReader reader(path);
+  reader.WillNeed(0, 10);
+  ASSERT_EQ(reader.Get(8).key, "key8");
+  ASSERT_DEATH(reader.Get(9), "out of bounds");
+
+  unlink(path);
+}
@@ -320,10 +320,78 @@ TEST(BrokerTest, RemoveRedirection) {
     ping_sender.Send(*ping_req, configs[0]->MakeMachineId(0, 1), TAG);
   }
 
-  // The redirection is removed so we shouldn't be able to receive anything here
-  // Theoretically, it is possible that the recv function is called before the
-  // pong broker removes the redirection, making the assertion to fail. However,
-  // it should be unlikely due to the sleep.
+  // The redirection is removed so we shouldn't be able to receive anything here.
+  // The pong broker applies the removal before handling the ping since the removal
+  // was sent first. The sleep gives the ping time to arrive and be dropped.
   this_thread::sleep_for(5ms);
   ASSERT_EQ(RecvEnvelope(pong_socket, true), nullptr);
-}
\ No newline at end of file
+}
+
+TEST(BrokerTest, RedirectionExpiresAfterNumMessages) {
+  const Channel PING = 8;
+  const Channel PONG = 9;
+  const Channel TAG = 11111;
+  ConfigVec configs = MakeTestConfigurations("pingpong", 1, 2);
+
+  // Initialize ping machine
+  auto ping_broker = Broker::New(configs[0], kTestModuleTimeout);
+  auto ping_socket = MakePullSocket(*ping_broker->context(), PING);
+  ping_broker->AddChannel(PING);
+  ping_broker->StartInNewThreads();
+  Sender ping_sender(ping_broker->config(), ping_broker->context());
+
+  // Initialize pong machine
+  auto pong_broker = Broker::New(configs[1], kTestModuleTimeout);
+  auto pong_socket = MakePullSocket(*pong_broker->context(), PONG);
+  pong_broker->AddChannel(PONG);
+  pong_broker->StartInNewThreads();
+  Sender pong_sender(pong_broker->config(), pong_broker->context());
+
+  // Send a ping message before the redirection is established so that it is queued up at the broker
+  {
+    auto ping_req = MakePing(98);
+    ping_sender.Send(*ping_req, configs[0]->MakeMachineId(0, 1), TAG);
+  }
+  this_thread::sleep_for(5ms);
+
+  // Establish a redirection from TAG to the PONG channel for two messages at the pong machine
+  {
+    auto env = std::make_unique<internal::Envelope>();
+    auto redirect = env->mutable_request()->mutable_broker_redirect();
+    redirect->set_tag(TAG);
+    redirect->set_channel(PONG);
+    redirect->set_num_messages(2);
+    pong_sender.Send(move(env), kBrokerChannel + 1);
+  }
+
+  // Both the queued message and the next message are forwarded
+  {
+    auto ping_req = MakePing(99);
+    ping_sender.Send(*ping_req, configs[0]->MakeMachineId(0, 1), TAG);
+  }
+  for (auto time : {98, 99}) {
+    auto ping_req = RecvEnvelope(pong_socket);
+    ASSERT_TRUE(ping_req != nullptr);
+    ASSERT_TRUE(ping_req->has_request());
+    ASSERT_EQ(time, ping_req->request().ping().time());
+  }
+
+  // The redirection has expired so the third message is not forwarded
+  {
+    auto ping_req = MakePing(100);
+    ping_sender.Send(*ping_req, configs[0]->MakeMachineId(0, 1), TAG);
+  }
+  this_thread::sleep_for(5ms);
+  ASSERT_EQ(RecvEnvelope(pong_socket, true), nullptr);
+
+  // The third message has been dropped instead of being queued up for the tag
+  {
+    auto env = std::make_unique<internal::Envelope>();
+    auto redirect = env->mutable_request()->mutable_broker_redirect();
+    redirect->set_tag(TAG);
+    redirect->set_channel(PONG);
+    pong_sender.Send(move(env), kBrokerChannel + 1);
+  }
+  this_thread::sleep_for(5ms);
+  ASSERT_EQ(RecvEnvelope(pong_socket, true), nullptr);
+}
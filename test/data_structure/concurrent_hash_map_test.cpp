@@ -2,6 +2,7 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <thread>
 
 using namespace std;
@@ -60,6 +61,82 @@ TEST(ConcurrentHashMapTest, TriggerRehash) {
   }
 }
 
+TEST(ConcurrentHashMapTest, ReserveBeforeBulkLoad) {
+  ConcurrentHashMap<string, string> map;
+  string result;
+  map.InsertOrUpdate("existing", "foo");
+
+  // Growing the segments must keep the existing entries
+  map.Reserve(10000);
+  ASSERT_TRUE(map.Get(result, "existing"));
+  ASSERT_EQ(result, "foo");
+
+  vector<string> keys;
+  vector<string> values;
+  for (size_t i = 0; i < 10000; i++) {
+    keys.push_back(to_string(i));
+    values.push_back("foo" + to_string(i));
+  }
+  vector<const string*> key_ptrs;
+  for (auto& key : keys) {
+    key_ptrs.push_back(&key);
+  }
+  map.MultiInsertOrUpdate(key_ptrs, values);
+
+  for (size_t i = 0; i < 10000; i++) {
+    ASSERT_TRUE(map.Get(result, to_string(i))) << "Failed at i = " << i;
+    ASSERT_EQ(result, "foo" + to_string(i)) << "Failed at i = " << i;
+  }
+
+  // Reserving less than the current size is a no-op
+  map.Reserve(10);
+  ASSERT_TRUE(map.Get(result, "9999"));
+  ASSERT_EQ(result, "foo9999");
+}
+
+TEST(ConcurrentHashMapTest, MultiKeyOperations) {
+  ConcurrentHashMap<string, string> map;
+  // Enough keys to span multiple prefetch chunks and trigger rehashes. The last key
+  // is a duplicate so its last value must win
+  vector<string> keys;
+  vector<string> values;
+  for (size_t i = 0; i < 1000; i++) {
+    keys.push_back(to_string(i));
+    values.push_back("foo" + to_string(i));
+  }
+  keys.push_back("0");
+  values.push_back("bar");
+  vector<const string*> key_ptrs;
+  for (const auto& key : keys) {
+    key_ptrs.push_back(&key);
+  }
+  map.MultiInsertOrUpdate(key_ptrs, values);
+
+  key_ptrs.pop_back();
+  string missing = "missing";
+  key_ptrs.push_back(&missing);
+
+  EpochGuard guard;
+  size_t num_visited = 0;
+  map.MultiGetPinned(key_ptrs, [&](size_t i, const string* value) {
+    EXPECT_EQ(i, num_visited++);
+    if (i == 0) {
+      EXPECT_EQ(*value, "bar");
+    } else if (i == 1000) {
+      EXPECT_EQ(value, nullptr);
+    } else {
+      EXPECT_EQ(*value, "foo" + to_string(i));
+    }
+    return true;
+  });
+  ASSERT_EQ(num_visited, 1001U);
+
+  // Stop early
+  num_visited = 0;
+  map.MultiGetPinned(key_ptrs, [&](size_t, const string*) { return ++num_visited < 20; });
+  ASSERT_EQ(num_visited, 20U);
+}
+
 TEST(ConcurrentHashMapTest, TwoReadersOneWriter) {
   uint32_t N = 500000;
   string key = "foo";
@@ -161,4 +238,44 @@ TEST(ConcurrentHashMapTest, OneWriterOneEraser) {
       ASSERT_EQ(result, to_string(i));
     }
   }
-}
\ No newline at end of file
+}
+
+TEST(ConcurrentHashMapTest, ReadersNeverMissKeysDuringRehash) {
+  int N = 200000;
+  int M = 1000;
+  ConcurrentHashMap<string, string> map;
+
+  for (int i = 0; i < M; i++) {
+    map.InsertOrUpdate(to_string(i), to_string(i));
+  }
+
+  std::atomic<bool> done = false;
+  auto Updates = [&]() {
+    for (int i = M; i < N; i++) {
+      map.InsertOrUpdate(to_string(i), to_string(i));
+      // Keep replacing and erasing nodes so that they are retired while being read
+      map.InsertOrUpdate(to_string(i % M), to_string(i % M));
+      if (i > M) {
+        map.Erase(to_string(i - 1));
+      }
+    }
+    done = true;
+  };
+
+  auto Gets = [&]() {
+    string result;
+    while (!done) {
+      for (int i = 0; i < M; i++) {
+        ASSERT_TRUE(map.Get(result, to_string(i))) << "Failed at i = " << i;
+        ASSERT_EQ(result, to_string(i));
+      }
+    }
+  };
+
+  thread w(Updates);
+  thread r1(Gets);
+  thread r2(Gets);
+  w.join();
+  r1.join();
+  r2.join();
+}
@@ -0,0 +1,58 @@
+#include "data_structure/small_vector.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace std;
+using namespace slog;
+
+TEST(SmallVectorTest, StaysInlineUntilFull) {
+  SmallVector<int, 4> vec;
+  for (int i = 0; i < 4; i++) {
+    vec.push_back(i);
+  }
+  ASSERT_TRUE(vec.is_inline());
+  vec.push_back(4);
+  ASSERT_FALSE(vec.is_inline());
+  ASSERT_EQ(vector<int>(vec.begin(), vec.end()), vector<int>({0, 1, 2, 3, 4}));
+}
+
+TEST(SmallVectorTest, Erase) {
+  SmallVector<int, 2> vec;
+  for (int i = 0; i < 6; i++) {
+    vec.push_back(i);
+  }
+  vec.erase(vec.begin() + 1);
+  ASSERT_EQ(vector<int>(vec.begin(), vec.end()), vector<int>({0, 2, 3, 4, 5}));
+  vec.erase(vec.begin(), vec.begin() + 3);
+  ASSERT_EQ(vector<int>(vec.begin(), vec.end()), vector<int>({4, 5}));
+  vec.clear();
+  ASSERT_TRUE(vec.empty());
+}
+
+TEST(SmallVectorTest, CopyAndMove) {
+  SmallVector<int, 2> small, large;
+  small.push_back(1);
+  for (int i = 0; i < 10; i++) {
+    large.push_back(i);
+  }
+
+  auto small_copy = small;
+  auto large_copy = large;
+  ASSERT_EQ(vector<int>(small_copy.begin(), small_copy.end()), vector<int>({1}));
+  ASSERT_EQ(large_copy.size(), 10);
+  ASSERT_NE(large_copy.begin(), large.begin());
+
+  auto small_moved = std::move(small);
+  auto large_moved = std::move(large);
+  ASSERT_TRUE(small.empty());
+  ASSERT_TRUE(large.empty());
+  ASSERT_TRUE(large.is_inline());
+  ASSERT_EQ(vector<int>(small_moved.begin(), small_moved.end()), vector<int>({1}));
+  ASSERT_EQ(large_moved.size(), 10);
+  ASSERT_EQ(large_moved[9], 9);
+
+  large_copy = small_moved;
+  ASSERT_EQ(vector<int>(large_copy.begin(), large_copy.end()), vector<int>({1}));
+}
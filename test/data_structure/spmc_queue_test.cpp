@@ -0,0 +1,82 @@
+#include "data_structure/spmc_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace slog;
+
+TEST(SpmcQueueTest, PushAndPopInOrder) {
+  SpmcQueue<int> queue(5);
+  ASSERT_EQ(queue.capacity(), 8U);
+
+  int item;
+  bool was_empty;
+  ASSERT_FALSE(queue.Pop(item));
+  for (int i = 0; i < 8; i++) {
+    ASSERT_TRUE(queue.Push(i, was_empty));
+    ASSERT_EQ(was_empty, i == 0);
+    ASSERT_EQ(queue.size(), static_cast<size_t>(i + 1));
+  }
+  // The queue is full
+  ASSERT_FALSE(queue.Push(8, was_empty));
+
+  for (int i = 0; i < 8; i++) {
+    ASSERT_TRUE(queue.Pop(item));
+    ASSERT_EQ(item, i);
+  }
+  ASSERT_FALSE(queue.Pop(item));
+  ASSERT_EQ(queue.size(), 0U);
+}
+
+TEST(SpmcQueueTest, ConcurrentConsumersTakeEachItemOnce) {
+  const uint64_t kNumItems = 100000;
+  const int kNumConsumers = 3;
+  SpmcQueue<uint64_t> queue(64);
+
+  thread producer([&queue] {
+    bool was_empty;
+    for (uint64_t i = 0; i < kNumItems; i++) {
+      while (!queue.Push(i, was_empty)) {
+        this_thread::yield();
+      }
+    }
+  });
+
+  vector<vector<uint64_t>> taken(kNumConsumers);
+  vector<thread> consumers;
+  atomic<uint64_t> num_taken = 0;
+  for (int c = 0; c < kNumConsumers; c++) {
+    consumers.emplace_back([&, c] {
+      uint64_t item;
+      while (num_taken.load() < kNumItems) {
+        if (queue.Pop(item)) {
+          taken[c].push_back(item);
+          num_taken++;
+        } else {
+          this_thread::yield();
+        }
+      }
+    });
+  }
+  producer.join();
+  for (auto& t : consumers) {
+    t.join();
+  }
+
+  vector<int> count(kNumItems, 0);
+  for (const auto& items : taken) {
+    // Each consumer sees the items in the order that they are pushed
+    for (size_t i = 1; i < items.size(); i++) {
+      ASSERT_LT(items[i - 1], items[i]);
+    }
+    for (auto item : items) {
+      count[item]++;
+    }
+  }
+  for (uint64_t i = 0; i < kNumItems; i++) {
+    ASSERT_EQ(count[i], 1) << "Item " << i;
+  }
+}
@@ -0,0 +1,69 @@
+#include "data_structure/spsc_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+using namespace std;
+using namespace slog;
+
+TEST(SpscQueueTest, PushAndPopInOrder) {
+  SpscQueue<int> queue(5);
+  ASSERT_EQ(queue.capacity(), 8U);
+
+  int item;
+  bool was_empty;
+  ASSERT_FALSE(queue.Pop(item));
+  for (int i = 0; i < 8; i++) {
+    ASSERT_TRUE(queue.Push(i, was_empty));
+    ASSERT_EQ(was_empty, i == 0);
+  }
+  // The queue is full
+  ASSERT_FALSE(queue.Push(8, was_empty));
+
+  for (int i = 0; i < 8; i++) {
+    ASSERT_TRUE(queue.Pop(item));
+    ASSERT_EQ(item, i);
+  }
+  ASSERT_FALSE(queue.Pop(item));
+}
+
+TEST(SpscQueueTest, WrapAround) {
+  SpscQueue<int> queue(4);
+  int item;
+  bool was_empty;
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(queue.Push(2 * i, was_empty));
+    ASSERT_TRUE(was_empty);
+    ASSERT_TRUE(queue.Push(2 * i + 1, was_empty));
+    ASSERT_FALSE(was_empty);
+    ASSERT_TRUE(queue.Pop(item));
+    ASSERT_EQ(item, 2 * i);
+    ASSERT_TRUE(queue.Pop(item));
+    ASSERT_EQ(item, 2 * i + 1);
+  }
+}
+
+TEST(SpscQueueTest, ConcurrentProducerAndConsumer) {
+  const uint64_t kNumItems = 1000000;
+  SpscQueue<uint64_t> queue(64);
+
+  thread producer([&queue] {
+    bool was_empty;
+    for (uint64_t i = 0; i < kNumItems; i++) {
+      while (!queue.Push(i, was_empty)) {
+        this_thread::yield();
+      }
+    }
+  });
+
+  uint64_t item;
+  for (uint64_t i = 0; i < kNumItems; i++) {
+    while (!queue.Pop(item)) {
+      this_thread::yield();
+    }
+    ASSERT_EQ(item, i);
+  }
+  producer.join();
+  ASSERT_FALSE(queue.Pop(item));
+}
@@ -0,0 +1,127 @@
+#include "data_structure/txn_table.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <unordered_map>
+
+#include "module/scheduler_components/txn_holder.h"
+#include "test/test_utils.h"
+
+using namespace std;
+using namespace slog;
+
+namespace {
+
+struct TestObject {
+  TestObject(int value) { Reset(value); }
+
+  void Reset(int value) {
+    this->value = value;
+    num_resets++;
+  }
+
+  void Clear() { buffer.clear(); }
+
+  int value;
+  int num_resets = 0;
+  vector<int> buffer;
+};
+
+}  // namespace
+
+TEST(TxnTableTest, InsertFindErase) {
+  TxnTable<TestObject> table(4);
+  auto [obj, inserted] = table.TryEmplace(100, 1);
+  ASSERT_TRUE(inserted);
+  ASSERT_EQ(obj->value, 1);
+
+  // Inserting the same txn again returns the existing object
+  auto [same_obj, inserted_again] = table.TryEmplace(100, 2);
+  ASSERT_FALSE(inserted_again);
+  ASSERT_EQ(same_obj, obj);
+  ASSERT_EQ(same_obj->value, 1);
+
+  ASSERT_EQ(table.Find(100), obj);
+  ASSERT_EQ(table.Find(200), nullptr);
+  ASSERT_EQ(table.size(), 1U);
+
+  ASSERT_TRUE(table.Erase(100));
+  ASSERT_FALSE(table.Erase(100));
+  ASSERT_EQ(table.Find(100), nullptr);
+  ASSERT_TRUE(table.empty());
+}
+
+TEST(TxnTableTest, RecycleErasedObjects) {
+  TxnTable<TestObject> table;
+  auto obj = table.TryEmplace(1, 10).first;
+  obj->buffer.resize(100);
+  auto capacity = obj->buffer.capacity();
+  table.Erase(1);
+
+  // The next txn takes over the erased object together with its buffer
+  auto [recycled, inserted] = table.TryEmplace(2, 20);
+  ASSERT_TRUE(inserted);
+  ASSERT_EQ(recycled, obj);
+  ASSERT_EQ(recycled->value, 20);
+  ASSERT_EQ(recycled->num_resets, 2);
+  ASSERT_TRUE(recycled->buffer.empty());
+  ASSERT_EQ(recycled->buffer.capacity(), capacity);
+  ASSERT_EQ(table.num_pooled(), 1U);
+}
+
+TEST(TxnTableTest, MatchUnorderedMap) {
+  // Start small to go through a few rounds of growing
+  TxnTable<TestObject> table(4);
+  unordered_map<TxnId, TestObject*> expected;
+  std::mt19937 rg(0);
+  for (int i = 0; i < 20000; i++) {
+    // Txn ids that share their low bits like the ids of a machine
+    TxnId txn_id = (rg() % 1000) * 1000 + 3;
+    if (rg() % 3 == 0) {
+      ASSERT_EQ(table.Erase(txn_id), expected.erase(txn_id) > 0);
+    } else {
+      auto [obj, inserted] = table.TryEmplace(txn_id, i);
+      auto ins = expected.emplace(txn_id, obj);
+      ASSERT_EQ(inserted, ins.second);
+      ASSERT_EQ(obj, ins.first->second);
+    }
+    ASSERT_EQ(table.size(), expected.size());
+  }
+
+  for (const auto& [txn_id, obj] : expected) {
+    ASSERT_EQ(table.Find(txn_id), obj);
+  }
+  size_t num_visited = 0;
+  table.ForEach([&](TxnId txn_id, const TestObject& obj) {
+    ASSERT_EQ(expected.at(txn_id), &obj);
+    num_visited++;
+  });
+  ASSERT_EQ(num_visited, expected.size());
+}
+
+TEST(TxnTableTest, RecycledTxnHolderHasNewGeneration) {
+  auto configs = MakeTestConfigurations("txn_table", 2, 1);
+  TxnTable<TxnHolder> table;
+
+  auto txn1 = MakeTestTransaction(configs[0], 100, {{"A", KeyType::WRITE, 0}, {"B", KeyType::READ, 1}});
+  txn1->mutable_internal()->set_home(0);
+  auto holder = table.TryEmplace(100, configs[0], txn1).first;
+  auto lo_txn = MakeTestTransaction(configs[0], 100, {{"A", KeyType::WRITE, 0}, {"B", KeyType::READ, 1}});
+  lo_txn->mutable_internal()->set_home(1);
+  ASSERT_TRUE(holder->AddLockOnlyTxn(lo_txn));
+  holder->SetDone();
+  ASSERT_TRUE(holder->is_ready_for_gc());
+  auto generation = holder->generation();
+  table.Erase(100);
+
+  auto txn2 = MakeTestTransaction(configs[0], 200, {{"A", KeyType::WRITE, 0}});
+  txn2->mutable_internal()->set_home(0);
+  auto recycled = table.TryEmplace(200, configs[0], txn2).first;
+  ASSERT_EQ(recycled, holder);
+  ASSERT_NE(recycled->generation(), generation);
+  ASSERT_EQ(recycled->txn_id(), 200U);
+  ASSERT_EQ(&recycled->txn(), txn2);
+  ASSERT_EQ(recycled->num_lock_only_txns(), 1);
+  ASSERT_FALSE(recycled->is_done());
+}
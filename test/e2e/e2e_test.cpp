@@ -103,6 +103,36 @@ TEST_F(E2ETest, MultiPartitionTxn) {
   }
 }
 
+TEST_F(E2ETest, MultiPartitionTxnWaitsForRemoteKey) {
+  // B is in a different partition than A so the procedure suspends at the COPY until A arrives
+  auto txn = MakeTransaction({{"A", KeyType::READ}, {"B", KeyType::WRITE}},
+                             {{"SET", "B", "newB"}, {"COPY", "A", "B"}, {"EQ", "A", "valA"}});
+  test_slogs[0]->SendTxn(txn);
+  auto txn_resp = test_slogs[0]->RecvTxnResult();
+  ASSERT_EQ(txn_resp.status(), TransactionStatus::COMMITTED);
+  ASSERT_EQ(TxnValueEntry(txn_resp, "B").new_value(), "valA");
+
+  auto read_txn = MakeTransaction({{"B", KeyType::READ}}, {{"GET", "B"}});
+  test_slogs[1]->SendTxn(read_txn);
+  auto read_txn_resp = test_slogs[1]->RecvTxnResult();
+  ASSERT_EQ(read_txn_resp.status(), TransactionStatus::COMMITTED);
+  ASSERT_EQ(TxnValueEntry(read_txn_resp, "B").value(), "valA");
+}
+
+TEST_F(E2ETest, MultiPartitionTxnAbortsOnRemoteKey) {
+  auto txn = MakeTransaction({{"A", KeyType::READ}, {"B", KeyType::WRITE}},
+                             {{"SET", "B", "newB"}, {"EQ", "A", "notA"}});
+  test_slogs[0]->SendTxn(txn);
+  auto txn_resp = test_slogs[0]->RecvTxnResult();
+  ASSERT_EQ(txn_resp.status(), TransactionStatus::ABORTED);
+
+  auto read_txn = MakeTransaction({{"B", KeyType::READ}}, {{"GET", "B"}});
+  test_slogs[1]->SendTxn(read_txn);
+  auto read_txn_resp = test_slogs[1]->RecvTxnResult();
+  ASSERT_EQ(read_txn_resp.status(), TransactionStatus::COMMITTED);
+  ASSERT_EQ(TxnValueEntry(read_txn_resp, "B").value(), "valB");
+}
+
 TEST_F(E2ETest, MultiHomeTxn) {
   for (size_t i = 0; i < NUM_MACHINES; i++) {
     auto txn = MakeTransaction({{"A", KeyType::READ}, {"C", KeyType::WRITE}}, {{"GET", "A"}, {"SET", "C", "newC"}});
@@ -225,6 +255,108 @@ TEST_F(E2ETestBypassMHOrderer, MultiHomeMultiPartitionTxn) {
   }
 }
 
+class E2ETestSnapshotReads : public E2ETest {
+  internal::Configuration CustomConfig() final {
+    internal::Configuration config;
+    config.set_snapshot_read_only_txns(true);
+    return config;
+  }
+};
+
+TEST_F(E2ETestSnapshotReads, ReadOnlySingleHomeTxn) {
+  for (size_t i = 0; i < NUM_MACHINES; i++) {
+    auto txn = MakeTransaction({{"A", KeyType::READ}}, {{"GET", "A"}});
+
+    test_slogs[i]->SendTxn(txn);
+    auto txn_resp = test_slogs[i]->RecvTxnResult();
+    ASSERT_EQ(txn_resp.status(), TransactionStatus::COMMITTED);
+    ASSERT_TRUE(txn_resp.internal().snapshot());
+    ASSERT_EQ(txn_resp.internal().type(), TransactionType::SINGLE_HOME);
+    ASSERT_EQ(TxnValueEntry(txn_resp, "A").value(), "valA");
+  }
+}
+
+TEST_F(E2ETestSnapshotReads, MultiHomeReadGoesThroughLog) {
+  for (size_t i = 0; i < NUM_MACHINES; i++) {
+    // A and C are in the same partition but have different homes
+    auto txn = MakeTransaction({{"A", KeyType::READ}, {"C", KeyType::READ}}, {{"GET", "A"}, {"GET", "C"}});
+
+    test_slogs[i]->SendTxn(txn);
+    auto txn_resp = test_slogs[i]->RecvTxnResult();
+    ASSERT_EQ(txn_resp.status(), TransactionStatus::COMMITTED);
+    ASSERT_FALSE(txn_resp.internal().snapshot());
+    ASSERT_EQ(txn_resp.internal().type(), TransactionType::MULTI_HOME_OR_LOCK_ONLY);
+    ASSERT_EQ(TxnValueEntry(txn_resp, "A").value(), "valA");
+    ASSERT_EQ(TxnValueEntry(txn_resp, "C").value(), "valC");
+  }
+}
+
+TEST_F(E2ETestSnapshotReads, SnapshotSeesEarlierLocalWrites) {
+  auto txn1 = MakeTransaction({{"A", KeyType::WRITE}}, {{"SET", "A", "newA"}});
+  auto txn2 = MakeTransaction({{"A", KeyType::READ}}, {{"GET", "A"}});
+
+  test_slogs[0]->SendTxn(txn1);
+  auto txn1_resp = test_slogs[0]->RecvTxnResult();
+  ASSERT_EQ(txn1_resp.status(), TransactionStatus::COMMITTED);
+  ASSERT_FALSE(txn1_resp.internal().snapshot());
+
+  test_slogs[0]->SendTxn(txn2);
+  auto txn2_resp = test_slogs[0]->RecvTxnResult();
+  ASSERT_EQ(txn2_resp.status(), TransactionStatus::COMMITTED);
+  ASSERT_TRUE(txn2_resp.internal().snapshot());
+  ASSERT_EQ(TxnValueEntry(txn2_resp, "A").value(), "newA");
+}
+
+TEST_F(E2ETestSnapshotReads, MultiPartitionReadGoesThroughLog) {
+  auto txn = MakeTransaction({{"A", KeyType::READ}, {"B", KeyType::READ}}, {{"GET", "A"}, {"GET", "B"}});
+
+  test_slogs[0]->SendTxn(txn);
+  auto txn_resp = test_slogs[0]->RecvTxnResult();
+  ASSERT_EQ(txn_resp.status(), TransactionStatus::COMMITTED);
+  ASSERT_FALSE(txn_resp.internal().snapshot());
+  ASSERT_EQ(TxnValueEntry(txn_resp, "A").value(), "valA");
+  ASSERT_EQ(TxnValueEntry(txn_resp, "B").value(), "valB");
+}
+
+class E2ETestLogStorage : public E2ETest {
+  internal::Configuration CustomConfig() final {
+    char dir_template[] = "/tmp/e2e_log_storage_XXXXXX";
+    CHECK(mkdtemp(dir_template) != nullptr);
+    dir_ = dir_template;
+    internal::Configuration config;
+    config.set_storage_type(internal::StorageType::LOG);
+    config.set_log_storage_dir(dir_);
+    return config;
+  }
+
+  void TearDown() {
+    for (auto& test_slog : test_slogs) {
+      test_slog.reset();
+    }
+    ASSERT_EQ(system(("rm -rf " + dir_).c_str()), 0);
+  }
+
+  string dir_;
+};
+
+TEST_F(E2ETestLogStorage, ReadOwnWrites) {
+  for (size_t i = 0; i < NUM_MACHINES; i++) {
+    auto new_value = "newA" + to_string(i);
+    auto write_txn = MakeTransaction({{"A", KeyType::WRITE}, {"B", KeyType::WRITE}},
+                                     {{"SET", "A", new_value}, {"SET", "B", new_value}});
+    test_slogs[i]->SendTxn(write_txn);
+    auto write_txn_resp = test_slogs[i]->RecvTxnResult();
+    ASSERT_EQ(write_txn_resp.status(), TransactionStatus::COMMITTED);
+
+    auto read_txn = MakeTransaction({{"A", KeyType::READ}, {"B", KeyType::READ}}, {{"GET", "A"}, {"GET", "B"}});
+    test_slogs[i]->SendTxn(read_txn);
+    auto read_txn_resp = test_slogs[i]->RecvTxnResult();
+    ASSERT_EQ(read_txn_resp.status(), TransactionStatus::COMMITTED);
+    ASSERT_EQ(TxnValueEntry(read_txn_resp, "A").value(), new_value);
+    ASSERT_EQ(TxnValueEntry(read_txn_resp, "B").value(), new_value);
+  }
+}
+
 int main(int argc, char* argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
   google::InstallFailureSignalHandler();
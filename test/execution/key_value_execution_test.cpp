@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include "common/sharder.h"
+#include "execution/execution.h"
+#include "storage/mem_only_storage.h"
+#include "test/test_utils.h"
+
+using namespace std;
+using namespace slog;
+
+class KeyValueExecutionTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    configs = MakeTestConfigurations("kv_execution", 1, 2);
+    sharder = Sharder::MakeSharder(configs[0]);
+    storage = make_shared<MemOnlyStorage>();
+    execution = make_unique<KeyValueExecution>(sharder, storage);
+
+    // Pick a key of each partition
+    for (char c = 'A'; c <= 'Z' && (local_key.empty() || remote_key.empty()); c++) {
+      auto& key = sharder->is_local_key(string(1, c)) ? local_key : remote_key;
+      if (key.empty()) {
+        key = string(1, c);
+      }
+    }
+    ASSERT_FALSE(local_key.empty());
+    ASSERT_FALSE(remote_key.empty());
+  }
+
+  // Adds the value of a remote key to a txn, as the worker does with a remote read
+  void ArriveRemoteKey(Transaction& txn, const string& value) {
+    auto kv = txn.mutable_keys()->Add();
+    kv->set_key(remote_key);
+    kv->mutable_value_entry()->set_type(KeyType::READ);
+    kv->mutable_value_entry()->set_value(value);
+  }
+
+  ConfigVec configs;
+  SharderPtr sharder;
+  shared_ptr<MemOnlyStorage> storage;
+  unique_ptr<Execution> execution;
+  string local_key;
+  string remote_key;
+};
+
+TEST_F(KeyValueExecutionTest, SuspendOnRemoteKey) {
+  unique_ptr<Transaction> txn(MakeTestTransaction(configs[0], 1000, {{local_key, KeyType::WRITE, 0}},
+                                                  {{"SET", local_key, "first"}, {"COPY", remote_key, local_key}}));
+  Continuation cont;
+  cont.remote_values_pending = true;
+
+  // The operation on the local key runs right away then the procedure waits for the remote key
+  ASSERT_FALSE(execution->Resume(*txn, cont));
+  ASSERT_EQ(cont.pc, 1);
+  ASSERT_EQ(txn->keys(0).value_entry().new_value(), "first");
+
+  // Resuming without the remote key keeps the procedure where it is
+  ASSERT_FALSE(execution->Resume(*txn, cont));
+  ASSERT_EQ(cont.pc, 1);
+
+  ArriveRemoteKey(*txn, "remote");
+  cont.remote_values_pending = false;
+  ASSERT_TRUE(execution->Resume(*txn, cont));
+  ASSERT_NE(txn->status(), TransactionStatus::ABORTED);
+  ASSERT_EQ(txn->keys(0).value_entry().new_value(), "remote");
+
+  // Nothing is written before the commit
+  Record record;
+  ASSERT_FALSE(storage->Read(local_key, record));
+  execution->Commit(*txn);
+  ASSERT_TRUE(storage->Read(local_key, record));
+  ASSERT_EQ(record.to_string(), "remote");
+}
+
+TEST_F(KeyValueExecutionTest, SuspendMultipleTimes) {
+  unique_ptr<Transaction> txn(MakeTestTransaction(configs[0], 1000, {{local_key, KeyType::WRITE, 0}},
+                                                  {{"EQ", remote_key, "remote"},
+                                                   {"SET", local_key, "first"},
+                                                   {"EQ", remote_key, "other"},
+                                                   {"COPY", remote_key, local_key}}));
+  Continuation cont;
+  cont.remote_values_pending = true;
+  ASSERT_FALSE(execution->Resume(*txn, cont));
+  ASSERT_EQ(cont.pc, 0);
+
+  ArriveRemoteKey(*txn, "remote");
+  ASSERT_TRUE(execution->Resume(*txn, cont));
+
+  // The failed operation does not stop the later operations but aborts the txn at the end
+  ASSERT_EQ(txn->status(), TransactionStatus::ABORTED);
+  ASSERT_NE(txn->abort_reason().find("Expected value = other"), string::npos);
+  ASSERT_EQ(txn->keys(0).value_entry().new_value(), "remote");
+}
+
+TEST_F(KeyValueExecutionTest, SkipKeyOutsideOfTxn) {
+  unique_ptr<Transaction> txn(MakeTestTransaction(configs[0], 1000, {{local_key, KeyType::WRITE, 0}},
+                                                  {{"EQ", remote_key, "remote"}, {"SET", local_key, "first"}}));
+  // No more remote keys are coming so the remote key is not part of the txn
+  Continuation cont;
+  ASSERT_TRUE(execution->Resume(*txn, cont));
+  ASSERT_NE(txn->status(), TransactionStatus::ABORTED);
+  ASSERT_EQ(txn->keys(0).value_entry().new_value(), "first");
+}
@@ -2,6 +2,7 @@
 
 #include <gtest/gtest.h>
 
+#include <deque>
 #include <vector>
 
 #include "common/proto_utils.h"
@@ -144,18 +145,28 @@ class InterleaverTest : public ::testing::Test {
   }
 
   Transaction* ReceiveTxn(int i) {
-    auto req_env = slogs_[i]->ReceiveFromOutputSocket(kSchedulerChannel);
-    if (req_env == nullptr) {
-      return nullptr;
+    // The txns of a batch arrive together in a single envelope
+    if (received_txns_[i].empty()) {
+      auto req_env = slogs_[i]->ReceiveFromOutputSocket(kSchedulerChannel);
+      if (req_env == nullptr) {
+        return nullptr;
+      }
+      if (req_env->request().type_case() != internal::Request::kForwardTxnBatch) {
+        return nullptr;
+      }
+      auto txns = req_env->mutable_request()->mutable_forward_txn_batch()->mutable_txns();
+      while (!txns->empty()) {
+        received_txns_[i].push_front(txns->ReleaseLast());
+      }
     }
-    if (req_env->request().type_case() != internal::Request::kForwardTxn) {
-      return nullptr;
-    }
-    return req_env->mutable_request()->mutable_forward_txn()->release_txn();
+    auto txn = received_txns_[i].front();
+    received_txns_[i].pop_front();
+    return txn;
   }
 
   unique_ptr<Sender> senders_[4];
   unique_ptr<TestSlog> slogs_[4];
+  deque<Transaction*> received_txns_[4];
 };
 
 internal::Batch* MakeBatch(BatchId batch_id, const vector<Transaction*>& txns, TransactionType batch_type) {
@@ -269,4 +280,46 @@ TEST_F(InterleaverTest, BatchOrderBeforeBatchData) {
   }
 
   delete batch;
-}
\ No newline at end of file
+}
+
+TEST_F(InterleaverTest, BatchesReadyTogetherAreSentInOneMessage) {
+  auto expected_txn_1 = MakeTransaction({{"A"}, {"B", KeyType::WRITE}});
+  auto expected_txn_2 = MakeTransaction({{"X"}, {"Y", KeyType::WRITE}});
+  auto batch_1 = MakeBatch(100, {expected_txn_1}, SINGLE_HOME);
+  auto batch_2 = MakeBatch(200, {expected_txn_2}, SINGLE_HOME);
+
+  // The batches come from a remote replica so the data and the order arrive through the same socket
+  auto send_batch_order = [this](BatchId batch_id, SlotId slot) {
+    Envelope req;
+    auto batch_order = req.mutable_request()->mutable_forward_batch_order()->mutable_remote_batch_order();
+    batch_order->set_batch_id(batch_id);
+    batch_order->set_slot(slot);
+    batch_order->set_home(1);
+    SendToInterleaver(2, 0, req);
+  };
+  auto send_batch_data = [this](internal::Batch* batch) {
+    Envelope req;
+    auto forward_batch_data = req.mutable_request()->mutable_forward_batch_data();
+    forward_batch_data->mutable_batch_data()->Add()->CopyFrom(*batch);
+    forward_batch_data->mutable_batch_data()->Add()->CopyFrom(*batch);
+    forward_batch_data->set_home(1);
+    SendToInterleaver(2, 0, req);
+  };
+
+  // Neither batch can be emitted until the order of the first one arrives
+  send_batch_order(200, 1);
+  send_batch_data(batch_1);
+  send_batch_data(batch_2);
+  send_batch_order(100, 0);
+
+  auto req_env = slogs_[0]->ReceiveFromOutputSocket(kSchedulerChannel);
+  ASSERT_NE(req_env, nullptr);
+  ASSERT_EQ(req_env->request().type_case(), internal::Request::kForwardTxnBatch);
+  const auto& txns = req_env->request().forward_txn_batch().txns();
+  ASSERT_EQ(txns.size(), 2);
+  ASSERT_EQ(txns[0], *expected_txn_1);
+  ASSERT_EQ(txns[1], *expected_txn_2);
+
+  delete batch_1;
+  delete batch_2;
+}
@@ -0,0 +1,79 @@
+#include "module/scheduler_components/contention_profiler.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace slog;
+
+TEST(ContentionSketchTest, CountsBlockedTxnsPerKey) {
+  ContentionSketch sketch(4);
+  sketch.Record({"A", 0}, 1, 100);
+  sketch.Record({"A", 0}, 3, 300);
+  sketch.Record({"A", 1}, 2, 50);
+  sketch.Record({"B", 0}, 0, 10);
+  sketch.Record({"B", 0}, 0, 10);
+  sketch.Record({"B", 0}, 0, 10);
+
+  auto top = sketch.TopK(2);
+  ASSERT_EQ(top.size(), 2U);
+  ASSERT_EQ(top[0].key_replica, KeyReplica("B", 0));
+  ASSERT_EQ(top[0].num_blocked, 3U);
+  ASSERT_EQ(top[0].error, 0U);
+  ASSERT_EQ(top[0].total_wait_ns, 30U);
+  ASSERT_EQ(top[1].key_replica, KeyReplica("A", 0));
+  ASSERT_EQ(top[1].num_blocked, 2U);
+  ASSERT_EQ(top[1].total_queue_length, 4U);
+  ASSERT_EQ(top[1].total_wait_ns, 400U);
+}
+
+TEST(ContentionSketchTest, HotKeySurvivesEviction) {
+  ContentionSketch sketch(2);
+  for (int i = 0; i < 100; i++) {
+    sketch.Record({"hot", 0}, 1, 1);
+    sketch.Record({"cold" + to_string(i), 0}, 1, 1);
+  }
+
+  auto top = sketch.TopK(sketch.capacity());
+  ASSERT_EQ(top.size(), 2U);
+  ASSERT_EQ(top[0].key_replica, KeyReplica("hot", 0));
+  ASSERT_EQ(top[0].num_blocked, 100U);
+  ASSERT_EQ(top[0].error, 0U);
+  // The last cold key inherits the count of the key that it evicted
+  ASSERT_EQ(top[1].key_replica, KeyReplica("cold99", 0));
+  ASSERT_EQ(top[1].num_blocked - top[1].error, 1U);
+}
+
+TEST(ContentionProfilerTest, Sampling) {
+  ContentionProfiler profiler;
+  ASSERT_FALSE(profiler.is_sampled(100));
+  profiler.set_sample_rate(100);
+  for (TxnId txn_id = 0; txn_id < 1000; txn_id++) {
+    ASSERT_TRUE(profiler.is_sampled(txn_id));
+  }
+  profiler.set_sample_rate(10);
+  int num_sampled = 0;
+  for (TxnId txn_id = 0; txn_id < 10000; txn_id++) {
+    num_sampled += profiler.is_sampled(txn_id);
+  }
+  ASSERT_GT(num_sampled, 500);
+  ASSERT_LT(num_sampled, 1500);
+}
+
+TEST(ContentionProfilerTest, EndedWaitsAreCounted) {
+  ContentionProfiler profiler;
+  profiler.set_sample_rate(100);
+  profiler.StartWait(100, {"A", 0}, 2);
+  profiler.StartWait(100, {"B", 0}, 1);
+  profiler.StartWait(200, {"A", 0}, 3);
+  profiler.EndWait(100, {"A", 0});
+  profiler.EndWaits(100);
+
+  // The wait of txn 200 has not ended
+  auto top = profiler.sketch().TopK(10);
+  ASSERT_EQ(top.size(), 2U);
+  for (const auto& key : top) {
+    ASSERT_EQ(key.num_blocked, 1U);
+    ASSERT_EQ(key.total_queue_length, key.key_replica.key == "A" ? 2U : 1U);
+  }
+}
@@ -202,4 +202,69 @@ TEST_F(DDRLockManagerTest, LongChain) {
   ASSERT_THAT(result, ElementsAre(500));
 
   ASSERT_TRUE(lock_manager.ReleaseLocks(holder5.txn_id()).empty());
-}
\ No newline at end of file
+}
+
+TEST_F(DDRLockManagerTest, ResolveDeadlock) {
+  auto configs = MakeTestConfigurations("locking", 2, 1);
+  auto holder1 = MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::WRITE, 0}, {"B", KeyType::WRITE, 1}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::WRITE, 0}, {"B", KeyType::WRITE, 1}});
+
+  // The lock-only txns of region 0 and region 1 are queued in opposite orders
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(1)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(1)), AcquireLocksResult::WAITING);
+
+  // The txn with the smaller id goes first
+  ASSERT_THAT(lock_manager.ResolveDeadlocks(), ElementsAre(100));
+  ASSERT_TRUE(lock_manager.ResolveDeadlocks().empty());
+  ASSERT_THAT(lock_manager.ReleaseLocks(holder1.txn_id()), ElementsAre(200));
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder2.txn_id()).empty());
+}
+
+TEST_F(DDRLockManagerTest, TxnsAfterDeadlockWaitForIt) {
+  auto configs = MakeTestConfigurations("locking", 2, 1);
+  auto holder1 = MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::WRITE, 0}, {"B", KeyType::WRITE, 1}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::READ, 0}, {"B", KeyType::WRITE, 1}});
+  auto holder3 = MakeTestTxnHolder(configs[0], 300, {{"A", KeyType::WRITE, 0}});
+  auto holder4 = MakeTestTxnHolder(configs[0], 400, {{"B", KeyType::READ, 1}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(1)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(1)), AcquireLocksResult::WAITING);
+  // Queued behind the deadlock before it is resolved
+  ASSERT_EQ(lock_manager.AcquireLocks(holder3.lock_only_txn(0)), AcquireLocksResult::WAITING);
+
+  ASSERT_THAT(lock_manager.ResolveDeadlocks(), ElementsAre(100));
+
+  // Queued behind the deadlock after it is resolved. The last writer of B is now txn 200
+  ASSERT_EQ(lock_manager.AcquireLocks(holder4.lock_only_txn(1)), AcquireLocksResult::WAITING);
+
+  ASSERT_THAT(lock_manager.ReleaseLocks(holder1.txn_id()), ElementsAre(200));
+  ASSERT_THAT(lock_manager.ReleaseLocks(holder2.txn_id()), UnorderedElementsAre(300, 400));
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder3.txn_id()).empty());
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder4.txn_id()).empty());
+}
+
+TEST_F(DDRLockManagerTest, CycleWaitingForOutsideTxnIsNotResolved) {
+  auto configs = MakeTestConfigurations("locking", 2, 1);
+  auto holder1 = MakeTestTxnHolder(configs[0], 100, {{"C", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::WRITE, 0}, {"B", KeyType::WRITE, 1}});
+  auto holder3 =
+      MakeTestTxnHolder(configs[0], 300, {{"A", KeyType::WRITE, 0}, {"B", KeyType::WRITE, 1}, {"C", KeyType::READ, 0}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder3.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder3.lock_only_txn(1)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(1)), AcquireLocksResult::WAITING);
+
+  // Txn 300 also waits for txn 100, which is running
+  ASSERT_TRUE(lock_manager.ResolveDeadlocks().empty());
+
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder1.txn_id()).empty());
+  ASSERT_THAT(lock_manager.ResolveDeadlocks(), ElementsAre(200));
+  ASSERT_THAT(lock_manager.ReleaseLocks(holder2.txn_id()), ElementsAre(300));
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder3.txn_id()).empty());
+}
@@ -0,0 +1,245 @@
+#include "module/scheduler_components/dependency_graph_manager.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "common/proto_utils.h"
+#include "test/test_utils.h"
+
+using namespace std;
+using namespace slog;
+using testing::ElementsAre;
+using testing::UnorderedElementsAre;
+
+class DependencyGraphManagerTest : public ::testing::Test {
+ protected:
+  DependencyGraphManager lock_manager;
+};
+
+TEST_F(DependencyGraphManagerTest, GetAllLocksOnFirstTry) {
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder = MakeTestTxnHolder(
+      configs[0], 100, {{"readA", KeyType::READ, 0}, {"readB", KeyType::READ, 0}, {"writeC", KeyType::WRITE, 0}});
+  ASSERT_EQ(lock_manager.AcquireLocks(holder.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  auto result = lock_manager.ReleaseLocks(holder.txn_id());
+  ASSERT_TRUE(result.empty());
+}
+
+TEST_F(DependencyGraphManagerTest, ReadLocks) {
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder1 = MakeTestTxnHolder(configs[0], 100, {{"readA", KeyType::READ, 0}, {"readB", KeyType::READ, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"readB", KeyType::READ, 0}, {"readC", KeyType::READ, 0}});
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder1.txn_id()).empty());
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder2.txn_id()).empty());
+}
+
+TEST_F(DependencyGraphManagerTest, WriteLocks) {
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder1 = MakeTestTxnHolder(configs[0], 100, {{"writeA", KeyType::WRITE, 0}, {"writeB", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"readA", KeyType::READ, 0}, {"writeA", KeyType::WRITE, 0}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  // The blocked txn becomes ready
+  ASSERT_EQ(lock_manager.ReleaseLocks(holder1.txn_id()).size(), 1U);
+  // Make sure the lock is already held by holder2
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::WAITING);
+}
+
+TEST_F(DependencyGraphManagerTest, ReleaseLocksAndReturnMultipleNewLockHolders) {
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder1 =
+      MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::READ, 0}, {"B", KeyType::WRITE, 0}, {"C", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"B", KeyType::READ, 0}, {"A", KeyType::WRITE, 0}});
+  auto holder3 = MakeTestTxnHolder(configs[0], 300, {{"A", KeyType::WRITE, 0}});
+  auto holder4 = MakeTestTxnHolder(configs[0], 400, {{"C", KeyType::READ, 0}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder3.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder4.lock_only_txn(0)), AcquireLocksResult::WAITING);
+
+  auto result = lock_manager.ReleaseLocks(holder1.txn_id());
+  ASSERT_EQ(result.size(), 2U);
+  ASSERT_TRUE(find(result.begin(), result.end(), 200) != result.end());
+  ASSERT_TRUE(find(result.begin(), result.end(), 400) != result.end());
+
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder4.txn_id()).empty());
+
+  result = lock_manager.ReleaseLocks(holder2.txn_id());
+  ASSERT_THAT(result, ElementsAre(300));
+
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder3.txn_id()).empty());
+}
+
+TEST_F(DependencyGraphManagerTest, PartiallyAcquiredLocks) {
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder1 =
+      MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::READ, 0}, {"B", KeyType::WRITE, 0}, {"C", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::READ, 0}, {"B", KeyType::WRITE, 0}});
+  auto holder3 = MakeTestTxnHolder(configs[0], 300, {{"A", KeyType::WRITE, 0}, {"C", KeyType::WRITE, 0}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder3.lock_only_txn(0)), AcquireLocksResult::WAITING);
+
+  auto result = lock_manager.ReleaseLocks(holder1.txn_id());
+  ASSERT_THAT(result, ElementsAre(200));
+
+  result = lock_manager.ReleaseLocks(holder2.txn_id());
+  ASSERT_THAT(result, ElementsAre(300));
+}
+
+TEST_F(DependencyGraphManagerTest, AcquireLocksWithLockOnly1) {
+  auto configs = MakeTestConfigurations("locking", 2, 1);
+  auto holder1 =
+      MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::READ, 0}, {"B", KeyType::WRITE, 0}, {"C", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::READ, 1}, {"B", KeyType::WRITE, 0}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(1)), AcquireLocksResult::ACQUIRED);
+
+  auto result = lock_manager.ReleaseLocks(holder2.txn_id());
+  ASSERT_THAT(result, ElementsAre(100));
+}
+
+TEST_F(DependencyGraphManagerTest, AcquireLocksWithLockOnly2) {
+  auto configs = MakeTestConfigurations("locking", 2, 1);
+  auto holder1 =
+      MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::READ, 0}, {"B", KeyType::WRITE, 0}, {"C", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::READ, 1}, {"B", KeyType::WRITE, 0}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(1)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::WAITING);
+
+  auto result = lock_manager.ReleaseLocks(holder1.txn_id());
+  ASSERT_THAT(result, ElementsAre(200));
+}
+
+TEST_F(DependencyGraphManagerTest, MultiEdgeBetweenTwoTxns) {
+  auto configs = MakeTestConfigurations("locking", 3, 1);
+  auto holder1 = MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::WRITE, 1}, {"B", KeyType::WRITE, 2}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::READ, 1}, {"B", KeyType::READ, 2}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(1)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(2)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(1)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(2)), AcquireLocksResult::WAITING);
+
+  auto result = lock_manager.ReleaseLocks(holder1.txn_id());
+  ASSERT_THAT(result, ElementsAre(200));
+
+  result = lock_manager.ReleaseLocks(holder2.txn_id());
+  ASSERT_TRUE(result.empty());
+}
+
+TEST_F(DependencyGraphManagerTest, KeyReplicaLocks) {
+  auto configs = MakeTestConfigurations("locking", 3, 1);
+  auto holder1 = MakeTestTxnHolder(configs[0], 100, {{"writeA", KeyType::WRITE, 2}, {"writeB", KeyType::WRITE, 2}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"readA", KeyType::READ, 1}, {"writeA", KeyType::WRITE, 1}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(2)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(1)), AcquireLocksResult::ACQUIRED);
+}
+
+#ifdef REMASTER_PROTOCOL_COUNTERLESS
+TEST_F(DependencyGraphManagerTest, RemasterTxn) {
+  auto configs = MakeTestConfigurations("locking", 3, 1);
+  auto holder = MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::WRITE, 2}}, {}, 1 /* new_master */);
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder.lock_only_txn(1)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder.lock_only_txn(2)), AcquireLocksResult::ACQUIRED);
+  lock_manager.ReleaseLocks(holder.txn_id());
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder.lock_only_txn(2)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder.lock_only_txn(1)), AcquireLocksResult::ACQUIRED);
+  lock_manager.ReleaseLocks(holder.txn_id());
+}
+#endif
+
+TEST_F(DependencyGraphManagerTest, EnsureStateIsClean) {
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder1 =
+      MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::READ, 0}, {"B", KeyType::WRITE, 0}, {"C", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"B", KeyType::READ, 0}, {"A", KeyType::WRITE, 0}});
+  auto holder3 = MakeTestTxnHolder(configs[0], 300, {{"C", KeyType::WRITE, 0}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder1.txn_id()).empty());
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder3.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder2.txn_id()).empty());
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder3.txn_id()).empty());
+}
+
+TEST_F(DependencyGraphManagerTest, LongChain) {
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder1 = MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::READ, 0}});
+  auto holder3 = MakeTestTxnHolder(configs[0], 300, {{"A", KeyType::READ, 0}});
+  auto holder4 = MakeTestTxnHolder(configs[0], 400, {{"A", KeyType::WRITE, 0}});
+  auto holder5 = MakeTestTxnHolder(configs[0], 500, {{"A", KeyType::READ, 0}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder3.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder4.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder5.lock_only_txn(0)), AcquireLocksResult::WAITING);
+
+  auto result = lock_manager.ReleaseLocks(holder1.txn_id());
+  ASSERT_THAT(result, UnorderedElementsAre(200, 300));
+
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder2.txn_id()).empty());
+  result = lock_manager.ReleaseLocks(holder3.txn_id());
+  ASSERT_THAT(result, ElementsAre(400));
+
+  result = lock_manager.ReleaseLocks(holder4.txn_id());
+  ASSERT_THAT(result, ElementsAre(500));
+
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder5.txn_id()).empty());
+}
+
+TEST_F(DependencyGraphManagerTest, Batch) {
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder1 = MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::READ, 0}, {"B", KeyType::WRITE, 0}});
+  auto holder3 = MakeTestTxnHolder(configs[0], 300, {{"C", KeyType::READ, 0}});
+  auto holder4 = MakeTestTxnHolder(configs[0], 400, {{"B", KeyType::READ, 0}, {"C", KeyType::WRITE, 0}});
+  auto holder5 = MakeTestTxnHolder(configs[0], 500, {{"D", KeyType::WRITE, 0}});
+
+  vector<TxnId> ready;
+  lock_manager.AcquireLocks({&holder1.lock_only_txn(0), &holder2.lock_only_txn(0), &holder3.lock_only_txn(0)}, ready);
+  ASSERT_THAT(ready, ElementsAre(100, 300));
+
+  // The second batch depends on the txns of the first batch through the access table
+  ready.clear();
+  lock_manager.AcquireLocks({&holder4.lock_only_txn(0), &holder5.lock_only_txn(0)}, ready);
+  ASSERT_THAT(ready, ElementsAre(500));
+
+  ASSERT_THAT(lock_manager.ReleaseLocks(holder1.txn_id()), ElementsAre(200));
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder3.txn_id()).empty());
+  ASSERT_THAT(lock_manager.ReleaseLocks(holder2.txn_id()), ElementsAre(400));
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder4.txn_id()).empty());
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder5.txn_id()).empty());
+}
+
+TEST_F(DependencyGraphManagerTest, FinishedTxnsArePruned) {
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder1 = MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::READ, 0}});
+  auto holder3 = MakeTestTxnHolder(configs[0], 300, {{"A", KeyType::WRITE, 0}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_THAT(lock_manager.ReleaseLocks(holder1.txn_id()), ElementsAre(200));
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder2.txn_id()).empty());
+
+  // Nothing is left to wait for once the earlier txns finish
+  ASSERT_EQ(lock_manager.AcquireLocks(holder3.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder3.txn_id()).empty());
+}
@@ -0,0 +1,168 @@
+#include "module/scheduler_components/multi_version_manager.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "common/proto_utils.h"
+#include "storage/mem_only_storage.h"
+#include "test/test_utils.h"
+
+using namespace std;
+using namespace slog;
+using testing::ElementsAre;
+using testing::IsEmpty;
+using testing::UnorderedElementsAre;
+
+class MultiVersionManagerTest : public ::testing::Test {
+ protected:
+  MultiVersionManager lock_manager;
+};
+
+TEST_F(MultiVersionManagerTest, GetAllLocksOnFirstTry) {
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder = MakeTestTxnHolder(
+      configs[0], 100, {{"readA", KeyType::READ, 0}, {"readB", KeyType::READ, 0}, {"writeC", KeyType::WRITE, 0}});
+  ASSERT_EQ(lock_manager.AcquireLocks(holder.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  auto result = lock_manager.ReleaseLocks(holder.txn_id());
+  ASSERT_TRUE(result.empty());
+}
+
+TEST_F(MultiVersionManagerTest, ReadersWaitForEarlierWriter) {
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder1 = MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::READ, 0}});
+  auto holder3 = MakeTestTxnHolder(configs[0], 300, {{"A", KeyType::READ, 0}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder3.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_THAT(lock_manager.ReleaseLocks(holder1.txn_id()), UnorderedElementsAre(200, 300));
+}
+
+TEST_F(MultiVersionManagerTest, WritersDoNotWaitForEarlierReaders) {
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder1 = MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::READ, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::READ, 0}});
+  auto holder3 = MakeTestTxnHolder(configs[0], 300, {{"A", KeyType::WRITE, 0}});
+  auto holder4 = MakeTestTxnHolder(configs[0], 400, {{"A", KeyType::READ, 0}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder3.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder4.lock_only_txn(0)), AcquireLocksResult::WAITING);
+
+  VersionSet versions1, versions2, versions3;
+  lock_manager.TakeVersions(holder1.txn_id(), versions1);
+  lock_manager.TakeVersions(holder2.txn_id(), versions2);
+  lock_manager.TakeVersions(holder3.txn_id(), versions3);
+
+  // The readers share the version that the writer captures
+  ASSERT_EQ(versions1.reads.size(), 1U);
+  ASSERT_EQ(versions2.reads.size(), 1U);
+  ASSERT_THAT(versions3.reads, IsEmpty());
+  ASSERT_EQ(versions3.captures.size(), 1U);
+  ASSERT_EQ(versions1.reads[0].first, "A");
+  ASSERT_EQ(versions1.reads[0].second, versions2.reads[0].second);
+  ASSERT_EQ(versions1.reads[0].second, versions3.captures[0].second);
+
+  // The writer finishes before the earlier readers
+  ASSERT_THAT(lock_manager.ReleaseLocks(holder3.txn_id()), ElementsAre(400));
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder1.txn_id()).empty());
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder2.txn_id()).empty());
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder4.txn_id()).empty());
+}
+
+TEST_F(MultiVersionManagerTest, WritersWaitForPreviousWriter) {
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder1 = MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::WRITE, 0}, {"B", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::WRITE, 0}});
+  auto holder3 = MakeTestTxnHolder(configs[0], 300, {{"A", KeyType::WRITE, 0}, {"B", KeyType::WRITE, 0}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder3.lock_only_txn(0)), AcquireLocksResult::WAITING);
+
+  // No version is captured when nobody reads it
+  VersionSet versions;
+  lock_manager.TakeVersions(holder2.txn_id(), versions);
+  ASSERT_THAT(versions.captures, IsEmpty());
+
+  ASSERT_THAT(lock_manager.ReleaseLocks(holder1.txn_id()), ElementsAre(200));
+  ASSERT_THAT(lock_manager.ReleaseLocks(holder2.txn_id()), ElementsAre(300));
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder3.txn_id()).empty());
+}
+
+TEST_F(MultiVersionManagerTest, AcquireLocksWithLockOnly) {
+  auto configs = MakeTestConfigurations("locking", 2, 1);
+  auto holder1 =
+      MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::READ, 0}, {"B", KeyType::WRITE, 0}, {"C", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::READ, 1}, {"B", KeyType::WRITE, 0}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(1)), AcquireLocksResult::ACQUIRED);
+
+  auto result = lock_manager.ReleaseLocks(holder2.txn_id());
+  ASSERT_THAT(result, ElementsAre(100));
+}
+
+TEST_F(MultiVersionManagerTest, MultiEdgeBetweenTwoTxns) {
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder1 = MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::WRITE, 0}, {"B", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::READ, 0}, {"B", KeyType::WRITE, 0}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::WAITING);
+
+  ASSERT_THAT(lock_manager.ReleaseLocks(holder1.txn_id()), ElementsAre(200));
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder2.txn_id()).empty());
+}
+
+#ifdef REMASTER_PROTOCOL_COUNTERLESS
+TEST_F(MultiVersionManagerTest, RemasterTxn) {
+  auto configs = MakeTestConfigurations("locking", 3, 1);
+  auto holder = MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::WRITE, 2}}, {}, 1 /* new_master */);
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder.lock_only_txn(1)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder.lock_only_txn(2)), AcquireLocksResult::ACQUIRED);
+  lock_manager.ReleaseLocks(holder.txn_id());
+}
+#endif
+
+TEST_F(MultiVersionManagerTest, FinishedTxnsArePruned) {
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder1 = MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::READ, 0}});
+  auto holder3 = MakeTestTxnHolder(configs[0], 300, {{"A", KeyType::WRITE, 0}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_THAT(lock_manager.ReleaseLocks(holder1.txn_id()), ElementsAre(200));
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder2.txn_id()).empty());
+
+  // The version read by the finished reader is gone so there is nothing to capture
+  ASSERT_EQ(lock_manager.AcquireLocks(holder3.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  VersionSet versions;
+  lock_manager.TakeVersions(holder3.txn_id(), versions);
+  ASSERT_THAT(versions.captures, IsEmpty());
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder3.txn_id()).empty());
+}
+
+TEST(VersionTest, CapturedVersionSurvivesOverwrite) {
+  MemOnlyStorage storage;
+  storage.Write("A", Record("old", 1));
+
+  Version version, missing_version;
+  ASSERT_FALSE(version.captured());
+  version.Capture(storage, "A");
+  missing_version.Capture(storage, "B");
+  storage.Write("A", Record("new", 1));
+  storage.Write("B", Record("new", 1));
+
+  ASSERT_TRUE(version.captured());
+  ASSERT_TRUE(version.exists());
+  ASSERT_EQ(version.record().to_string(), "old");
+  ASSERT_EQ(version.record().metadata().master, 1U);
+  ASSERT_TRUE(missing_version.captured());
+  ASSERT_FALSE(missing_version.exists());
+}
@@ -3,6 +3,9 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <array>
+#include <random>
+
 #include "common/proto_utils.h"
 #include "test/test_utils.h"
 
@@ -68,6 +71,44 @@ TEST(RMALockManagerTest, ReleaseLocksAndGetMultipleNewLockHolders) {
   ASSERT_THAT(result, UnorderedElementsAre(200, 400));
 }
 
+TEST(RMALockManagerTest, ReleaseReadLocksEarly) {
+  RMALockManager lock_manager;
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder1 =
+      MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::READ, 0}, {"B", KeyType::READ, 0}, {"C", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::WRITE, 0}});
+  auto holder3 = MakeTestTxnHolder(configs[0], 300, {{"B", KeyType::READ, 0}, {"C", KeyType::READ, 0}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder3.lock_only_txn(0)), AcquireLocksResult::WAITING);
+
+  // The writer of A no longer waits for the reader but the reader of C still waits for the writer
+  ASSERT_THAT(lock_manager.ReleaseReadLocks(holder1.txn_id()), ElementsAre(200));
+  ASSERT_THAT(lock_manager.ReleaseLocks(holder1.txn_id()), ElementsAre(300));
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder2.txn_id()).empty());
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder3.txn_id()).empty());
+}
+
+TEST(RMALockManagerTest, ReleaseReadLocksOfReadOnlyTxn) {
+  RMALockManager lock_manager;
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder1 = MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::READ, 0}, {"B", KeyType::READ, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::WRITE, 0}, {"B", KeyType::WRITE, 0}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_THAT(lock_manager.ReleaseReadLocks(holder1.txn_id()), ElementsAre(200));
+  // The released locks are recycled and reused by other keys without affecting the released txn
+  auto holder3 = MakeTestTxnHolder(configs[0], 300, {{"D", KeyType::WRITE, 0}});
+  ASSERT_EQ(lock_manager.AcquireLocks(holder3.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder1.txn_id()).empty());
+  auto holder4 = MakeTestTxnHolder(configs[0], 400, {{"A", KeyType::READ, 0}, {"D", KeyType::READ, 0}});
+  ASSERT_EQ(lock_manager.AcquireLocks(holder4.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder3.txn_id()).empty());
+  ASSERT_THAT(lock_manager.ReleaseLocks(holder2.txn_id()), ElementsAre(400));
+}
+
 TEST(RMALockManagerTest, PartiallyAcquiredLocks) {
   RMALockManager lock_manager;
   auto configs = MakeTestConfigurations("locking", 1, 1);
@@ -127,6 +168,127 @@ TEST(RMALockManagerTest, KeyReplicaLocks) {
   ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(1)), AcquireLocksResult::ACQUIRED);
 }
 
+TEST(RMALockManagerTest, SimilarKeyReplicasDoNotConflict) {
+  RMALockManager lock_manager;
+  auto configs = MakeTestConfigurations("locking", 2, 1);
+  auto holder1 = MakeTestTxnHolder(configs[0], 100, {{"A:1", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::WRITE, 1}});
+  auto holder3 = MakeTestTxnHolder(configs[0], 300, {{"A:1", KeyType::WRITE, 0}});
+
+  ASSERT_EQ(lock_manager.AcquireLocks(holder1.lock_only_txn(0)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder2.lock_only_txn(1)), AcquireLocksResult::ACQUIRED);
+  ASSERT_EQ(lock_manager.AcquireLocks(holder3.lock_only_txn(0)), AcquireLocksResult::WAITING);
+
+  ASSERT_TRUE(lock_manager.ReleaseLocks(holder2.txn_id()).empty());
+  ASSERT_THAT(lock_manager.ReleaseLocks(holder1.txn_id()), ElementsAre(300));
+}
+
+TEST(RMALockManagerTest, LockTableGrowsAndRecyclesEntries) {
+  LockTable lock_table(4);
+  vector<LockTable::EntryId> ids;
+  for (int i = 0; i < 100; i++) {
+    ids.push_back(lock_table.FindOrInsert(to_string(i), i % 2));
+  }
+  ASSERT_EQ(lock_table.size(), 100);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(lock_table.FindOrInsert(to_string(i), i % 2), ids[i]);
+    ASSERT_EQ(lock_table.key_replica(ids[i]).key, to_string(i));
+  }
+  // Same key but different replica
+  ASSERT_NE(lock_table.FindOrInsert("0", 1), ids[0]);
+
+  for (int i = 0; i < 100; i += 2) {
+    lock_table.Erase(ids[i]);
+  }
+  ASSERT_EQ(lock_table.size(), 51);
+  // The remaining keys are still found after the holes left by the erased keys are filled
+  for (int i = 1; i < 100; i += 2) {
+    ASSERT_EQ(lock_table.FindOrInsert(to_string(i), 1), ids[i]);
+  }
+  // New keys reuse the erased entries
+  auto new_id = lock_table.FindOrInsert("new", 0);
+  ASSERT_LT(new_id, 101);
+  ASSERT_EQ(lock_table.key_replica(new_id).key, "new");
+}
+
+TEST(RMALockManagerTest, LongWaitQueue) {
+  RMALockManager lock_manager;
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  vector<TxnHolder> holders;
+  for (int i = 1; i <= 20; i++) {
+    holders.push_back(MakeTestTxnHolder(configs[0], i, {{"A", i % 3 == 0 ? KeyType::WRITE : KeyType::READ, 0}}));
+  }
+  vector<TxnId> acquired;
+  for (auto& holder : holders) {
+    if (lock_manager.AcquireLocks(holder.lock_only_txn(0)) == AcquireLocksResult::ACQUIRED) {
+      acquired.push_back(holder.txn_id());
+    }
+  }
+  ASSERT_THAT(acquired, ElementsAre(1, 2));
+
+  // Txns get the lock in the order they requested it
+  vector<TxnId> order(acquired);
+  for (size_t i = 0; i < order.size(); i++) {
+    auto result = lock_manager.ReleaseLocks(order[i]);
+    order.insert(order.end(), result.begin(), result.end());
+  }
+  vector<TxnId> expected;
+  for (int i = 1; i <= 20; i++) {
+    expected.push_back(i);
+  }
+  ASSERT_EQ(order, expected);
+}
+
+TEST(RMALockManagerTest, BatchAcquisitionMatchesSequentialAcquisition) {
+  auto configs = MakeTestConfigurations("locking", 2, 1);
+  std::mt19937 rg(0);
+  vector<TxnHolder> holders;
+  vector<array<bool, 2>> has_home;
+  for (int i = 1; i <= 200; i++) {
+    vector<KeyMetadata> keys;
+    array<bool, 2> homes{false, false};
+    for (int k : {rg() % 20, 20 + rg() % 20, 40 + rg() % 20}) {
+      auto home = rg() % 2;
+      keys.emplace_back("key" + to_string(k), rg() % 2 ? KeyType::WRITE : KeyType::READ, home);
+      homes[home] = true;
+    }
+    holders.push_back(MakeTestTxnHolder(configs[0], i, keys));
+    has_home.push_back(homes);
+  }
+
+  RMALockManager sequential, batched;
+  vector<TxnId> ready;
+  for (int batch_start = 0; batch_start < 200; batch_start += 25) {
+    // Each batch holds the lock-only txns of one home
+    for (int home = 0; home < 2; home++) {
+      vector<Transaction*> batch;
+      vector<TxnId> sequential_ready, batched_ready;
+      for (int i = batch_start; i < batch_start + 25; i++) {
+        if (!has_home[i][home]) {
+          continue;
+        }
+        auto& lo_txn = holders[i].lock_only_txn(home);
+        batch.push_back(&lo_txn);
+        if (sequential.AcquireLocks(lo_txn) == AcquireLocksResult::ACQUIRED) {
+          sequential_ready.push_back(lo_txn.internal().id());
+        }
+      }
+      batched.AcquireLocks(batch, batched_ready);
+      ASSERT_EQ(sequential_ready, batched_ready);
+      ready.insert(ready.end(), sequential_ready.begin(), sequential_ready.end());
+    }
+
+    // Release the ready txns in both lock managers
+    while (!ready.empty()) {
+      auto txn_id = ready.back();
+      ready.pop_back();
+      auto unblocked = sequential.ReleaseLocks(txn_id);
+      ASSERT_EQ(batched.ReleaseLocks(txn_id), unblocked);
+      ready.insert(ready.end(), unblocked.begin(), unblocked.end());
+    }
+  }
+}
+
 #ifdef REMASTER_PROTOCOL_COUNTERLESS
 TEST(RMALockManagerTest, RemasterTxn) {
   RMALockManager lock_manager;
@@ -0,0 +1,149 @@
+#include "module/scheduler_components/sharded_lock_manager.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "common/proto_utils.h"
+#include "test/test_utils.h"
+
+using namespace std;
+using namespace slog;
+using testing::ElementsAre;
+using testing::UnorderedElementsAre;
+
+namespace {
+
+/**
+ * Collects ready txns until the given number of them is collected or a timeout is reached.
+ * Also collects a bit longer to catch txns that should not be ready
+ */
+vector<pair<TxnId, bool>> WaitForReadyTxns(ShardedLockManager& lock_manager, size_t num_txns) {
+  vector<pair<TxnId, bool>> ready_txns;
+  auto deadline = chrono::steady_clock::now() + 5s;
+  while (ready_txns.size() < num_txns && chrono::steady_clock::now() < deadline) {
+    lock_manager.TakeReadyTxns(ready_txns);
+    this_thread::sleep_for(1ms);
+  }
+  this_thread::sleep_for(20ms);
+  lock_manager.TakeReadyTxns(ready_txns);
+  return ready_txns;
+}
+
+vector<TxnId> WaitForReadyTxnIds(ShardedLockManager& lock_manager, size_t num_txns) {
+  vector<TxnId> txn_ids;
+  for (auto [txn_id, _] : WaitForReadyTxns(lock_manager, num_txns)) {
+    txn_ids.push_back(txn_id);
+  }
+  return txn_ids;
+}
+
+}  // namespace
+
+class ShardedLockManagerTest : public ::testing::TestWithParam<uint32_t> {
+ protected:
+  void SetUp() override { lock_manager.Start(GetParam()); }
+
+  ShardedLockManager lock_manager;
+};
+
+TEST_P(ShardedLockManagerTest, GetAllLocksOnFirstTry) {
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder = MakeTestTxnHolder(
+      configs[0], 100, {{"readA", KeyType::READ, 0}, {"readB", KeyType::READ, 0}, {"writeC", KeyType::WRITE, 0}});
+  ASSERT_EQ(lock_manager.AcquireLocks(holder.lock_only_txn(0)), AcquireLocksResult::WAITING);
+  ASSERT_THAT(WaitForReadyTxns(lock_manager, 1), ElementsAre(make_pair(100, true)));
+  lock_manager.ReleaseLocks(holder.txn_id());
+  ASSERT_TRUE(WaitForReadyTxns(lock_manager, 0).empty());
+}
+
+TEST_P(ShardedLockManagerTest, WriteLocks) {
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder1 = MakeTestTxnHolder(configs[0], 100, {{"writeA", KeyType::WRITE, 0}, {"writeB", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"readA", KeyType::READ, 0}, {"writeA", KeyType::WRITE, 0}});
+
+  lock_manager.AcquireLocks(holder1.lock_only_txn(0));
+  lock_manager.AcquireLocks(holder2.lock_only_txn(0));
+  ASSERT_THAT(WaitForReadyTxns(lock_manager, 1), ElementsAre(make_pair(100, true)));
+  // The blocked txn becomes ready
+  lock_manager.ReleaseLocks(holder1.txn_id());
+  ASSERT_THAT(WaitForReadyTxns(lock_manager, 1), ElementsAre(make_pair(200, false)));
+  // Make sure the lock is already held by holder2
+  lock_manager.AcquireLocks(holder1.lock_only_txn(0));
+  ASSERT_TRUE(WaitForReadyTxns(lock_manager, 0).empty());
+}
+
+TEST_P(ShardedLockManagerTest, ReleaseLocksAndGetMultipleNewLockHolders) {
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  auto holder1 =
+      MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::READ, 0}, {"B", KeyType::WRITE, 0}, {"C", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"B", KeyType::READ, 0}, {"A", KeyType::WRITE, 0}});
+  auto holder3 = MakeTestTxnHolder(configs[0], 300, {{"B", KeyType::READ, 0}});
+  auto holder4 = MakeTestTxnHolder(configs[0], 400, {{"C", KeyType::READ, 0}});
+
+  lock_manager.AcquireLocks(holder1.lock_only_txn(0));
+  lock_manager.AcquireLocks(holder2.lock_only_txn(0));
+  lock_manager.AcquireLocks(holder3.lock_only_txn(0));
+  lock_manager.AcquireLocks(holder4.lock_only_txn(0));
+  ASSERT_THAT(WaitForReadyTxnIds(lock_manager, 1), ElementsAre(100));
+
+  lock_manager.ReleaseLocks(holder3.txn_id());
+  lock_manager.ReleaseLocks(holder1.txn_id());
+  // Txn 300 was removed from the wait list due to the
+  // ReleaseLocks call above
+  ASSERT_THAT(WaitForReadyTxnIds(lock_manager, 2), UnorderedElementsAre(200, 400));
+}
+
+TEST_P(ShardedLockManagerTest, AcquireLocksWithLockOnly) {
+  auto configs = MakeTestConfigurations("locking", 2, 1);
+  auto holder1 =
+      MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::READ, 0}, {"B", KeyType::WRITE, 0}, {"C", KeyType::WRITE, 0}});
+  auto holder2 = MakeTestTxnHolder(configs[0], 200, {{"A", KeyType::READ, 1}, {"B", KeyType::WRITE, 0}});
+
+  lock_manager.AcquireLocks(holder2.lock_only_txn(0));
+  lock_manager.AcquireLocks(holder1.lock_only_txn(0));
+  ASSERT_TRUE(WaitForReadyTxns(lock_manager, 0).empty());
+  lock_manager.AcquireLocks(holder2.lock_only_txn(1));
+  ASSERT_THAT(WaitForReadyTxns(lock_manager, 1), ElementsAre(make_pair(200, true)));
+
+  lock_manager.ReleaseLocks(holder2.txn_id());
+  ASSERT_THAT(WaitForReadyTxns(lock_manager, 1), ElementsAre(make_pair(100, false)));
+}
+
+TEST_P(ShardedLockManagerTest, LocksAreGrantedInRequestOrder) {
+  auto configs = MakeTestConfigurations("locking", 1, 1);
+  vector<TxnHolder> holders;
+  for (int i = 1; i <= 50; i++) {
+    // Every txn conflicts with the previous one on a key that may be in a different shard
+    holders.push_back(MakeTestTxnHolder(configs[0], i,
+                                        {{"key" + to_string(i - 1), KeyType::WRITE, 0},
+                                         {"key" + to_string(i), KeyType::WRITE, 0},
+                                         {"shared", i % 5 == 0 ? KeyType::WRITE : KeyType::READ, 0}}));
+  }
+  for (auto& holder : holders) {
+    lock_manager.AcquireLocks(holder.lock_only_txn(0));
+  }
+
+  // Txns get the locks one by one in the order they requested them
+  for (int i = 1; i <= 50; i++) {
+    ASSERT_THAT(WaitForReadyTxnIds(lock_manager, 1), ElementsAre(i));
+    lock_manager.ReleaseLocks(i);
+  }
+}
+
+#ifdef REMASTER_PROTOCOL_COUNTERLESS
+TEST_P(ShardedLockManagerTest, RemasterTxn) {
+  auto configs = MakeTestConfigurations("locking", 3, 1);
+  auto holder = MakeTestTxnHolder(configs[0], 100, {{"A", KeyType::WRITE, 2}}, {}, 1 /* new_master */);
+
+  lock_manager.AcquireLocks(holder.lock_only_txn(1));
+  ASSERT_TRUE(WaitForReadyTxns(lock_manager, 0).empty());
+  lock_manager.AcquireLocks(holder.lock_only_txn(2));
+  ASSERT_THAT(WaitForReadyTxnIds(lock_manager, 1), ElementsAre(100));
+  lock_manager.ReleaseLocks(holder.txn_id());
+}
+#endif
+
+INSTANTIATE_TEST_SUITE_P(AllShards, ShardedLockManagerTest, testing::Values(1, 4));
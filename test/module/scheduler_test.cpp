@@ -69,6 +69,25 @@ class SchedulerTest : public ::testing::Test {
     }
   }
 
+  // Sends the txns to each of their partitions in a single batch, as the interleaver does with the
+  // batches of different logs that become ready together
+  void SendTransactionBatch(const vector<Transaction*>& txns) {
+    auto sharder = Sharder::MakeSharder(test_slogs[0]->config());
+    for (uint32_t p = 0; p < kNumPartitions; p++) {
+      internal::Envelope env;
+      auto batch = env.mutable_request()->mutable_forward_txn_batch();
+      for (auto txn : txns) {
+        auto new_txn = GeneratePartitionedTxn(sharder, txn, p);
+        if (new_txn != nullptr) {
+          batch->mutable_txns()->AddAllocated(new_txn);
+        }
+      }
+      if (!batch->txns().empty()) {
+        sender[0]->Send(env, p, kSchedulerChannel);
+      }
+    }
+  }
+
   Transaction ReceiveMultipleAndMerge(uint32_t receiver, uint32_t num_partitions) {
     Transaction txn;
     bool first_time = true;
@@ -235,6 +254,34 @@ TEST_F(SchedulerTest, SimpleMultiHomeBatch) {
   ASSERT_EQ(TxnValueEntry(output_txn, "Z").new_value(), "newZ");
 }
 
+TEST_F(SchedulerTest, MultiHomeLockOnlyTxnsInOneBatch) {
+  auto txn = MakeTestTransaction(test_slogs[0]->config(), 1000,
+                                 {{"A", KeyType::READ, {{0, 1}}},
+                                  {"X", KeyType::READ, {{1, 1}}},
+                                  {"B", KeyType::WRITE, {{0, 1}}},
+                                  {"Z", KeyType::WRITE, {{1, 1}}}},
+                                 {{"GET", "A"}, {"GET", "X"}, {"SET", "B", "newB"}, {"SET", "Z", "newZ"}});
+
+  auto lo_txn_0 = GenerateLockOnlyTxn(txn, 0);
+  auto lo_txn_1 = GenerateLockOnlyTxn(txn, 1);
+
+  delete txn;
+
+  // Both lock-only txns arrive in the same batch
+  SendTransactionBatch({lo_txn_0, lo_txn_1});
+  delete lo_txn_0;
+  delete lo_txn_1;
+
+  auto output_txn = ReceiveMultipleAndMerge(0, 3);
+  LOG(INFO) << output_txn;
+  ASSERT_EQ(output_txn.status(), TransactionStatus::COMMITTED);
+  ASSERT_EQ(output_txn.keys_size(), 4);
+  ASSERT_EQ(TxnValueEntry(output_txn, "A").value(), "valueA");
+  ASSERT_EQ(TxnValueEntry(output_txn, "X").value(), "valueX");
+  ASSERT_EQ(TxnValueEntry(output_txn, "B").new_value(), "newB");
+  ASSERT_EQ(TxnValueEntry(output_txn, "Z").new_value(), "newZ");
+}
+
 TEST_F(SchedulerTest, SinglePartitionTransactionValidateMasters) {
   auto txn = MakeTestTransaction(test_slogs[0]->config(), 1000,
                                  {{"A", KeyType::READ, {{0, 1}}}, {"D", KeyType::WRITE, {{0, 1}}}},
@@ -0,0 +1,221 @@
+#include "storage/log_storage.h"
+
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace slog;
+using namespace std::chrono;
+
+class LogStorageTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char dir_template[] = "/tmp/log_storage_test_XXXXXX";
+    ASSERT_NE(mkdtemp(dir_template), nullptr);
+    dir_ = dir_template;
+  }
+
+  void TearDown() override { ASSERT_EQ(system(("rm -rf " + dir_).c_str()), 0); }
+
+  std::unique_ptr<LogStorage> Open(uint64_t compaction_bytes = 1 << 30) {
+    return std::make_unique<LogStorage>(dir_, microseconds(100), compaction_bytes);
+  }
+
+  std::string dir_;
+};
+
+TEST_F(LogStorageTest, ReadWriteTest) {
+  auto storage = Open();
+  ASSERT_EQ(storage->num_recovered_entries(), 0U);
+  ASSERT_FALSE(storage->Write("A", Record("valueA", 1, 2)));
+  ASSERT_TRUE(storage->Write("A", Record("valueA2", 1, 3)));
+
+  Record record;
+  ASSERT_TRUE(storage->Read("A", record));
+  ASSERT_EQ(record.to_string(), "valueA2");
+  Metadata metadata;
+  ASSERT_TRUE(storage->GetMasterMetadata("A", metadata));
+  ASSERT_EQ(metadata.counter, 3U);
+}
+
+TEST_F(LogStorageTest, RecoverTest) {
+  {
+    auto storage = Open();
+    storage->Write("A", Record("valueA", 1));
+    storage->Write("B", Record("valueB", 2));
+    storage->Write("C", Record("valueC", 3));
+    storage->Delete("B");
+
+    std::vector<Key> keys{"C", "D"};
+    std::vector<const Key*> key_ptrs{&keys[0], &keys[1]};
+    std::vector<Record> records;
+    records.emplace_back("valueC2", 3, 1);
+    records.emplace_back("valueD", 4);
+    storage->MultiWrite(key_ptrs, records);
+  }
+
+  auto storage = Open();
+  ASSERT_EQ(storage->num_recovered_entries(), 6U);
+  Record record;
+  ASSERT_TRUE(storage->Read("A", record));
+  ASSERT_EQ(record.to_string(), "valueA");
+  ASSERT_FALSE(storage->Read("B", record));
+  ASSERT_TRUE(storage->Read("C", record));
+  ASSERT_EQ(record.to_string(), "valueC2");
+  ASSERT_EQ(record.metadata().counter, 1U);
+  ASSERT_TRUE(storage->Read("D", record));
+  ASSERT_EQ(record.metadata().master, 4U);
+}
+
+TEST_F(LogStorageTest, IgnoreTornEntry) {
+  {
+    auto storage = Open();
+    storage->Write("A", Record("valueA", 1));
+    storage->Write("B", Record("valueB", 2));
+  }
+  // Cut the last entry in half
+  auto log = dir_ + "/wal-1.log";
+  struct stat st;
+  ASSERT_EQ(stat(log.c_str(), &st), 0);
+  ASSERT_EQ(truncate(log.c_str(), st.st_size - 5), 0);
+
+  auto storage = Open();
+  ASSERT_EQ(storage->num_recovered_entries(), 1U);
+  Record record;
+  ASSERT_TRUE(storage->Read("A", record));
+  ASSERT_FALSE(storage->Read("B", record));
+}
+
+TEST_F(LogStorageTest, IgnoreTornBatch) {
+  {
+    auto storage = Open();
+    storage->Write("A", Record("valueA", 1));
+
+    std::vector<Key> keys{"B", "C"};
+    std::vector<const Key*> key_ptrs{&keys[0], &keys[1]};
+    std::vector<Record> records;
+    records.emplace_back("valueB", 2);
+    records.emplace_back("valueC", 3);
+    Key deleted_key = "A";
+    storage->WriteBatch(key_ptrs, records, {&deleted_key});
+  }
+  // Cut the last entry of the batch in half
+  auto log = dir_ + "/wal-1.log";
+  struct stat st;
+  ASSERT_EQ(stat(log.c_str(), &st), 0);
+  ASSERT_EQ(truncate(log.c_str(), st.st_size - 5), 0);
+
+  // None of the writes in the batch is recovered
+  auto storage = Open();
+  ASSERT_EQ(storage->num_recovered_entries(), 1U);
+  Record record;
+  ASSERT_TRUE(storage->Read("A", record));
+  ASSERT_FALSE(storage->Read("B", record));
+  ASSERT_FALSE(storage->Read("C", record));
+}
+
+TEST_F(LogStorageTest, LoadCompleteMarker) {
+  {
+    auto storage = Open();
+    ASSERT_FALSE(storage->load_complete());
+    storage->Write("A", Record("valueA", 1));
+  }
+  {
+    // The load was interrupted before being marked as complete
+    auto storage = Open();
+    ASSERT_EQ(storage->num_recovered_entries(), 1U);
+    ASSERT_FALSE(storage->load_complete());
+    storage->Write("B", Record("valueB", 2));
+    storage->MarkLoadComplete();
+  }
+  auto storage = Open();
+  ASSERT_EQ(storage->num_recovered_entries(), 2U);
+  ASSERT_TRUE(storage->load_complete());
+}
+
+TEST_F(LogStorageTest, LoadCompleteMarkerSurvivesCompaction) {
+  {
+    auto storage = Open(1000);
+    storage->MarkLoadComplete();
+    // Rotate the log holding the marker several times
+    for (int i = 0; i < 200; i++) {
+      storage->Write(std::to_string(i % 10), Record("value" + std::to_string(i)));
+    }
+    std::this_thread::sleep_for(milliseconds(200));
+  }
+  auto storage = Open();
+  ASSERT_TRUE(storage->load_complete());
+}
+
+TEST_F(LogStorageTest, CompactionTest) {
+  const int kNumKeys = 100;
+  {
+    // Compact after every few writes
+    auto storage = Open(1000);
+    for (int round = 0; round < 20; round++) {
+      for (int i = 0; i < kNumKeys; i++) {
+        storage->Write(std::to_string(i), Record("value" + std::to_string(round), i));
+      }
+    }
+    storage->Delete("0");
+    // Wait for the compaction thread to catch up
+    std::this_thread::sleep_for(milliseconds(200));
+  }
+
+  auto storage = Open();
+  // Most of the 2000 writes have been compacted away
+  ASSERT_LT(storage->num_recovered_entries(), 1000U);
+  Record record;
+  ASSERT_FALSE(storage->Read("0", record));
+  for (int i = 1; i < kNumKeys; i++) {
+    ASSERT_TRUE(storage->Read(std::to_string(i), record));
+    ASSERT_EQ(record.to_string(), "value19");
+    ASSERT_EQ(record.metadata().master, static_cast<uint32_t>(i));
+  }
+}
+
+TEST_F(LogStorageTest, GroupCommit) {
+  auto storage = Open();
+  const int kNumThreads = 8;
+  const int kNumWrites = 200;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&storage, t] {
+      for (int i = 0; i < kNumWrites; i++) {
+        storage->Write(std::to_string(t) + ":" + std::to_string(i), Record("value"));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  // Concurrent writes share fsyncs
+  ASSERT_LT(storage->num_flushes(), static_cast<uint64_t>(kNumThreads * kNumWrites));
+}
+
+TEST_F(LogStorageTest, AsyncWrites) {
+  auto storage = Open();
+  storage->SetSyncWrites(false);
+  std::atomic<int> num_notifications = 0;
+  auto listener_id = storage->AddDurableListener([&num_notifications] { num_notifications++; });
+
+  storage->Write("A", Record("valueA"));
+  auto position = storage->log_position();
+  ASSERT_GT(position, 0U);
+  // The write is visible before it is durable
+  Record record;
+  ASSERT_TRUE(storage->Read("A", record));
+
+  storage->WaitUntilDurable(position);
+  ASSERT_GE(storage->durable_position(), position);
+  ASSERT_GE(num_notifications.load(), 1);
+
+  storage->RemoveDurableListener(listener_id);
+  auto notified = num_notifications.load();
+  storage->Write("B", Record("valueB"));
+  storage->Flush();
+  ASSERT_EQ(num_notifications.load(), notified);
+}
@@ -3,6 +3,7 @@
 #include <gtest/gtest.h>
 
 #include "common/types.h"
+#include "storage/flat_mem_only_storage.h"
 
 using namespace slog;
 
@@ -17,4 +18,128 @@ TEST(MemOnlyStorageTest, ReadWriteTest) {
   bool ok = storage.Read(key, ret);
   ASSERT_TRUE(ok);
   ASSERT_EQ(value, ret.to_string());
-}
\ No newline at end of file
+}
+
+TEST(MemOnlyStorageTest, ReadViewTest) {
+  MemOnlyStorage storage;
+  Key key = "key1";
+  storage.Write(key, Record("value1", 1));
+
+  RecordView view;
+  ASSERT_TRUE(storage.ReadView(key, view));
+  ASSERT_EQ(view.value(), "value1");
+  ASSERT_EQ(view.metadata().master, 1U);
+
+  // The pinned record stays intact while being overwritten or deleted
+  for (int i = 0; i < 1000; i++) {
+    storage.Write(key, Record("value" + std::to_string(i)));
+  }
+  storage.Delete(key);
+  ASSERT_EQ(view.value(), "value1");
+
+  ASSERT_FALSE(storage.ReadView(key, view));
+  ASSERT_FALSE(view.valid());
+}
+
+TEST(MemOnlyStorageTest, MultiReadWriteTest) {
+  MemOnlyStorage storage;
+  std::vector<Key> keys{"A", "B", "C"};
+  std::vector<const Key*> key_ptrs{&keys[0], &keys[1], &keys[2]};
+  std::vector<Record> records;
+  records.emplace_back("valueA", 1);
+  records.emplace_back("valueB", 2);
+  records.emplace_back("valueC", 3);
+  storage.MultiWrite(key_ptrs, records);
+
+  Key missing = "D";
+  key_ptrs.push_back(&missing);
+  std::vector<std::string> values;
+  storage.MultiRead(key_ptrs, [&](size_t i, const RecordView& view) {
+    if (i < 3) {
+      EXPECT_TRUE(view.valid());
+      EXPECT_EQ(view.metadata().master, i + 1);
+      values.emplace_back(view.value());
+    } else {
+      EXPECT_FALSE(view.valid());
+    }
+    return true;
+  });
+  ASSERT_EQ(values, (std::vector<std::string>{"valueA", "valueB", "valueC"}));
+
+  Metadata metadata;
+  ASSERT_TRUE(storage.GetMasterMetadata("C", metadata));
+  ASSERT_EQ(metadata.master, 3U);
+}
+
+TEST(FlatMemOnlyStorageTest, ReadWriteTest) {
+  FlatMemOnlyStorage storage;
+  Key key = "key1";
+  Value value = "value1";
+  Record record(value, 1);
+  storage.Write(key, record);
+
+  Record ret;
+  bool ok = storage.Read(key, ret);
+  ASSERT_TRUE(ok);
+  ASSERT_EQ(value, ret.to_string());
+
+  Metadata metadata;
+  ASSERT_TRUE(storage.GetMasterMetadata(key, metadata));
+  ASSERT_EQ(metadata.master, 1U);
+
+  RecordView view;
+  ASSERT_TRUE(storage.ReadView(key, view));
+  ASSERT_EQ(view.value(), "value1");
+
+  ASSERT_TRUE(storage.Delete(key));
+  ASSERT_FALSE(storage.Read(key, ret));
+  ASSERT_FALSE(storage.ReadView(key, view));
+}
+
+TEST(MemOnlyStorageTest, MasterIndexTest) {
+  MemOnlyStorage storage;
+  storage.Write("A", Record("valueA", 1, 0));
+  storage.Write("B", Record("valueB", 2, 0));
+
+  // Remastering a key updates its metadata in the index
+  storage.Write("A", Record("valueA", 2, 1));
+  Metadata metadata;
+  ASSERT_TRUE(storage.ReadMetadata("A", metadata));
+  ASSERT_EQ(metadata.master, 2U);
+  ASSERT_EQ(metadata.counter, 1U);
+
+  storage.Delete("B");
+  ASSERT_FALSE(storage.GetMasterMetadata("B", metadata));
+
+  std::vector<std::optional<Metadata>> results;
+  Key a = "A", b = "B", c = "C";
+  storage.GetMasterMetadata({&a, &b, &c}, results);
+  ASSERT_EQ(results.size(), 3U);
+  ASSERT_TRUE(results[0].has_value());
+  ASSERT_EQ(results[0]->master, 2U);
+  ASSERT_EQ(results[0]->counter, 1U);
+  ASSERT_FALSE(results[1].has_value());
+  ASSERT_FALSE(results[2].has_value());
+}
+
+TEST(FlatMemOnlyStorageTest, MasterIndexTest) {
+  FlatMemOnlyStorage storage;
+  Key a = "A", b = "B", c = "C";
+  std::vector<Record> records;
+  records.emplace_back("valueA", 1, 0);
+  records.emplace_back("valueB", 2, 0);
+  storage.MultiWrite({&a, &b}, records);
+
+  // Remastering a key updates its metadata in the index
+  storage.Write("A", Record("valueA", 2, 1));
+  storage.Delete("B");
+
+  std::vector<std::optional<Metadata>> results;
+  storage.GetMasterMetadata({&a, &b, &c}, results);
+  ASSERT_EQ(results.size(), 3U);
+  ASSERT_TRUE(results[0].has_value());
+  ASSERT_EQ(results[0]->master, 2U);
+  ASSERT_EQ(results[0]->counter, 1U);
+  ASSERT_FALSE(results[1].has_value());
+  ASSERT_FALSE(results[2].has_value());
+}
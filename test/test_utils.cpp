@@ -15,6 +15,7 @@
 #include "module/sequencer.h"
 #include "module/server.h"
 #include "proto/api.pb.h"
+#include "storage/log_storage.h"
 
 using std::make_shared;
 using std::to_string;
@@ -121,9 +122,21 @@ ValueEntry TxnValueEntry(const Transaction& txn, const std::string& key) {
 TestSlog::TestSlog(const ConfigurationPtr& config)
     : config_(config),
       sharder_(Sharder::MakeSharder(config)),
-      storage_(new MemOnlyStorage()),
       broker_(Broker::New(config, kTestModuleTimeout)),
       client_context_(1) {
+  if (config->storage_type() == internal::StorageType::LOG) {
+    auto dir = config->log_storage_dir() + "/" + to_string(config->local_machine_id());
+    auto log_storage =
+        make_shared<LogStorage>(dir, config->log_storage_group_commit_window(), config->log_storage_compaction_bytes());
+    // The workers wait for the writes to be durable before replying like in a real deployment
+    log_storage->SetSyncWrites(false);
+    storage_ = log_storage;
+    lookup_master_index_ = log_storage;
+  } else {
+    auto mem_only_storage = make_shared<MemOnlyStorage>();
+    storage_ = mem_only_storage;
+    lookup_master_index_ = mem_only_storage;
+  }
   client_context_.set(zmq::ctxopt::blocky, false);
   client_socket_ = zmq::socket_t(client_context_, ZMQ_DEALER);
 }
@@ -138,7 +151,7 @@ void TestSlog::AddServerAndClient() { server_ = MakeRunnerFor<Server>(broker_, n
 
 void TestSlog::AddForwarder() {
   metadata_initializer_ = std::make_shared<ConstantMetadataInitializer>(0);
-  forwarder_ = MakeRunnerFor<Forwarder>(broker_->context(), broker_->config(), storage_, metadata_initializer_, nullptr,
+  forwarder_ = MakeRunnerFor<Forwarder>(broker_->context(), broker_->config(), lookup_master_index_, metadata_initializer_, nullptr,
                                         kTestModuleTimeout);
 }
 
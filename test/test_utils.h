@@ -13,8 +13,10 @@
 #include "module/base/module.h"
 #include "module/scheduler_components/txn_holder.h"
 #include "proto/internal.pb.h"
+#include "storage/lookup_master_index.h"
 #include "storage/mem_only_storage.h"
 #include "storage/metadata_initializer.h"
+#include "storage/storage.h"
 
 using std::pair;
 using std::shared_ptr;
@@ -47,6 +49,7 @@ using ModuleRunnerPtr = unique_ptr<ModuleRunner>;
  */
 class TestSlog {
  public:
+  // With the LOG storage type, each machine keeps its log in a subdirectory of log_storage_dir named after its id
   TestSlog(const ConfigurationPtr& config);
   void Data(Key&& key, Record&& record);
   void AddServerAndClient();
@@ -75,7 +78,8 @@ class TestSlog {
  private:
   ConfigurationPtr config_;
   SharderPtr sharder_;
-  shared_ptr<MemOnlyStorage> storage_;
+  shared_ptr<Storage> storage_;
+  shared_ptr<LookupMasterIndex> lookup_master_index_;
   shared_ptr<MetadataInitializer> metadata_initializer_;
   shared_ptr<Broker> broker_;
   ModuleRunnerPtr server_;
@@ -332,6 +332,7 @@ class GenDataCommand(AdminCommand):
             f"--size-unit {args.size_unit} "
             f"--record-size {args.record_size} "
             f"--max-jobs {args.max_jobs} "
+            f"--shards {args.shards} "
         )
         containers = []
         for client, addr, *_ in self.remote_procs:
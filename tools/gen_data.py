@@ -67,6 +67,7 @@ class DataGenerator:
         record_size: int,
         max_jobs: int,
         partition_bytes: int,
+        shards: int = 1,
     ):
         self.data_dir = os.path.abspath(data_dir)
         self.prefix = prefix
@@ -79,6 +80,7 @@ class DataGenerator:
         self.record_size = record_size
         self.max_jobs = max_jobs
         self.partition_bytes = partition_bytes
+        self.shards = max(shards, 1)
 
     def partition_of_key(self, key: int) -> int:
         encoded = encode_key(key)
@@ -148,42 +150,51 @@ class DataGenerator:
         # generated so this seed only affects records
         np.random.seed(partition)
 
-        file_name = os.path.join(
-            self.data_dir,
-            self.prefix + str(partition) + FILE_EXTENSION
-        )
-        LOG.info("Generating data for %s", file_name)
-        mode = 'w' if as_text else 'wb'
-        part_file = open(file_name, mode)
-
-        # Write number of keys in this partition
-        if as_text:
-            part_file.write(str(len(keys)) + "\n")
+        # With multiple shards, the keys of a partition are spread round-robin
+        # into files named <partition>_<shard>.dat, which can be loaded in parallel
+        if self.shards == 1:
+            file_names = [self.prefix + str(partition) + FILE_EXTENSION]
         else:
-            part_file.write(_VarintBytes(len(keys)))
-
-        last_time = time.time()
-        last_index = 0
-        for i, key in enumerate(keys):
-            # Generate the datum for this key
-            datum = self.__gen_datum(key, as_text)
-            # Append the datum to file
-            part_file.write(datum)
-
-            now = time.time()
-            if now - last_time >= LOG_EVERY_SEC:
-                pct = (i) / len(keys) * 100
-                rate = (i - last_index) / LOG_EVERY_SEC
-                LOG.info(
-                    "Progress: %d/%d (%.1f%%). Rate: %d datums/s",
-                    i + 1,
-                    len(keys),
-                    pct,
-                    rate)
-                last_time = now
-                last_index = i
-
-        part_file.close()
+            file_names = [
+                self.prefix + str(partition) + "_" + str(shard) + FILE_EXTENSION
+                for shard in range(self.shards)
+            ]
+        file_names = [os.path.join(self.data_dir, f) for f in file_names]
+        shard_keys = [keys[shard::self.shards] for shard in range(self.shards)]
+
+        mode = 'w' if as_text else 'wb'
+        for file_name, keys in zip(file_names, shard_keys):
+            LOG.info("Generating data for %s", file_name)
+            part_file = open(file_name, mode)
+
+            # Write number of keys in this file
+            if as_text:
+                part_file.write(str(len(keys)) + "\n")
+            else:
+                part_file.write(_VarintBytes(len(keys)))
+
+            last_time = time.time()
+            last_index = 0
+            for i, key in enumerate(keys):
+                # Generate the datum for this key
+                datum = self.__gen_datum(key, as_text)
+                # Append the datum to file
+                part_file.write(datum)
+
+                now = time.time()
+                if now - last_time >= LOG_EVERY_SEC:
+                    pct = (i) / len(keys) * 100
+                    rate = (i - last_index) / LOG_EVERY_SEC
+                    LOG.info(
+                        "Progress: %d/%d (%.1f%%). Rate: %d datums/s",
+                        i + 1,
+                        len(keys),
+                        pct,
+                        rate)
+                    last_time = now
+                    last_index = i
+
+            part_file.close()
 
     def __gen_datum(self, key: int, as_text=False):
         encoded_key = encode_key(key)
@@ -249,6 +260,13 @@ def add_exported_gen_data_arguments(parser):
         help="Maximum number of jobs spawned to do work. For unlimited number "
              "of jobs, use 0."
     )
+    parser.add_argument(
+        "--shards",
+        type=int,
+        default=1,
+        help="Number of files to split the data of each partition into so "
+             "that they can be loaded in parallel."
+    )
     parser.add_argument(
         "--partition-bytes",
         type=int,
@@ -316,6 +334,7 @@ if __name__ == "__main__":
         args.record_size,
         args.max_jobs,
         partition_bytes,
+        args.shards,
     ).gen_data(
         partition=args.partition,
         as_text=args.as_text,